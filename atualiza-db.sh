@@ -38,6 +38,12 @@ declare -r concursos=concursos.dat    # arquivo plain/text dos dados de
                                       # concursos para preenchimento do db
 declare -r ganhadores=ganhadores.dat  # arquivo plain/text dos dados de
                                       # acertadores para preenchimento do db
+declare -r extensao=sqlite/resultados.so  # extensão de leitura direta do
+                                          # html, dispensando os arquivos
+                                          # plain/text se disponível
+declare -r virtuais=sqlite/dezenas.so     # extensão da tabela virtual
+                                          # "dezenas_sorteadas", necessária
+                                          # se aplicado sql/dezenas-virtuais.sql
 
 # link para o arquivo html remoto que contém a série histórica dos concursos
 declare -r url=http://loterias.caixa.gov.br/wps/portal/loterias/landing/megasena/\!ut/p/a1/04_Sj9CPykssy0xPLMnMz0vMAfGjzOLNDH0MPAzcDbwMPI0sDBxNXAOMwrzCjA0sjIEKIoEKnN0dPUzMfQwMDEwsjAw8XZw8XMwtfQ0MPM2I02-AAzgaENIfrh-FqsQ9wNnUwNHfxcnSwBgIDUyhCvA5EawAjxsKckMjDDI9FQE-F4ca/dl5/d5/L2dBISEvZ0FBIS9nQSEh/pw/Z7_HGK818G0K8DBC0QPVN93KQ10G1/res/id=historicoHTML/c=cacheLevelPage/=/
@@ -92,9 +98,35 @@ EOT
 fi
 
 # requisita o número do concurso mais recente registrado ou "zero" se db vazio
-m=$(sqlite3 $dbname 'select case when count(1) then concurso else 0 end from ( select concurso from concursos order by data_sorteio desc limit 1 )')
+m=$(sqlite3 $dbname 'select ifnull(max(concurso), 0) from concursos')
 
-if (( n > m )); then
+if (( n > m )) && [[ -e $extensao ]]; then
+
+  # Atualização incremental: somente as linhas dos concursos posteriores ao
+  # mais recente no db são convertidas, e devem formar sequência contínua a
+  # partir deste, caso contrário o db é preservado inalterado.
+  read k a b <<< $(sqlite3 -separator ' ' :memory: ".load $extensao" "select count(1), ifnull(min(concurso), 0), ifnull(max(concurso), 0) from resultados_html('$html') where concurso > $m")
+
+  if (( k == 0 || a != m+1 || b-a+1 != k )); then
+    printf '\nAviso: Sequência de concursos descontínua após o concurso %04d.\n\n' $m
+    exit 1
+  fi
+
+  printf '\n-- Preenchendo o db com %d concurso(s).\n' $k
+
+  # preenche as tabelas dos concursos e dos acertadores diretamente a partir
+  # do html numa única transação, em que os "triggers" atualizam as tabelas
+  # derivadas somente para os concursos inseridos
+  sqlite3 -bail $dbname <<EOT
+.load $extensao
+$([[ -e $virtuais ]] && echo .load $virtuais)
+BEGIN;
+INSERT INTO concursos SELECT * FROM resultados_html('$html') WHERE concurso > $m;
+INSERT INTO ganhadores SELECT * FROM ganhadores_html('$html') WHERE concurso > $m;
+COMMIT;
+EOT
+
+elif (( n > m )); then
 
   printf '\n-- Extraindo dados dos concursos.\n'
 
@@ -119,6 +151,7 @@ if (( n > m )); then
 
   # preenche as tabelas dos concursos e dos acertadores com os dados extraídos
   sqlite3 $dbname <<EOT
+$([[ -e $virtuais ]] && echo .load $virtuais)
 .import $concursos concursos
 .import $ganhadores ganhadores
 EOT
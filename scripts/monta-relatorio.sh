@@ -7,13 +7,16 @@ long_date () {
   TZ=$(date '+%Z') date -d $1 '+%d&nbsp;de&nbsp;%B&nbsp;de&nbsp;%Y'
 }
 
-currency () {
-  echo $1 | sed 'y/./,/;:×;s/\B[0-9]\{3\}\>/.&/;t×;s/,[0-9]$/&0/'
-}
-
-query_db () {
-  sqlite3 -init ./sqlite/onload megasena.sqlite "$@"
-}
+# usa o shell com extensões pré-registradas se disponível
+if [[ -x ./sqlite/megasena-sqlite ]]; then
+  query_db () {
+    ./sqlite/megasena-sqlite -separator ' ' megasena.sqlite "$@"
+  }
+else
+  query_db () {
+    sqlite3 -init ./sqlite/onload megasena.sqlite "$@"
+  }
+fi
 
 n=$(sqlite3 megasena.sqlite "SELECT count(concurso) FROM concursos")
 num_concurso=$n
@@ -0,0 +1,13 @@
+-- bateria de testes de aleatoriedade numa única passagem pelos concursos,
+-- requer a extensão "more-functions"; um teste por linha com estatística,
+-- graus de liberdade e p-valor
+SELECT
+  key AS teste,
+  json_extract(value, '$.estatistica') AS estatistica,
+  json_extract(value, '$.gl') AS gl,
+  printf('%.4f', json_extract(value, '$.p')) AS p
+FROM json_each((
+  SELECT bateria_aleatoriedade(dezenas ORDER BY concurso)
+  FROM dezenas_juntadas
+))
+WHERE key <> 'n';
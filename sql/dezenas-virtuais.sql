@@ -0,0 +1,21 @@
+-- Substitui a tabela "dezenas_sorteadas" e seu índice pela tabela virtual
+-- homônima da extensão "sqlite/dezenas.so", derivada de "concursos" sob
+-- demanda, e recria os triggers sem as escritas correspondentes.
+-- Após a execução, toda sessão que consulte "dezenas_sorteadas", as views
+-- "info_dezenas" e "acertos" ou insira concursos deve carregar a extensão.
+BEGIN TRANSACTION;
+DROP INDEX IF EXISTS ndx;
+DROP TABLE IF EXISTS dezenas_sorteadas;
+DROP TRIGGER IF EXISTS on_concursos_insert;
+CREATE TRIGGER on_concursos_insert AFTER INSERT ON concursos BEGIN
+  INSERT INTO dezenas_juntadas (concurso,dezenas) VALUES (new.concurso,(1 << new.dezena1-1) | (1 << new.dezena2-1) | (1 << new.dezena3-1) | (1 << new.dezena4-1) | (1 << new.dezena5-1) | (1 << new.dezena6-1));
+  INSERT INTO sugestoes SELECT new.concurso, dezena FROM info_dezenas WHERE frequencia < new.concurso/10.0 AND latencia >= 10;
+END;
+DROP TRIGGER IF EXISTS on_concursos_delete;
+CREATE TRIGGER on_concursos_delete AFTER DELETE ON concursos BEGIN
+  DELETE FROM dezenas_juntadas WHERE (concurso == old.concurso);
+  DELETE FROM sugestoes WHERE (concurso == old.concurso);
+  DELETE FROM ganhadores WHERE (concurso == old.concurso);
+END;
+COMMIT;
+VACUUM;
@@ -1,8 +1,7 @@
 -- tabela das quantidades de dezenas pares sorteadas em cada concurso
 CREATE TEMP TABLE paridades AS
-  SELECT concurso, 6 - SUM(dezena % 2) AS paridade
-  FROM dezenas_sorteadas
-  GROUP BY concurso;
+  SELECT concurso, perfil(dezenas, 'pares') AS paridade
+  FROM dezenas_juntadas;
 
 -- tabela das frequencias das paridades
 CREATE TEMP TABLE frequencias_paridades AS
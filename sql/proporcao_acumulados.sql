@@ -1,21 +1,21 @@
--- estimativa da proporção de concursos acumulados e desvio padrão
--- SELECT n, m, round(p*100,3), round(d*100,3)
--- FROM (
+-- estimativa da proporção de concursos acumulados e desvio padrão, com a
+-- variância do indicador "acumulado" das estatísticas descritivas, numa
+-- única leitura
+SELECT
+  n,
+  m,
+  p,                                    -- estimativa da proporção
+  power(v*(n-1)/n/n, .5) AS d           -- estimativa do desvio padrão da proporção
+FROM (
   SELECT
-    n,
-    m,
-    p,                          -- estimativa da proporção
-    power(p*(1-p)/n, .5) AS d   -- estimativa do desvio padrão da proporção
+    m, n,
+    cast(m AS real)/n AS p,             -- cálculo da estimativa da proporção
+    json_extract(e, '$.variancia') AS v -- variância amostral do indicador
   FROM (
     SELECT
-      m, n,
-      cast(m AS real)/n AS p    -- cálculo da estimativa da proporção
-    FROM (
-      SELECT
-        sum(acumulado) AS m,    -- número de concursos acumulados
-        count(concurso) AS n    -- número de concursos
-      FROM concursos
-    )
+      sum(acumulado) AS m,              -- número de concursos acumulados
+      count(concurso) AS n,             -- número de concursos
+      estatisticas(acumulado) AS e
+    FROM concursos
   )
--- )
-;
+);
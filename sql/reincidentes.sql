@@ -7,13 +7,7 @@
 -- cria tabela dos números de concursos que contém dezenas reincidentes
 -- separadas por conveniência na coluna dezenas
 CREATE TEMP TABLE IF NOT EXISTS reincidentes AS
-SELECT
-  concurso,
-  (SELECT dezenas FROM dezenas_juntadas WHERE concurso == concursos.concurso) & (SELECT dezenas FROM dezenas_juntadas WHERE concurso == concursos.concurso-1) AS dezenas
-FROM
-  concursos
-WHERE
-  (concurso >= 2) AND dezenas;
+SELECT concurso, mascara AS dezenas FROM reincidencias(1) WHERE quantidade > 0;
 
 -- conta número de registros na tabela dezenas reincidentes
 SELECT count(concurso) FROM reincidentes;
@@ -36,27 +30,10 @@ CREATE TEMP VIEW IF NOT EXISTS t2 AS SELECT concurso FROM reincidentes;
 
 -- teste de independência chi-quadrado p/variáveis "acumulado × reincidente"
 -- ao nível de significância 5%
-SELECT 'acumulado × reincidente', round(chi,3), (chi >= 3.841)
+SELECT
+  'acumulado × reincidente',
+  round(json_extract(chi, '$.estatistica'),3),
+  (json_extract(chi, '$.p') <= 0.05)
 FROM (
-  SELECT power(fa-ea,2)/ea + power(fb-eb,2)/eb + power(fc-ec,2)/ec + power(fd-ed,2)/ed AS chi
-  FROM (
-    SELECT
-      (fa+fc)*(fa+fb)/total AS ea,
-      (fb+fd)*(fa+fb)/total AS eb,
-      (fa+fc)*(fc+fd)/total AS ec,
-      (fb+fd)*(fc+fd)/total AS ed,
-      fa, fb, fc, fd
-    FROM (
-      SELECT count(*) AS fa FROM concursos WHERE acumulado and concurso in t2
-    ), (
-      SELECT count(*) AS fb FROM concursos WHERE acumulado and not concurso in t2
-    ), (
-      SELECT count(*) AS fc FROM concursos WHERE not acumulado and concurso in t2
-    ), (
-      SELECT count(*) AS fd FROM concursos WHERE not acumulado and not concurso in
-        t2
-    ), (
-      SELECT cast(count(*) AS real) AS total FROM concursos
-    )
-  )
+  SELECT chisq_contingencia(acumulado, concurso in t2) AS chi FROM concursos
 );
@@ -1,2 +1,4 @@
--- cálculo do número de concursos acumulados até o mais recente inclusive
-SELECT (SELECT MAX(concurso) FROM concursos) - (SELECT MAX(concurso) FROM concursos WHERE NOT acumulado);
+-- cálculo do número de concursos acumulados até o mais recente inclusive,
+-- i.e.; o comprimento da sequência em curso, via extensão "series"
+SELECT json_extract(histograma_sequencias(acumulado ORDER BY concurso), '$.aberta')
+FROM concursos;
@@ -0,0 +1,246 @@
+/*
+ * Auditoria das alocações de memória por linha das funções das extensões:
+ *
+ * Substitui o alocador do SQLite via SQLITE_CONFIG_MALLOC por outro que conta
+ * as chamadas a xMalloc e xRealloc, e avalia cada caso de teste, i.e.; uma
+ * expressão com uma das funções registradas, sobre uma tabela temporária de
+ * N linhas. A contagem de alocações por linha é a diferença entre a passagem
+ * com a expressão e a passagem de referência que apenas lê as colunas, ambas
+ * precedidas de uma passagem de aquecimento que descarta as alocações
+ * únicas do statement e dos buffers reaproveitados entre linhas.
+ *
+ * Funções registradas pelas extensões sem caso de teste são listadas ao
+ * final com contagem vazia. A contagem dispensa instrumentar as extensões,
+ * pois ambas compartilham o alocador do SQLite.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc alocacoes.c -Wall -O2 -lsqlite3 -o alocacoes
+ *
+ * Uso:
+ *
+ *    alocacoes [-n linhas] [-l extensão]...
+ *
+ *    -n  quantidade de linhas da tabela temporária (default 10000)
+ *    -l  extensão a carregar (default sqlite/more-functions.so)
+ *
+ * Resultados em CSV: função, expressão e alocações por linha.
+*/
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_EXTENSOES 8
+
+static sqlite3_mem_methods original;
+static sqlite3_int64 alocacoes = 0;
+
+static void *conta_malloc(int n)
+{
+  ++alocacoes;
+  return original.xMalloc(n);
+}
+
+static void *conta_realloc(void *p, int n)
+{
+  ++alocacoes;
+  return original.xRealloc(p, n);
+}
+
+/*
+ * Casos de teste sobre a tabela "t" com as colunas x (inteiro), d (real),
+ * s (texto), data (texto YYYY-MM-DD), ts (timestamp) e m (bitmask de 6
+ * números), agregações inclusive.
+*/
+static const struct caso_s {
+  const char *funcao;
+  const char *expressao;
+} CASOS[] = {
+  /* more-functions */
+  { "power",                 "power(d, 2)" },
+  { "product",               "product(1 + d / 1e9)" },
+  { "reverse",               "reverse(s)" },
+  { "zeropad",               "zeropad(x, 8)" },
+  { "currency",              "currency(d)" },
+  { "int2bin",               "int2bin(x)" },
+  { "bitstatus",             "bitstatus(x, 3)" },
+  { "group_bitor",           "group_bitor(x)" },
+  { "group_ndxbitor",        "group_ndxbitor(x % 60 + 1)" },
+  { "mask60",                "mask60(m)" },
+  { "quadrante",             "quadrante(x % 60 + 1)" },
+  { "jogo",                  "jogo()" },
+  { "bitset",                "bitset(x % 60 + 1, 7)" },
+  { "bitset_and",            "bitset_and(m, 4095)" },
+  { "bitset_or",             "bitset_or(m, 4095)" },
+  { "bitset_count",          "bitset_count(m)" },
+  { "bitset_common",         "bitset_common(m, 4095)" },
+  { "bitset_has",            "bitset_has(m, 3)" },
+  { "bitset_list",           "bitset_list(m)" },
+  { "perfil",                "perfil(m)" },
+  { "perfil",                "perfil(m, 'soma')" },
+  { "histograma_perfil",     "histograma_perfil(m)" },
+  { "bateria_aleatoriedade", "bateria_aleatoriedade(m)" },
+  { "chisq_contingencia",    "chisq_contingencia(x % 3, x % 5)" },
+  { "estatisticas",          "estatisticas(d)" },
+  { "rownum",                "rownum(0)" },
+  /* calendar */
+  { "chkdate",               "chkdate(data)" },
+  { "datepart",              "datepart(data, 'ano')" },
+  { "timestamp",             "timestamp(data)" },
+  { "datestr",               "datestr(ts)" },
+  { "swapformat",            "swapformat(data)" },
+  { "diffdates",             "diffdates(data, '2000-01-01')" },
+  { "weekday",               "weekday(data)" },
+  { "today",                 "today()" },
+  { "dateadd",               "dateadd(data, 7)" },
+  { "timezone",              "timezone()" },
+  /* regexp */
+  { "regexp",                "regexp('[0-9]+', s)" },
+  { "iregexp",               "iregexp('TEXTO', s)" },
+  { "regexp_match",          "regexp_match('[0-9]+', s)" },
+  { "regexp_match_count",    "regexp_match_count('[0-9]', s)" },
+  { "regexp_match_position", "regexp_match_position('[0-9]+', s, 0)" },
+  { "regexp_version",        "regexp_version()" },
+  { "utf8_upper",            "utf8_upper(s)" },
+  { "utf8_lower",            "utf8_lower(s)" },
+  /* crypt */
+  { "md5",                   "md5(s)" },
+  { "enc",                   "enc('chave', s)" },
+  { "dec",                   "dec('chave', enc('chave', s))" },
+  { "get_crypt",             "get_crypt()" },
+};
+
+/* alocações na passagem completa pelo statement, após o aquecimento */
+static sqlite3_int64 conta_passagem(sqlite3 *db, const char *sql)
+{
+  sqlite3_stmt *stmt;
+  sqlite3_int64 inicio;
+  int k;
+
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return -1;
+  for (k = 0; k < 2; ++k) {
+    inicio = alocacoes;
+    while (sqlite3_step(stmt) == SQLITE_ROW) ;
+    if (sqlite3_reset(stmt) != SQLITE_OK) {
+      sqlite3_finalize(stmt);
+      return -1;
+    }
+  }
+  inicio = alocacoes - inicio;
+  sqlite3_finalize(stmt);
+  return inicio;
+}
+
+static int registrada(sqlite3 *db, const char *funcao)
+{
+  sqlite3_stmt *stmt;
+  int r;
+
+  sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_function_list WHERE name == ?",
+    -1, &stmt, NULL);
+  sqlite3_bind_text(stmt, 1, funcao, -1, SQLITE_STATIC);
+  r = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_finalize(stmt);
+  return r;
+}
+
+int main(int argc, char **argv)
+{
+  const char *extensoes[MAX_EXTENSOES];
+  int num_extensoes = 0, linhas = 10000;
+  sqlite3_int64 referencia, n;
+  sqlite3_stmt *stmt;
+  sqlite3 *db;
+  sqlite3_mem_methods contador;
+  char *sql, *err;
+  int opt, j;
+
+  while ((opt = getopt(argc, argv, "n:l:")) != -1) {
+    switch (opt) {
+      case 'n':
+        linhas = atoi(optarg);
+        break;
+      case 'l':
+        if (num_extensoes < MAX_EXTENSOES) extensoes[num_extensoes++] = optarg;
+        break;
+      default:
+        fprintf(stderr, "uso: %s [-n linhas] [-l extensão]...\n", argv[0]);
+        return 1;
+    }
+  }
+  if (num_extensoes == 0) extensoes[num_extensoes++] = "sqlite/more-functions.so";
+  if (linhas < 1) linhas = 1;
+
+  sqlite3_config(SQLITE_CONFIG_GETMALLOC, &original);
+  contador = original;
+  contador.xMalloc = conta_malloc;
+  contador.xRealloc = conta_realloc;
+  if (sqlite3_config(SQLITE_CONFIG_MALLOC, &contador) != SQLITE_OK) {
+    fprintf(stderr, "alocador do SQLite não substituível\n");
+    return 1;
+  }
+
+  if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+    fprintf(stderr, "%s\n", sqlite3_errmsg(db));
+    return 1;
+  }
+  // funções nativas são as registradas antes da carga das extensões
+  sqlite3_exec(db, "CREATE TEMP TABLE nativas AS SELECT name FROM pragma_function_list",
+    NULL, NULL, NULL);
+  sqlite3_enable_load_extension(db, 1);
+  for (j = 0; j < num_extensoes; ++j) {
+    if (sqlite3_load_extension(db, extensoes[j], NULL, &err) != SQLITE_OK) {
+      fprintf(stderr, "%s: %s\n", extensoes[j], err);
+      sqlite3_free(err);
+    }
+  }
+
+  sql = sqlite3_mprintf("CREATE TEMP TABLE t AS" \
+    " WITH RECURSIVE g(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM g WHERE x < %d)" \
+    " SELECT x, x * 1.37 AS d, 'texto ' || x AS s," \
+    "  date('2000-01-01', '+' || (x %% 9000) || ' days') AS data," \
+    "  946684800 + 86400 * (x %% 9000) AS ts," \
+    "  63 << (x %% 54) AS m FROM g", linhas);
+  if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+    fprintf(stderr, "%s\n", err);
+    return 1;
+  }
+  sqlite3_free(sql);
+  // método criptográfico requerido por ENC e DEC, se disponíveis
+  sqlite3_exec(db, "SELECT set_crypt('usual')", NULL, NULL, NULL);
+
+  referencia = conta_passagem(db, "SELECT x, d, s, data, ts, m FROM t");
+  printf("funcao,expressao,alocacoes_por_linha\n");
+  for (j = 0; j < sizeof(CASOS) / sizeof(CASOS[0]); ++j) {
+    if (!registrada(db, CASOS[j].funcao)) continue;
+    sql = sqlite3_mprintf("SELECT %s, x, d, s, data, ts, m FROM t", CASOS[j].expressao);
+    n = conta_passagem(db, sql);
+    sqlite3_free(sql);
+    if (n < 0) {
+      printf("%s,\"%s\",erro: %s\n", CASOS[j].funcao, CASOS[j].expressao, sqlite3_errmsg(db));
+    } else {
+      printf("%s,\"%s\",%.2f\n", CASOS[j].funcao, CASOS[j].expressao,
+        (double) (n - referencia) / linhas);
+    }
+  }
+
+  // funções das extensões sem caso de teste
+  sqlite3_prepare_v2(db, "SELECT DISTINCT name FROM pragma_function_list" \
+    " WHERE name NOT IN nativas ORDER BY 1", -1, &stmt, NULL);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char *nome = (const char *) sqlite3_column_text(stmt, 0);
+    for (j = 0; j < sizeof(CASOS) / sizeof(CASOS[0]); ++j) {
+      if (strcmp(CASOS[j].funcao, nome) == 0) break;
+    }
+    if (j == sizeof(CASOS) / sizeof(CASOS[0])) printf("%s,,\n", nome);
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return 0;
+}
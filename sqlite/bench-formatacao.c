@@ -0,0 +1,202 @@
+/*
+ * Benchmark da formatação numérica das funções CURRENCY e ZEROPAD:
+ *
+ * Compara cada função da extensão com a implementação de referência via
+ * sprintf() da glibc, tal como anterior ao núcleo de formatação com os
+ * separadores do "locale" em cache, registrada com o sufixo "_ref", sobre
+ * uma tabela temporária de N valores pseudo-aleatórios de magnitudes de 1e-3
+ * a 1e15, positivos e negativos, inclusive empates de arredondamento como
+ * k/8, contando as divergências entre os resultados e medindo o menor tempo
+ * de R execuções de cada função.
+ *
+ * O "locale" é o do ambiente, p.ex.:
+ *
+ *    LC_ALL=pt_BR.UTF-8 sqlite/bench-formatacao
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc bench-formatacao.c -Wall -O2 -lsqlite3 -o bench-formatacao
+ *
+ * Uso:
+ *
+ *    bench-formatacao [-n linhas] [-r execuções] [-l extensão]
+ *
+ *    -n  quantidade de linhas da tabela temporária (default 200000)
+ *    -r  quantidade de execuções de cada função (default 5)
+ *    -l  extensão a carregar (default sqlite/more-functions.so)
+ *
+ * Resultados em CSV: função, tempos em milissegundos da referência e da
+ * extensão, razão entre estes e quantidade de divergências.
+*/
+#include <sqlite3.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static double agora_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+/* CURRENCY via sprintf("%'.2f") */
+static void currency_ref(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  char *z;
+  int n;
+
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+  z = sqlite3_malloc(64);
+  if (!z) {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  n = snprintf(z, 64, "%'.2f", sqlite3_value_double(argv[0]));
+  if (n >= 64) {
+    sqlite3_free(z);
+    sqlite3_result_error(ctx, "valor extenso", -1);
+    return;
+  }
+  sqlite3_result_text(ctx, z, n, sqlite3_free);
+}
+
+/* ZEROPAD via formato montado com sqlite3_mprintf e aplicado a seguir */
+static void zeropad_ref(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  char *fmt, *z;
+
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL
+    || sqlite3_value_type(argv[1]) == SQLITE_NULL) return;
+  fmt = sqlite3_mprintf("%%0%dlld", sqlite3_value_int(argv[1]));
+  z = sqlite3_mprintf(fmt, sqlite3_value_int64(argv[0]));
+  sqlite3_free(fmt);
+  sqlite3_result_text(ctx, z, -1, sqlite3_free);
+}
+
+static const struct caso_s {
+  const char *funcao;
+  const char *expressao;
+  const char *referencia;
+} CASOS[] = {
+  { "currency", "currency(d)",         "currency_ref(d)" },
+  { "currency", "currency(x)",         "currency_ref(x)" },
+  { "zeropad",  "zeropad(x % 1000000, 8)", "zeropad_ref(x % 1000000, 8)" },
+  { "zeropad",  "zeropad(x, 2)",       "zeropad_ref(x, 2)" },
+};
+
+/* menor tempo de "execucoes" passagens pela expressão sobre a tabela */
+static double mede(sqlite3 *db, const char *expressao, int execucoes)
+{
+  sqlite3_stmt *stmt;
+  double t, melhor = -1;
+  char *sql;
+  int k;
+
+  sql = sqlite3_mprintf("SELECT count(%s) FROM t", expressao);
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    fprintf(stderr, "%s: %s\n", expressao, sqlite3_errmsg(db));
+    sqlite3_free(sql);
+    return -1;
+  }
+  sqlite3_free(sql);
+  for (k = 0; k < execucoes; ++k) {
+    t = agora_ms();
+    while (sqlite3_step(stmt) == SQLITE_ROW) ;
+    t = agora_ms() - t;
+    sqlite3_reset(stmt);
+    if (melhor < 0 || t < melhor) melhor = t;
+  }
+  sqlite3_finalize(stmt);
+  return melhor;
+}
+
+static sqlite3_int64 divergencias(sqlite3 *db, const char *expressao, const char *referencia)
+{
+  sqlite3_stmt *stmt;
+  sqlite3_int64 n = -1;
+  char *sql;
+
+  sql = sqlite3_mprintf("SELECT count(*) FROM t WHERE %s IS NOT %s", expressao, referencia);
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK
+    && sqlite3_step(stmt) == SQLITE_ROW) n = sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  sqlite3_free(sql);
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  const char *extensao = "sqlite/more-functions.so";
+  int linhas = 200000, execucoes = 5, opt, j;
+  sqlite3 *db;
+  char *sql, *err;
+
+  while ((opt = getopt(argc, argv, "n:r:l:")) != -1) {
+    switch (opt) {
+      case 'n':
+        linhas = atoi(optarg);
+        break;
+      case 'r':
+        execucoes = atoi(optarg);
+        break;
+      case 'l':
+        extensao = optarg;
+        break;
+      default:
+        fprintf(stderr, "uso: %s [-n linhas] [-r execuções] [-l extensão]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (linhas < 1) linhas = 1;
+  if (execucoes < 1) execucoes = 1;
+
+  // "locale" das referências, o mesmo configurado pela extensão na carga
+  (void) setlocale(LC_ALL, "");
+
+  if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+    fprintf(stderr, "%s\n", sqlite3_errmsg(db));
+    return 1;
+  }
+  sqlite3_enable_load_extension(db, 1);
+  if (sqlite3_load_extension(db, extensao, NULL, &err) != SQLITE_OK) {
+    fprintf(stderr, "%s: %s\n", extensao, err);
+    return 1;
+  }
+  sqlite3_create_function(db, "currency_ref", 1, SQLITE_UTF8, NULL, currency_ref, NULL, NULL);
+  sqlite3_create_function(db, "zeropad_ref", 2, SQLITE_UTF8, NULL, zeropad_ref, NULL, NULL);
+
+  // magnitudes log-uniformes, sinais alternados e a cada 4 linhas múltiplos
+  // de 1/8 cujos centavos empatam no arredondamento
+  sql = sqlite3_mprintf("CREATE TEMP TABLE t AS" \
+    " WITH RECURSIVE g(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM g WHERE i < %d)" \
+    " SELECT abs(random() %% 1000000000000000) AS x," \
+    "  CASE WHEN i %% 4 == 0 THEN (random() %% 8000000) / 8.0" \
+    "   ELSE (1 - 2 * (i %% 2)) * (abs(random()) %% 1000000007) / 1000000007.0" \
+    "    * power(10, abs(random()) %% 19 - 3) END AS d FROM g", linhas);
+  if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+    fprintf(stderr, "%s\n", err);
+    return 1;
+  }
+  sqlite3_free(sql);
+
+  printf("funcao,expressao,referencia_ms,extensao_ms,razao,divergencias\n");
+  for (j = 0; j < sizeof(CASOS) / sizeof(CASOS[0]); ++j) {
+    double r = mede(db, CASOS[j].referencia, execucoes);
+    double e = mede(db, CASOS[j].expressao, execucoes);
+    // formatação do SQLite, independente do separador decimal do "locale"
+    sql = sqlite3_mprintf("%s,\"%s\",%.2f,%.2f,%.2f,%lld", CASOS[j].funcao,
+      CASOS[j].expressao, r, e, e > 0 ? r / e : 0,
+      divergencias(db, CASOS[j].expressao, CASOS[j].referencia));
+    puts(sql);
+    sqlite3_free(sql);
+  }
+  sqlite3_close(db);
+  return 0;
+}
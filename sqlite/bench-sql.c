@@ -0,0 +1,432 @@
+/*
+ * Benchmark dos scripts SQL do projeto:
+ *
+ * Executa cada script repetidas vezes sobre cópias do db com a série histórica
+ * replicada 1, 10 e 100 vezes (ou conforme opção), registrando o tempo de
+ * execução, a quantidade de linhas retornadas e os contadores de desempenho
+ * dos statements obtidos via sqlite3_stmt_status: passos da VM, passos em
+ * "full scan", ordenações e índices automáticos.
+ *
+ * Cada execução ocorre numa nova conexão, com as extensões carregadas e
+ * dentro de um SAVEPOINT desfeito ao final, de modo que tabelas, views e
+ * demais modificações criadas pelos scripts não interferem nas seguintes.
+ * Linhas iniciadas por "." (meta-comandos do shell) são ignoradas.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc bench-sql.c -Wall -O2 -lsqlite3 -o bench-sql
+ *
+ * Uso:
+ *
+ *    bench-sql [-n execuções] [-e escalas] [-l extensão]... [-j] \
+ *      megasena.sqlite script.sql...
+ *
+ *    -n  quantidade de execuções de cada script (default 5)
+ *    -e  lista de fatores de replicação separados por vírgula (default 1,10,100)
+ *    -l  extensão a carregar em cada conexão (default sqlite/more-functions.so)
+ *    -j  resultados em JSON ao invés de CSV
+ *
+ * Os dbs replicados são criados em /tmp e reaproveitados enquanto a assinatura
+ * do db original registrada na tabela "properties" da réplica, com caminho
+ * absoluto, dispositivo, inode, tamanho e data de modificação, coincidir com
+ * a do db informado; senão são remontados.
+*/
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MAX_EXTENSOES 8
+#define MAX_ESCALAS   8
+
+/* chave da assinatura do db original na tabela "properties" da réplica */
+#define CHAVE_ORIGEM "bench-sql.origem"
+
+typedef struct resultado_s
+{
+  double tempo_min;       /* em milissegundos */
+  double tempo_total;
+  sqlite3_int64 linhas;
+  sqlite3_int64 vm_steps;
+  sqlite3_int64 fullscan_steps;
+  sqlite3_int64 sorts;
+  sqlite3_int64 autoindex;
+  char *erro;
+}
+resultado_t;
+
+static const char *extensoes[MAX_EXTENSOES];
+static int num_extensoes = 0;
+
+static double agora_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+/* identificação do db: caminho absoluto, dispositivo, inode, tamanho e data */
+static char *assinatura(const char *path)
+{
+  struct stat st;
+  char *absoluto, *r;
+
+  if (stat(path, &st) || !(absoluto = realpath(path, NULL))) return NULL;
+  r = sqlite3_mprintf("%s:%llu:%llu:%lld:%lld.%09ld", absoluto,
+    (unsigned long long) st.st_dev, (unsigned long long) st.st_ino,
+    (long long) st.st_size, (long long) st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+  free(absoluto);
+  return r;
+}
+
+/* assinatura do db original registrada na réplica, ou NULL se inexistente */
+static char *assinatura_replica(const char *destino)
+{
+  sqlite3 *db;
+  sqlite3_stmt *stmt;
+  char *r = NULL;
+
+  if (sqlite3_open_v2(destino, &db, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK
+      && sqlite3_prepare_v2(db, "SELECT value FROM properties WHERE key == ?",
+           -1, &stmt, NULL) == SQLITE_OK) {
+    sqlite3_bind_text(stmt, 1, CHAVE_ORIGEM, -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      r = sqlite3_mprintf("%s", sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+  }
+  sqlite3_close(db);
+  return r;
+}
+
+/* registra na réplica a assinatura do db original, no esquema de "crypt" */
+static int registra_origem(const char *destino, const char *origem)
+{
+  sqlite3 *db;
+  char *sql;
+  int rc;
+
+  if (sqlite3_open_v2(destino, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+    sqlite3_close(db);
+    return 0;
+  }
+  sql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS properties" \
+    "(key TEXT NOT NULL UNIQUE ON CONFLICT IGNORE, value TEXT NOT NULL);" \
+    " INSERT OR REPLACE INTO properties VALUES (%Q, %Q)", CHAVE_ORIGEM, origem);
+  rc = sqlite3_exec(db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  sqlite3_close(db);
+  return rc == SQLITE_OK;
+}
+
+/*
+ * Lê o conteúdo do script, substituindo por espaços as linhas iniciadas por
+ * "." que são meta-comandos do shell do SQLite.
+*/
+static char *le_script(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  char *z, *p;
+  long n;
+  int inicio_de_linha = 1;
+
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  n = ftell(f);
+  rewind(f);
+  z = malloc(n + 1);
+  if (z && fread(z, 1, n, f) == (size_t) n) {
+    z[n] = 0;
+    for (p = z; *p; ++p) {
+      if (inicio_de_linha && *p == '.') {
+        while (*p && *p != '\n') *p++ = ' ';
+        if (!*p) break;
+      }
+      inicio_de_linha = (*p == '\n');
+    }
+  } else {
+    free(z);
+    z = NULL;
+  }
+  fclose(f);
+  return z;
+}
+
+static sqlite3 *abre_db(const char *path)
+{
+  sqlite3 *db;
+  char *err;
+  int j;
+
+  if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+    fprintf(stderr, "%s: %s\n", path, sqlite3_errmsg(db));
+    sqlite3_close(db);
+    return NULL;
+  }
+  sqlite3_enable_load_extension(db, 1);
+  for (j = 0; j < num_extensoes; ++j) {
+    if (sqlite3_load_extension(db, extensoes[j], NULL, &err) != SQLITE_OK) {
+      fprintf(stderr, "%s: %s\n", extensoes[j], err);
+      sqlite3_free(err);
+    }
+  }
+  return db;
+}
+
+/*
+ * Monta cópia do db com a série histórica replicada "fator" vezes, tal que os
+ * números dos concursos e datas dos sorteios das réplicas são deslocados além
+ * dos originais, preservando o esquema; os triggers são suspensos durante a
+ * replicação pois as tabelas derivadas também são replicadas diretamente.
+*/
+static int monta_escala(const char *origem, int fator, const char *destino)
+{
+  sqlite3 *db;
+  sqlite3_stmt *stmt, *cols;
+  sqlite3_int64 m;
+  char *sql, **triggers = NULL;
+  int dias, n = 0, j, k, rc;
+
+  unlink(destino);
+  if (sqlite3_open(origem, &db) != SQLITE_OK) return 0;
+  sql = sqlite3_mprintf("VACUUM INTO %Q", destino);
+  rc = sqlite3_exec(db, sql, NULL, NULL, NULL);
+  sqlite3_free(sql);
+  sqlite3_close(db);
+  if (rc != SQLITE_OK || fator == 1) return rc == SQLITE_OK;
+
+  sqlite3_open(destino, &db);
+  sqlite3_prepare_v2(db, "SELECT max(concurso), CAST(julianday(max(data_sorteio))" \
+    " - julianday(min(data_sorteio)) AS INTEGER) + 3 FROM concursos", -1, &stmt, NULL);
+  sqlite3_step(stmt);
+  m = sqlite3_column_int64(stmt, 0);
+  dias = sqlite3_column_int(stmt, 1);
+  sqlite3_finalize(stmt);
+
+  // preserva e elimina os triggers
+  sqlite3_prepare_v2(db, "SELECT name, sql FROM sqlite_master WHERE type == 'trigger'",
+    -1, &stmt, NULL);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    triggers = realloc(triggers, (n + 1) * sizeof(char *));
+    triggers[n++] = sqlite3_mprintf("%s", sqlite3_column_text(stmt, 1));
+    sql = sqlite3_mprintf("DROP TRIGGER %Q", sqlite3_column_text(stmt, 0));
+    sqlite3_exec(db, sql, NULL, NULL, NULL);
+    sqlite3_free(sql);
+  }
+  sqlite3_finalize(stmt);
+
+  sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+  // replica todas as tabelas que tenham a coluna "concurso"
+  sqlite3_prepare_v2(db, "SELECT m.name FROM sqlite_master AS m, pragma_table_info(m.name)" \
+    " AS p WHERE m.type == 'table' AND p.name == 'concurso'", -1, &stmt, NULL);
+  sqlite3_prepare_v2(db, "SELECT name FROM pragma_table_info(?)", -1, &cols, NULL);
+  rc = SQLITE_OK;
+  while (rc == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+    const char *tabela = (const char *) sqlite3_column_text(stmt, 0);
+    for (k = 1; rc == SQLITE_OK && k < fator; ++k) {
+      char *lista = NULL, *expr = NULL;
+      sqlite3_bind_text(cols, 1, tabela, -1, SQLITE_STATIC);
+      while (sqlite3_step(cols) == SQLITE_ROW) {
+        const char *c = (const char *) sqlite3_column_text(cols, 0);
+        char *e;
+        if (sqlite3_stricmp(c, "concurso") == 0) {
+          e = sqlite3_mprintf("concurso + %lld", k * m);
+        } else if (sqlite3_stricmp(c, "data_sorteio") == 0) {
+          e = sqlite3_mprintf("date(data_sorteio, '+%d days')", k * dias);
+        } else {
+          e = sqlite3_mprintf("\"%w\"", c);
+        }
+        lista = lista ? sqlite3_mprintf("%z, \"%w\"", lista, c)
+                      : sqlite3_mprintf("\"%w\"", c);
+        expr = expr ? sqlite3_mprintf("%z, %z", expr, e) : e;
+      }
+      sqlite3_reset(cols);
+      sql = sqlite3_mprintf("INSERT INTO \"%w\" (%s) SELECT %s FROM \"%w\"" \
+        " WHERE concurso <= %lld", tabela, lista, expr, tabela, m);
+      rc = sqlite3_exec(db, sql, NULL, NULL, NULL);
+      if (rc != SQLITE_OK) fprintf(stderr, "%s: %s\n", tabela, sqlite3_errmsg(db));
+      sqlite3_free(sql);
+      sqlite3_free(lista);
+      sqlite3_free(expr);
+    }
+  }
+  sqlite3_finalize(cols);
+  sqlite3_finalize(stmt);
+
+  // restaura os triggers
+  for (j = 0; j < n; ++j) {
+    if (rc == SQLITE_OK) rc = sqlite3_exec(db, triggers[j], NULL, NULL, NULL);
+    sqlite3_free(triggers[j]);
+  }
+  free(triggers);
+  sqlite3_exec(db, rc == SQLITE_OK ? "COMMIT" : "ROLLBACK", NULL, NULL, NULL);
+  sqlite3_close(db);
+
+  return rc == SQLITE_OK;
+}
+
+/*
+ * Executa uma vez todos os statements do script numa nova conexão,
+ * acumulando as medidas no resultado.
+*/
+static void executa(const char *dbpath, const char *script, resultado_t *r)
+{
+  sqlite3 *db = abre_db(dbpath);
+  sqlite3_stmt *stmt;
+  const char *tail = script;
+  sqlite3_int64 linhas = 0, vm = 0, fs = 0, so = 0, ai = 0;
+  double t;
+  int rc = SQLITE_OK;
+
+  if (!db) {
+    r->erro = sqlite3_mprintf("db inacessível");
+    return;
+  }
+  sqlite3_exec(db, "SAVEPOINT bench", NULL, NULL, NULL);
+
+  t = agora_ms();
+  while (rc == SQLITE_OK && *tail) {
+    rc = sqlite3_prepare_v2(db, tail, -1, &stmt, &tail);
+    if (rc != SQLITE_OK || !stmt) break;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) ++linhas;
+    if (rc == SQLITE_DONE) rc = SQLITE_OK;
+    vm += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 0);
+    fs += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 0);
+    so += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 0);
+    ai += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 0);
+    sqlite3_finalize(stmt);
+  }
+  t = agora_ms() - t;
+
+  if (rc != SQLITE_OK && !r->erro) r->erro = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+
+  sqlite3_exec(db, "ROLLBACK TO bench; RELEASE bench", NULL, NULL, NULL);
+  sqlite3_close(db);
+
+  if (r->tempo_total == 0 || t < r->tempo_min) r->tempo_min = t;
+  r->tempo_total += t;
+  r->linhas = linhas;
+  r->vm_steps = vm;
+  r->fullscan_steps = fs;
+  r->sorts = so;
+  r->autoindex = ai;
+}
+
+static void imprime(int json, int primeiro, int escala, const char *script,
+  int execucoes, const resultado_t *r)
+{
+  if (json) {
+    printf("%s\n  {\"escala\": %d, \"script\": \"%s\", \"execucoes\": %d,"
+      " \"tempo_min_ms\": %.3f, \"tempo_medio_ms\": %.3f, \"linhas\": %lld,"
+      " \"vm_steps\": %lld, \"fullscan_steps\": %lld, \"sorts\": %lld,"
+      " \"autoindex\": %lld, \"erro\": ", primeiro ? "[" : ",", escala, script,
+      execucoes, r->tempo_min, r->tempo_total / execucoes, r->linhas,
+      r->vm_steps, r->fullscan_steps, r->sorts, r->autoindex);
+    if (r->erro) {
+      const char *p;
+      putchar('"');
+      for (p = r->erro; *p; ++p) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        putchar(*p);
+      }
+      printf("\"}");
+    } else {
+      printf("null}");
+    }
+  } else {
+    if (primeiro) {
+      puts("escala,script,execucoes,tempo_min_ms,tempo_medio_ms,linhas," \
+        "vm_steps,fullscan_steps,sorts,autoindex,erro");
+    }
+    printf("%d,%s,%d,%.3f,%.3f,%lld,%lld,%lld,%lld,%lld,\"%s\"\n", escala,
+      script, execucoes, r->tempo_min, r->tempo_total / execucoes, r->linhas,
+      r->vm_steps, r->fullscan_steps, r->sorts, r->autoindex,
+      r->erro ? r->erro : "");
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  int escalas[MAX_ESCALAS] = { 1, 10, 100 }, num_escalas = 3;
+  int execucoes = 5, json = 0, primeiro = 1;
+  const char *origem;
+  char destino[4096], *identificacao, *p;
+  int opt, e, j, k;
+
+  while ((opt = getopt(argc, argv, "n:e:l:j")) != -1) {
+    switch (opt) {
+      case 'n':
+        execucoes = atoi(optarg);
+        break;
+      case 'e':
+        for (num_escalas = 0, p = strtok(optarg, ","); p && num_escalas < MAX_ESCALAS;
+             p = strtok(NULL, ",")) escalas[num_escalas++] = atoi(p);
+        break;
+      case 'l':
+        if (num_extensoes < MAX_EXTENSOES) extensoes[num_extensoes++] = optarg;
+        break;
+      case 'j':
+        json = 1;
+        break;
+      default:
+        fprintf(stderr, "uso: %s [-n execuções] [-e escalas] [-l extensão]..." \
+          " [-j] megasena.sqlite script.sql...\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind + 2 > argc || execucoes < 1) {
+    fprintf(stderr, "uso: %s [-n execuções] [-e escalas] [-l extensão]..." \
+      " [-j] megasena.sqlite script.sql...\n", argv[0]);
+    return 1;
+  }
+  if (num_extensoes == 0) extensoes[num_extensoes++] = "sqlite/more-functions.so";
+  origem = argv[optind++];
+
+  if (!(identificacao = assinatura(origem))) {
+    fprintf(stderr, "%s: inacessível\n", origem);
+    return 1;
+  }
+
+  for (e = 0; e < num_escalas; ++e) {
+    char *replica;
+    snprintf(destino, sizeof(destino), "/tmp/megasena-%dx.sqlite", escalas[e]);
+    if (escalas[e] < 1) continue;
+    replica = assinatura_replica(destino);
+    if (!replica || strcmp(replica, identificacao) != 0) {
+      fprintf(stderr, "-- montando %s\n", destino);
+      if (!monta_escala(origem, escalas[e], destino)
+          || !registra_origem(destino, identificacao)) {
+        fprintf(stderr, "%s: falha na montagem\n", destino);
+        sqlite3_free(replica);
+        continue;
+      }
+    }
+    sqlite3_free(replica);
+    for (j = optind; j < argc; ++j) {
+      resultado_t r;
+      char *script = le_script(argv[j]);
+      if (!script) {
+        fprintf(stderr, "%s: ilegível\n", argv[j]);
+        continue;
+      }
+      memset(&r, 0, sizeof(r));
+      for (k = 0; k < execucoes; ++k) executa(destino, script, &r);
+      imprime(json, primeiro, escalas[e], argv[j], execucoes, &r);
+      primeiro = 0;
+      sqlite3_free(r.erro);
+      free(script);
+    }
+  }
+  if (json && !primeiro) puts("\n]");
+  sqlite3_free(identificacao);
+
+  return 0;
+}
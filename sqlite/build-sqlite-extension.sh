@@ -19,7 +19,7 @@ check() {
 
 if check 'sqlite3'
 then
-  for arquivo in 'more-functions.c' 'calendar.c'; do
+  for arquivo in 'more-functions.c' 'calendar.c' 'resultados.c' 'dezenas.c' 'combinacoes.c' 'series.c' 'lentas.c'; do
     echo "compilando \"$arquivo\""
     gcc $arquivo -fPIC -shared -lm -o ${arquivo%.*}.so
   done
@@ -23,10 +23,14 @@ SQLITE_EXTENSION_INIT1
 #define sqlite3_stricmp(a, b) sqlite3_strnicmp((a), (b), strlen(a))
 #endif
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#define EXT_STATS_EXTENSAO "calendar"
+#include "ext-stats.h"
+
 #define IS_DIGIT(c) (((c) >= '0') && ((c) <= '9'))
 
 #define IS_SEPARATOR(c) ((c) == '-')
@@ -211,20 +215,29 @@ static void timestamp(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   }
 }
 
+/* comprimento das strings de data em qualquer dos formatos */
+#define DATE_LENGTH 10
+
+/* tamanho dos buffers de formatação, folgado para qualquer "struct tm" */
+#define DATE_BUFFER 48
+
 /*
- * Retorna string de data no formato DD-MM-YYYY ou YYYY-MM-DD, sendo o primeiro
- * argumento o seu número de segundos na era Unix, seguido de valor ZERO-UM que
- * indica o formato desejado.
+ * Formata no buffer de DATE_BUFFER bytes a string de data no formato
+ * DD-MM-YYYY ou YYYY-MM-DD, sendo o primeiro argumento o seu número de
+ * segundos na era Unix, seguido de valor ZERO-UM que indica o formato
+ * desejado, dispensando alocações por chamada.
 */
-static char *nixtime_to_datestring(const time_t seconds, const int as_isodate)
+static char *nixtime_to_datestring(const time_t seconds, const int as_isodate, char *buffer)
 {
   struct tm *broken_time = localtime(&seconds);
   if (as_isodate) {
-    return sqlite3_mprintf("%04d-%02d-%02d", broken_time->tm_year+1900, \
-             broken_time->tm_mon+1, broken_time->tm_mday);
+    snprintf(buffer, DATE_BUFFER, "%04d-%02d-%02d", broken_time->tm_year+1900, \
+      broken_time->tm_mon+1, broken_time->tm_mday);
+  } else {
+    snprintf(buffer, DATE_BUFFER, "%02d-%02d-%04d", broken_time->tm_mday, \
+      broken_time->tm_mon+1, broken_time->tm_year+1900);
   }
-  return sqlite3_mprintf("%02d-%02d-%04d", broken_time->tm_mday, \
-           broken_time->tm_mon+1, broken_time->tm_year+1900);
+  return buffer;
 }
 
 #define TIMESTAMP_0000_01_01_00_00_BRT -62167208012L
@@ -256,7 +269,7 @@ static int chk_timestamp(sqlite3_context *ctx, const time_t seconds)
 static void datestr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
   time_t seconds;
-  char *date;
+  char date[DATE_BUFFER];
   int as_isodate = YYYY_MM_DD;
 
   if (argc < 1 || argc > 2) {
@@ -277,8 +290,8 @@ static void datestr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   }
   seconds = (time_t) sqlite3_value_int64(argv[0]);
   if (chk_timestamp(ctx, seconds)) {
-    date = nixtime_to_datestring(seconds, as_isodate);
-    sqlite3_result_text(ctx, date, -1, sqlite3_free);
+    nixtime_to_datestring(seconds, as_isodate, date);
+    sqlite3_result_text(ctx, date, DATE_LENGTH, SQLITE_TRANSIENT);
   }
 }
 
@@ -348,7 +361,7 @@ static void days_between_dates(ctx, argc, argv)
 /*
  * Retorna o nome abreviado do dia da semana de data expressa com seu número
  * inteiro de segundos decorridos na era Unix ou representada como string no
- * formato YYYY-MM-DD ou DD-MM-YYYY.
+ * formato YYYY-MM-DD ou DD-MM-YYYY, ou NULL se o argumento for NULL.
 */
 static void weekday(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
@@ -373,8 +386,13 @@ static void weekday(sqlite3_context *ctx, int argc, sqlite3_value **argv)
       sqlite3_result_error(ctx, "argumento não contém data valida", -1);
       return ;
     }
+  } else if (SQLITE_NULL == sqlite3_value_type(argv[0])) {
+    return ;
+  } else {
+    sqlite3_result_error(ctx, "argumento deve ser inteiro ou data", -1);
+    return ;
   }
-  sqlite3_result_text(ctx, WEEKDAY[wday], -1, SQLITE_TRANSIENT);
+  sqlite3_result_text(ctx, WEEKDAY[wday], -1, SQLITE_STATIC);
 }
 
 /*
@@ -384,7 +402,7 @@ static void weekday(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *date;
+  char date[DATE_BUFFER];
   time_t seconds;
   int as_isodate = YYYY_MM_DD;
 
@@ -402,8 +420,8 @@ static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     }
   }
   seconds = time(NULL);
-  date = nixtime_to_datestring(seconds, as_isodate);
-  sqlite3_result_text(ctx, date, -1, sqlite3_free);
+  nixtime_to_datestring(seconds, as_isodate, date);
+  sqlite3_result_text(ctx, date, DATE_LENGTH, SQLITE_TRANSIENT);
 }
 
 /*
@@ -413,7 +431,7 @@ static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void dateadd(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *date;
+  char *date, buffer[DATE_BUFFER];
   long int seconds;
   int ndays, x = YYYY_MM_DD;
 
@@ -439,8 +457,8 @@ static void dateadd(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   ndays = sqlite3_value_int(argv[1]);
   seconds += ndays * 86400L;
   if (chk_timestamp(ctx, seconds)) {
-    date = nixtime_to_datestring((time_t) seconds, x);
-    sqlite3_result_text(ctx, date, -1, sqlite3_free);
+    nixtime_to_datestring((time_t) seconds, x, buffer);
+    sqlite3_result_text(ctx, buffer, DATE_LENGTH, SQLITE_TRANSIENT);
   }
 }
 
@@ -456,12 +474,13 @@ static void timezone_info(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   time_t seconds = time(NULL);
   struct tm *t = localtime(&seconds);
   int h = FAST_ABS(timezone);
-  char *r = sqlite3_mprintf("%c%02d%02d %s", (timezone > 0 ? '-' : '+'),
-         (h / 3600 - t->tm_isdst), (h % 3600 / 60), tzname[t->tm_isdst]);
-  sqlite3_result_text(ctx, r, -1, sqlite3_free);
+  char r[64];
+  snprintf(r, sizeof(r), "%c%02d%02d %s", (timezone > 0 ? '-' : '+'),
+    (h / 3600 - t->tm_isdst), (h % 3600 / 60), tzname[t->tm_isdst]);
+  sqlite3_result_text(ctx, r, -1, SQLITE_TRANSIENT);
 }
 
-int sqlite3_extension_init(db, err, api)
+int sqlite3_calendar_init(db, err, api)
   sqlite3 *db; char **err; const sqlite3_api_routines *api;
 {
   SQLITE_EXTENSION_INIT2(api)
@@ -477,5 +496,5 @@ int sqlite3_extension_init(db, err, api)
   sqlite3_create_function(db, "DATEADD", 2, SQLITE_UTF8, NULL, dateadd, NULL, NULL);
   sqlite3_create_function(db, "TIMEZONE", 0, SQLITE_UTF8, NULL, timezone_info, NULL, NULL);
 
-  return 0;
+  return ext_stats_inicia(db);
 }
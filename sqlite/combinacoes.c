@@ -0,0 +1,1652 @@
+/*
+ * Identificação compacta das combinações de números da Mega-Sena e índice
+ * persistente das combinações sorteadas:
+ *
+ *    COMB_RANK, COMB_UNRANK, COMB_BITMAP_MONTA, COMB_BITMAP_ABRE,
+ *    COMB_SORTEADA, COMB_NAO_SORTEADA, DESDOBRAMENTO
+ *
+ * e "table-valued function" da varredura de todo o espaço de combinações:
+ *
+ *    COBERTURA (tipo, acertos, combinacoes, rank, dezenas, quadras, quinas,
+ *               top HIDDEN, threads HIDDEN)
+ *
+ * COMB_RANK(mask) é a posição em ordem colexicográfica, a partir de zero, da
+ * combinação de até 6 números no bitmask do argumento, tal como em
+ * "dezenas_juntadas", i.e.; a soma de C(n_i - 1, i) para os números n_1 <
+ * n_2 < ... < n_k da combinação, e COMB_UNRANK(rank, k) é sua inversa para
+ * combinações de k números, por padrão 6. As combinações de 6 números têm
+ * posições de 0 a C(60,6)-1 = 50.063.859.
+ *
+ * COMB_BITMAP_MONTA(arquivo) grava o bitmap das combinações sorteadas em
+ * "dezenas_juntadas", com o bit de cada posição R no bit R%8 do byte R/8,
+ * totalizando 6.257.983 bytes sem cabeçalho, diretamente mapeável em memória
+ * por outras ferramentas, e o mapeia para a conexão, retornando a quantidade
+ * de combinações distintas sorteadas. COMB_BITMAP_ABRE(arquivo) apenas mapeia
+ * o arquivo previamente gravado. Ambas são vedadas em views e triggers.
+ *
+ * Com o bitmap mapeado, COMB_SORTEADA(mask) indica se a combinação já foi
+ * sorteada e COMB_NAO_SORTEADA(rank) retorna a posição mais próxima da
+ * informada, a partir dela, de combinação jamais sorteada, em tempo limitado
+ * via resumo em memória de um bit por palavra de 64 bits do bitmap e de um
+ * bit por palavra desse resumo, montado no mapeamento:
+ *
+ *    SELECT comb_bitmap_monta('combinacoes.bitmap');
+ *
+ *    SELECT comb_sorteada(dezenas) FROM dezenas_juntadas;
+ *
+ *    SELECT comb_unrank(comb_nao_sorteada(comb_rank(mask)));
+ *
+ * COBERTURA confronta cada uma das 50.063.860 apostas de 6 números possíveis
+ * com toda a série histórica, obtendo o maior número de acertos em algum
+ * concurso e as quantidades de quadras e quinas que teria obtido. O espaço é
+ * particionado por posição colexicográfica entre "threads" execuções
+ * paralelas, por padrão uma por processador, cada uma percorrendo sua
+ * partição em ordem e contando os acertos via "popcount" sobre a série
+ * compactada em bitmasks, que cabe no cache L1, uma única vez para cada
+ * grupo de combinações que diferem apenas no menor número.
+ *
+ * O resultado agregado consiste nas 7 linhas do tipo 'histograma', com a
+ * quantidade de combinações cujo maior número de acertos é "acertos" e os
+ * totais de quadras e quinas dessas combinações, seguidas das "top" linhas,
+ * por padrão 10, do tipo 'top' com as combinações de melhor desempenho, por
+ * ordem de acertos, quinas, quadras e posição:
+ *
+ *    SELECT acertos, combinacoes FROM cobertura WHERE tipo = 'histograma';
+ *
+ *    SELECT rank, dezenas, acertos, quinas, quadras FROM cobertura(100)
+ *      WHERE tipo = 'top';
+ *
+ * DESDOBRAMENTO(candidatos, garantia, acertos[, segundos[, threads]]) busca
+ * um conjunto mínimo de apostas de 6 números dentre os candidatos, de 6 a 30
+ * números como bitmask ou texto tal como a saída de "scripts/sugestao.sh",
+ * que garanta ao menos "garantia" acertos se "acertos" dos candidatos forem
+ * sorteados, com garantia ≤ acertos ≤ 6, i.e.; um "covering design"
+ * C(v,6,garantia) generalizado. A escolha gulosa inicial é reduzida aposta a
+ * aposta por busca local com recozimento simulado em "threads" execuções
+ * paralelas, por padrão uma por processador, durante "segundos", por padrão
+ * 2. O resultado em JSON contém as apostas como bitmasks e a prova da
+ * cobertura obtida por verificação exaustiva de todos os subconjuntos:
+ *
+ *    SELECT value FROM json_each(desdobramento('1 5 12 23 31 37 41 44 50 58',
+ *      4, 4), '$.apostas');
+ *
+ * A varredura e a busca podem ser interrompidas via sqlite3_interrupt(),
+ * i.e.; Ctrl-C no shell, a partir da versão 3.41 do SQLite.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc combinacoes.c -Wall -O2 -fPIC -shared -pthread -lm -o combinacoes.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/combinacoes.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/combinacoes.so");
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
+#include <math.h>
+
+#ifndef SQLITE_DETERMINISTIC
+#define SQLITE_DETERMINISTIC 0
+#endif
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+#ifndef SQLITE_DIRECTONLY
+#define SQLITE_DIRECTONLY 0
+#endif
+
+/* quantidade de números da Mega-Sena */
+#define N_DEZENAS 60
+
+/* quantidade de dezenas sorteadas por concurso */
+#define N_SORTEADAS 6
+
+/* quantidade de combinações de 6 números, i.e.; C(60,6) */
+#define N_COMBINACOES 50063860
+
+/*
+ * "popcount" nativo na varredura do espaço e nos desdobramentos sem exigir
+ * flags de compilação: cada um tem o corpo sempre expandido em duas entradas,
+ * genérica e com a instrução, escolhida em tempo de execução conforme o
+ * processador.
+*/
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POPCNT __attribute__((target("popcnt")))
+#define POPCNT_NATIVO() (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"))
+#else
+#define POPCNT
+#define POPCNT_NATIVO() 0
+#endif
+
+#define SEMPRE_INLINE inline __attribute__((always_inline))
+
+/* tamanho em bytes do bitmap das combinações */
+#define BITMAP_SIZE ((N_COMBINACOES + 7) / 8)
+
+/* quantidades de palavras de 64 bits do bitmap e dos níveis do seu resumo */
+#define PALAVRAS ((N_COMBINACOES + 63) / 64)
+#define RESUMO1  ((PALAVRAS + 63) / 64)
+#define RESUMO2  ((RESUMO1 + 63) / 64)
+
+/* coeficientes binomiais C(n,k) para n de 0 a 60 e k de 0 a 6 */
+static const sqlite3_int64 BINOMIAL[N_DEZENAS+1][N_SORTEADAS+1] = {
+  { 1, 0, 0, 0, 0, 0, 0 },
+  { 1, 1, 0, 0, 0, 0, 0 },
+  { 1, 2, 1, 0, 0, 0, 0 },
+  { 1, 3, 3, 1, 0, 0, 0 },
+  { 1, 4, 6, 4, 1, 0, 0 },
+  { 1, 5, 10, 10, 5, 1, 0 },
+  { 1, 6, 15, 20, 15, 6, 1 },
+  { 1, 7, 21, 35, 35, 21, 7 },
+  { 1, 8, 28, 56, 70, 56, 28 },
+  { 1, 9, 36, 84, 126, 126, 84 },
+  { 1, 10, 45, 120, 210, 252, 210 },
+  { 1, 11, 55, 165, 330, 462, 462 },
+  { 1, 12, 66, 220, 495, 792, 924 },
+  { 1, 13, 78, 286, 715, 1287, 1716 },
+  { 1, 14, 91, 364, 1001, 2002, 3003 },
+  { 1, 15, 105, 455, 1365, 3003, 5005 },
+  { 1, 16, 120, 560, 1820, 4368, 8008 },
+  { 1, 17, 136, 680, 2380, 6188, 12376 },
+  { 1, 18, 153, 816, 3060, 8568, 18564 },
+  { 1, 19, 171, 969, 3876, 11628, 27132 },
+  { 1, 20, 190, 1140, 4845, 15504, 38760 },
+  { 1, 21, 210, 1330, 5985, 20349, 54264 },
+  { 1, 22, 231, 1540, 7315, 26334, 74613 },
+  { 1, 23, 253, 1771, 8855, 33649, 100947 },
+  { 1, 24, 276, 2024, 10626, 42504, 134596 },
+  { 1, 25, 300, 2300, 12650, 53130, 177100 },
+  { 1, 26, 325, 2600, 14950, 65780, 230230 },
+  { 1, 27, 351, 2925, 17550, 80730, 296010 },
+  { 1, 28, 378, 3276, 20475, 98280, 376740 },
+  { 1, 29, 406, 3654, 23751, 118755, 475020 },
+  { 1, 30, 435, 4060, 27405, 142506, 593775 },
+  { 1, 31, 465, 4495, 31465, 169911, 736281 },
+  { 1, 32, 496, 4960, 35960, 201376, 906192 },
+  { 1, 33, 528, 5456, 40920, 237336, 1107568 },
+  { 1, 34, 561, 5984, 46376, 278256, 1344904 },
+  { 1, 35, 595, 6545, 52360, 324632, 1623160 },
+  { 1, 36, 630, 7140, 58905, 376992, 1947792 },
+  { 1, 37, 666, 7770, 66045, 435897, 2324784 },
+  { 1, 38, 703, 8436, 73815, 501942, 2760681 },
+  { 1, 39, 741, 9139, 82251, 575757, 3262623 },
+  { 1, 40, 780, 9880, 91390, 658008, 3838380 },
+  { 1, 41, 820, 10660, 101270, 749398, 4496388 },
+  { 1, 42, 861, 11480, 111930, 850668, 5245786 },
+  { 1, 43, 903, 12341, 123410, 962598, 6096454 },
+  { 1, 44, 946, 13244, 135751, 1086008, 7059052 },
+  { 1, 45, 990, 14190, 148995, 1221759, 8145060 },
+  { 1, 46, 1035, 15180, 163185, 1370754, 9366819 },
+  { 1, 47, 1081, 16215, 178365, 1533939, 10737573 },
+  { 1, 48, 1128, 17296, 194580, 1712304, 12271512 },
+  { 1, 49, 1176, 18424, 211876, 1906884, 13983816 },
+  { 1, 50, 1225, 19600, 230300, 2118760, 15890700 },
+  { 1, 51, 1275, 20825, 249900, 2349060, 18009460 },
+  { 1, 52, 1326, 22100, 270725, 2598960, 20358520 },
+  { 1, 53, 1378, 23426, 292825, 2869685, 22957480 },
+  { 1, 54, 1431, 24804, 316251, 3162510, 25827165 },
+  { 1, 55, 1485, 26235, 341055, 3478761, 28989675 },
+  { 1, 56, 1540, 27720, 367290, 3819816, 32468436 },
+  { 1, 57, 1596, 29260, 395010, 4187106, 36288252 },
+  { 1, 58, 1653, 30856, 424270, 4582116, 40475358 },
+  { 1, 59, 1711, 32509, 455126, 5006386, 45057474 },
+  { 1, 60, 1770, 34220, 487635, 5461512, 50063860 },
+};
+
+/* bitmap mapeado em memória exclusivo da conexão */
+typedef struct bitmap_s
+{
+  unsigned char *bits;
+  /* resumo das combinações não sorteadas em dois níveis, com o bit w do
+     primeiro indicando alguma na palavra w do bitmap e o bit i do segundo
+     indicando alguma na palavra i do primeiro nível, no mesmo bloco */
+  uint64_t *resumo1, *resumo2;
+  int refs;
+}
+bitmap_t;
+
+static void desmapeia(bitmap_t *b)
+{
+  if (b->bits) munmap(b->bits, BITMAP_SIZE);
+  sqlite3_free(b->resumo1);
+  b->bits = NULL;
+  b->resumo1 = b->resumo2 = NULL;
+}
+
+/* bits das posições não sorteadas da palavra w do bitmap */
+static uint64_t palavra_livre(const unsigned char *bits, sqlite3_int64 w)
+{
+  const sqlite3_int64 inicio = w * 8;
+  const int n = (inicio + 8 <= BITMAP_SIZE) ? 8 : (int) (BITMAP_SIZE - inicio);
+  uint64_t v = 0;
+  int k;
+
+  for (k = 0; k < n; ++k) v |= (uint64_t) bits[inicio + k] << (8 * k);
+  v = ~v;
+  if (w == PALAVRAS - 1 && N_COMBINACOES % 64) {
+    v &= ((uint64_t) 1 << (N_COMBINACOES % 64)) - 1;
+  }
+  return v;
+}
+
+/* monta os dois níveis do resumo do bitmap mapeado */
+static int monta_resumo(bitmap_t *b)
+{
+  sqlite3_int64 w;
+  int i;
+
+  b->resumo1 = sqlite3_malloc((RESUMO1 + RESUMO2) * sizeof(uint64_t));
+  if (!b->resumo1) return 0;
+  b->resumo2 = b->resumo1 + RESUMO1;
+  memset(b->resumo1, 0, (RESUMO1 + RESUMO2) * sizeof(uint64_t));
+  for (w = 0; w < PALAVRAS; ++w) {
+    if (palavra_livre(b->bits, w)) b->resumo1[w >> 6] |= (uint64_t) 1 << (w & 63);
+  }
+  for (i = 0; i < RESUMO1; ++i) {
+    if (b->resumo1[i]) b->resumo2[i >> 6] |= (uint64_t) 1 << (i & 63);
+  }
+  return 1;
+}
+
+static void release_bitmap(void *ptr)
+{
+  bitmap_t *b = (bitmap_t *) ptr;
+  if (--b->refs == 0) {
+    desmapeia(b);
+    sqlite3_free(b);
+  }
+}
+
+/* posição colexicográfica da combinação no bitmask */
+static sqlite3_int64 rank(uint64_t mask)
+{
+  sqlite3_int64 r = 0;
+  int i;
+  for (i = 1; mask; ++i, mask &= mask - 1) {
+    r += BINOMIAL[__builtin_ctzll(mask)][i];
+  }
+  return r;
+}
+
+/* bitmask da combinação de k números na posição colexicográfica r */
+static uint64_t unrank(sqlite3_int64 r, int k)
+{
+  uint64_t mask = 0;
+  int n = N_DEZENAS - 1;
+  for (; k > 0; --k) {
+    while (BINOMIAL[n][k] > r) --n;
+    mask |= (uint64_t) 1 << n;
+    r -= BINOMIAL[n][k];
+    --n;
+  }
+  return mask;
+}
+
+/* valida o bitmask de até 6 números, reportando erro se inválido */
+static int le_mask(sqlite3_context *ctx, sqlite3_value *arg, uint64_t *mask)
+{
+  sqlite3_int64 v;
+  if (sqlite3_value_type(arg) != SQLITE_INTEGER) {
+    sqlite3_result_error(ctx, "tipo do argumento é inválido", -1);
+    return 0;
+  }
+  v = sqlite3_value_int64(arg);
+  if (v < 0 || (v >> N_DEZENAS) || __builtin_popcountll(v) > N_SORTEADAS) {
+    sqlite3_result_error(ctx, "bitmask não é combinação de até 6 números", -1);
+    return 0;
+  }
+  *mask = (uint64_t) v;
+  return 1;
+}
+
+static void comb_rank(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  uint64_t mask;
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+  if (le_mask(ctx, argv[0], &mask)) sqlite3_result_int64(ctx, rank(mask));
+}
+
+static void comb_unrank(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  sqlite3_int64 r;
+  int k = N_SORTEADAS;
+
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+  if (argc == 2) k = sqlite3_value_int(argv[1]);
+  if (k < 1 || k > N_SORTEADAS) {
+    sqlite3_result_error(ctx, "quantidade de números deve estar entre 1 e 6", -1);
+    return;
+  }
+  r = sqlite3_value_int64(argv[0]);
+  if (sqlite3_value_type(argv[0]) != SQLITE_INTEGER || r < 0
+      || r >= BINOMIAL[N_DEZENAS][k]) {
+    sqlite3_result_error(ctx, "posição fora do intervalo das combinações", -1);
+    return;
+  }
+  sqlite3_result_int64(ctx, (sqlite3_int64) unrank(r, k));
+}
+
+/* mapeia o arquivo do bitmap somente para leitura */
+static int mapeia(sqlite3_context *ctx, bitmap_t *b, const char *arquivo)
+{
+  struct stat st;
+  void *p;
+  int fd = open(arquivo, O_RDONLY);
+
+  if (fd < 0 || fstat(fd, &st) != 0 || st.st_size != BITMAP_SIZE) {
+    if (fd >= 0) close(fd);
+    sqlite3_result_error(ctx, "arquivo de bitmap inacessível ou inválido", -1);
+    return 0;
+  }
+  p = mmap(NULL, BITMAP_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    sqlite3_result_error(ctx, "mapeamento do bitmap mal sucedido", -1);
+    return 0;
+  }
+  desmapeia(b);
+  b->bits = (unsigned char *) p;
+  if (!monta_resumo(b)) {
+    desmapeia(b);
+    sqlite3_result_error_nomem(ctx);
+    return 0;
+  }
+  return 1;
+}
+
+static void comb_bitmap_abre(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  bitmap_t *b = (bitmap_t *) sqlite3_user_data(ctx);
+  const char *arquivo = (const char *) sqlite3_value_text(argv[0]);
+  sqlite3_int64 n = 0;
+  int j;
+
+  if (!arquivo || !mapeia(ctx, b, arquivo)) {
+    if (!arquivo) sqlite3_result_error(ctx, "nome do arquivo não informado", -1);
+    return;
+  }
+  for (j = 0; j < BITMAP_SIZE; ++j) n += __builtin_popcount(b->bits[j]);
+  sqlite3_result_int64(ctx, n);
+}
+
+/*
+ * Grava o bitmap num arquivo temporário de nome único no mesmo diretório,
+ * renomeado ao final, de modo que mapeamentos preexistentes por outros
+ * processos permaneçam íntegros e gravações simultâneas não se sobreponham.
+*/
+static void comb_bitmap_monta(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  bitmap_t *b = (bitmap_t *) sqlite3_user_data(ctx);
+  const char *arquivo = (const char *) sqlite3_value_text(argv[0]);
+  sqlite3 *db = sqlite3_context_db_handle(ctx);
+  unsigned char *bits;
+  sqlite3_stmt *stmt;
+  sqlite3_int64 n = 0;
+  char *tmp;
+  FILE *f = NULL;
+  int rc, fd = -1;
+
+  if (!arquivo) {
+    sqlite3_result_error(ctx, "nome do arquivo não informado", -1);
+    return;
+  }
+  rc = sqlite3_prepare_v2(db, "SELECT dezenas FROM dezenas_juntadas", -1, &stmt, NULL);
+  if (rc != SQLITE_OK) {
+    sqlite3_result_error(ctx, sqlite3_errmsg(db), -1);
+    return;
+  }
+  bits = sqlite3_malloc(BITMAP_SIZE);
+  if (!bits) {
+    sqlite3_finalize(stmt);
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  memset(bits, 0, BITMAP_SIZE);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    uint64_t mask = (uint64_t) sqlite3_column_int64(stmt, 0);
+    sqlite3_int64 r;
+    if (mask >> N_DEZENAS || __builtin_popcountll(mask) != N_SORTEADAS) continue;
+    r = rank(mask);
+    if (!(bits[r >> 3] & (1 << (r & 7)))) {
+      bits[r >> 3] |= 1 << (r & 7);
+      ++n;
+    }
+  }
+  rc = sqlite3_finalize(stmt);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(bits);
+    sqlite3_result_error(ctx, sqlite3_errmsg(db), -1);
+    return;
+  }
+
+  tmp = sqlite3_mprintf("%s.XXXXXX", arquivo);
+  if (tmp && (fd = mkstemp(tmp)) >= 0) {
+    // permissões usuais de arquivo de dados ao invés das restritas de mkstemp
+    fchmod(fd, 0644);
+    if (!(f = fdopen(fd, "wb"))) {
+      close(fd);
+      remove(tmp);
+    }
+  }
+  if (!f) {
+    sqlite3_free(bits);
+    sqlite3_free(tmp);
+    sqlite3_result_error(ctx, "arquivo de bitmap inacessível", -1);
+    return;
+  }
+  rc = fwrite(bits, 1, BITMAP_SIZE, f) == BITMAP_SIZE;
+  rc = (fclose(f) == 0) && rc && rename(tmp, arquivo) == 0;
+  if (!rc) remove(tmp);
+  sqlite3_free(tmp);
+  sqlite3_free(bits);
+  if (!rc) {
+    sqlite3_result_error(ctx, "gravação do bitmap mal sucedida", -1);
+    return;
+  }
+  if (mapeia(ctx, b, arquivo)) sqlite3_result_int64(ctx, n);
+}
+
+static int bitmap_disponivel(sqlite3_context *ctx, bitmap_t *b)
+{
+  if (!b->bits) {
+    sqlite3_result_error(ctx, "bitmap não mapeado, use comb_bitmap_monta()" \
+      " ou comb_bitmap_abre()", -1);
+  }
+  return b->bits != NULL;
+}
+
+static void comb_sorteada(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  bitmap_t *b = (bitmap_t *) sqlite3_user_data(ctx);
+  uint64_t mask;
+  sqlite3_int64 r;
+
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+  if (!bitmap_disponivel(ctx, b) || !le_mask(ctx, argv[0], &mask)) return;
+  if (__builtin_popcountll(mask) != N_SORTEADAS) {
+    sqlite3_result_error(ctx, "bitmask não é combinação de 6 números", -1);
+    return;
+  }
+  r = rank(mask);
+  sqlite3_result_int(ctx, (b->bits[r >> 3] >> (r & 7)) & 1);
+}
+
+/*
+ * Primeira posição não sorteada a partir de r, ou -1 se inexistente: a
+ * palavra de r, a seguinte com posição livre no primeiro nível do resumo e,
+ * se ausente na mesma palavra do resumo, via segundo nível, cujas 191
+ * palavras limitam o custo independentemente das combinações sorteadas.
+*/
+static sqlite3_int64 proxima_livre(const bitmap_t *b, sqlite3_int64 r)
+{
+  sqlite3_int64 w = r >> 6, i, j;
+  uint64_t v = palavra_livre(b->bits, w) & (~(uint64_t) 0 << (r & 63));
+
+  if (v) return (w << 6) + __builtin_ctzll(v);
+  if (++w >= PALAVRAS) return -1;
+  i = w >> 6;
+  v = b->resumo1[i] & (~(uint64_t) 0 << (w & 63));
+  if (!v) {
+    if (++i >= RESUMO1) return -1;
+    j = i >> 6;
+    for (v = b->resumo2[j] & (~(uint64_t) 0 << (i & 63)); !v; v = b->resumo2[j]) {
+      if (++j >= RESUMO2) return -1;
+    }
+    i = (j << 6) + __builtin_ctzll(v);
+    v = b->resumo1[i];
+  }
+  w = (i << 6) + __builtin_ctzll(v);
+  return (w << 6) + __builtin_ctzll(palavra_livre(b->bits, w));
+}
+
+/*
+ * Posição da combinação não sorteada mais próxima a partir da informada,
+ * circularmente, via resumo do bitmap em tempo limitado.
+*/
+static void comb_nao_sorteada(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  bitmap_t *b = (bitmap_t *) sqlite3_user_data(ctx);
+  sqlite3_int64 r;
+
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+  if (!bitmap_disponivel(ctx, b)) return;
+  r = sqlite3_value_int64(argv[0]);
+  if (sqlite3_value_type(argv[0]) != SQLITE_INTEGER || r < 0 || r >= N_COMBINACOES) {
+    sqlite3_result_error(ctx, "posição fora do intervalo das combinações", -1);
+    return;
+  }
+  if ((r = proxima_livre(b, r)) < 0) r = proxima_livre(b, 0);
+  if (r < 0) {
+    sqlite3_result_null(ctx);
+  } else {
+    sqlite3_result_int64(ctx, r);
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* limites dos argumentos "top" e "threads" */
+#define MAX_TOP 100000
+#define MAX_THREADS 256
+
+/* quantidade de combinações entre verificações de interrupção */
+#define LOTE 65536
+
+enum colunas_cobertura {
+  COL_TIPO = 0, COL_ACERTOS, COL_COMBINACOES, COL_RANK, COL_DEZENAS,
+  COL_QUADRAS, COL_QUINAS, COL_TOP, COL_THREADS
+};
+
+/* bits de "idxNum" indicando os argumentos repassados a xFilter */
+#define ARG_TOP     1
+#define ARG_THREADS 2
+
+/* desempenho de uma combinação na série histórica */
+typedef struct desempenho_s
+{
+  sqlite3_int64 rank;
+  uint64_t mask;
+  int acertos, quadras, quinas;
+}
+desempenho_t;
+
+/* partição do espaço de combinações e seus resultados parciais */
+typedef struct particao_s
+{
+  const uint64_t *serie;
+  int n;                            /* quantidade de concursos da série */
+  sqlite3_int64 inicio, fim;        /* intervalo de posições [inicio, fim) */
+  int k;                            /* capacidade do top */
+  desempenho_t *top;                /* heap cuja raiz é o pior desempenho */
+  int ntop;
+  sqlite3_int64 histograma[N_SORTEADAS+1];
+  sqlite3_int64 quadras[N_SORTEADAS+1], quinas[N_SORTEADAS+1];
+  volatile int *interrompida;
+  sqlite3 *db;                      /* conexão, somente na thread principal */
+}
+particao_t;
+
+typedef struct cobertura_tabela_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+  char *schema;
+}
+cobertura_tabela_t;
+
+typedef struct cobertura_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_int64 histograma[N_SORTEADAS+1];
+  sqlite3_int64 quadras[N_SORTEADAS+1], quinas[N_SORTEADAS+1];
+  desempenho_t *top;                /* em ordem decrescente de desempenho */
+  int ntop, k, threads;
+  int j;                            /* linha corrente */
+}
+cobertura_cursor_t;
+
+/* compara desempenhos, com precedência da menor posição se empatados */
+static int melhor(const desempenho_t *a, const desempenho_t *b)
+{
+  if (a->acertos != b->acertos) return a->acertos > b->acertos;
+  if (a->quinas != b->quinas) return a->quinas > b->quinas;
+  if (a->quadras != b->quadras) return a->quadras > b->quadras;
+  return a->rank < b->rank;
+}
+
+static int ordem_decrescente(const void *a, const void *b)
+{
+  return melhor((const desempenho_t *) b, (const desempenho_t *) a)
+    - melhor((const desempenho_t *) a, (const desempenho_t *) b);
+}
+
+/* insere o desempenho no heap do top se estiver entre os k melhores */
+static void insere_top(particao_t *p, const desempenho_t *d)
+{
+  desempenho_t *h = p->top;
+  int j, filho;
+
+  if (p->ntop < p->k) {
+    for (j = p->ntop++; j > 0 && melhor(&h[(j - 1) / 2], d); j = (j - 1) / 2) {
+      h[j] = h[(j - 1) / 2];
+    }
+    h[j] = *d;
+  } else if (p->k > 0 && melhor(d, &h[0])) {
+    for (j = 0; (filho = 2 * j + 1) < p->ntop; j = filho) {
+      if (filho + 1 < p->ntop && melhor(&h[filho], &h[filho + 1])) ++filho;
+      if (!melhor(d, &h[filho])) break;
+      h[j] = h[filho];
+    }
+    h[j] = *d;
+  }
+}
+
+/* próximo bitmask com a mesma quantidade de bits, i.e.; próxima posição */
+static inline uint64_t sucessor(uint64_t x)
+{
+  uint64_t u = x & -x, v = u + x;
+  return v | (((v ^ x) >> 2) >> __builtin_ctzll(x));
+}
+
+/*
+ * Varre as posições [inicio, fim) da partição. Em ordem colexicográfica, as
+ * combinações de mesmos 5 números maiores T são consecutivas, variando apenas
+ * o menor número x abaixo do menor de T, logo os acertos t de T em cada
+ * concurso são contados uma única vez por grupo e os de cada combinação são
+ * t+1 nos concursos que contêm x e t nos demais, i.e.; para cada x:
+ *
+ *    maior acerto = max(t) + (x sorteado com algum concurso de t máximo)
+ *    quadras = #(t=4) - #(t=4 com x) + #(t=3 com x)
+ *    quinas  = #(t=5) - #(t=5 com x) + #(t=4 com x)
+ *
+ * onde apenas os poucos concursos com t >= 3 contribuem às contagens por x.
+*/
+static SEMPRE_INLINE void *varre_particao(void *arg)
+{
+  particao_t *p = (particao_t *) arg;
+  const uint64_t *serie = p->serie;
+  const int n = p->n;
+  uint64_t mask = unrank(p->inicio, N_SORTEADAS);
+  sqlite3_int64 r = p->inicio, verificacao = p->inicio;
+
+  while (r < p->fim) {
+    const uint64_t grupo = mask & (mask - 1);       /* os 5 números maiores */
+    const int m = __builtin_ctzll(grupo);           /* x varia em [0, m) */
+    const uint64_t abaixo = ((uint64_t) 1 << m) - 1;
+    int contagem[N_SORTEADAS][N_DEZENAS];           /* #(t com x) para t=3..5 */
+    int quantos[N_SORTEADAS] = { 0 };               /* #(t) */
+    uint64_t sorteados_maior = 0;
+    int maior = -1, x, j;
+
+    if (r >= verificacao) {
+#if SQLITE_VERSION_NUMBER >= 3041000
+      if (p->db && sqlite3_is_interrupted(p->db)) *p->interrompida = 1;
+#endif
+      if (*p->interrompida) break;
+      verificacao = r + LOTE;
+    }
+
+    for (j = 3; j < N_SORTEADAS; ++j) memset(contagem[j], 0, m * sizeof(int));
+    for (j = 0; j < n; ++j) {
+      const int t = __builtin_popcountll(grupo & serie[j]);
+      if (t > maior) {
+        maior = t;
+        sorteados_maior = 0;
+      }
+      if (t == maior) sorteados_maior |= serie[j];
+      if (t >= 3) {
+        uint64_t b = serie[j] & abaixo;
+        ++quantos[t];
+        for (; b; b &= b - 1) ++contagem[t][__builtin_ctzll(b)];
+      }
+    }
+
+    for (x = __builtin_ctzll(mask); x < m && r < p->fim; ++x, ++r) {
+      desempenho_t d;
+      d.acertos = n ? maior + (int) ((sorteados_maior >> x) & 1) : 0;
+      d.quadras = quantos[4] - contagem[4][x] + contagem[3][x];
+      d.quinas = quantos[5] - contagem[5][x] + contagem[4][x];
+      ++p->histograma[d.acertos];
+      p->quadras[d.acertos] += d.quadras;
+      p->quinas[d.acertos] += d.quinas;
+      if (p->ntop < p->k || d.acertos >= p->top[0].acertos) {
+        d.rank = r;
+        d.mask = grupo | (uint64_t) 1 << x;
+        insere_top(p, &d);
+      }
+    }
+    // primeira combinação do grupo seguinte
+    mask = sucessor(grupo | (uint64_t) 1 << (m - 1));
+  }
+  return NULL;
+}
+
+static void *varre_generica(void *arg) { return varre_particao(arg); }
+static POPCNT void *varre_popcnt(void *arg) { return varre_particao(arg); }
+
+static int coberturaConnect(sqlite3 *db, void *aux, int argc,
+  const char *const *argv, sqlite3_vtab **ppVtab, char **err)
+{
+  cobertura_tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(tipo TEXT, acertos INTEGER," \
+    " combinacoes INTEGER, rank INTEGER, dezenas INTEGER, quadras INTEGER," \
+    " quinas INTEGER, top HIDDEN, threads HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+
+  t = sqlite3_malloc(sizeof(cobertura_tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(cobertura_tabela_t));
+  t->db = db;
+  t->schema = sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int coberturaDisconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(((cobertura_tabela_t *) vtab)->schema);
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+static int coberturaBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j, argv_top = -1, argv_threads = -1, n = 0;
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if ((c->iColumn == COL_TOP || c->iColumn == COL_THREADS)
+        && c->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      if (!c->usable) return SQLITE_CONSTRAINT;
+      if (c->iColumn == COL_TOP) argv_top = j; else argv_threads = j;
+    }
+  }
+  info->idxNum = 0;
+  if (argv_top >= 0) {
+    info->aConstraintUsage[argv_top].argvIndex = ++n;
+    info->aConstraintUsage[argv_top].omit = 1;
+    info->idxNum |= ARG_TOP;
+  }
+  if (argv_threads >= 0) {
+    info->aConstraintUsage[argv_threads].argvIndex = ++n;
+    info->aConstraintUsage[argv_threads].omit = 1;
+    info->idxNum |= ARG_THREADS;
+  }
+  info->estimatedCost = 1e12;
+  info->estimatedRows = N_SORTEADAS + 1 + 10;
+  return SQLITE_OK;
+}
+
+static int coberturaOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cobertura_cursor_t *c = sqlite3_malloc(sizeof(cobertura_cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cobertura_cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int coberturaClose(sqlite3_vtab_cursor *cur)
+{
+  cobertura_cursor_t *c = (cobertura_cursor_t *) cur;
+  sqlite3_free(c->top);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/* leitura da série histórica compactada em bitmasks */
+static int carrega_serie(cobertura_tabela_t *t, uint64_t **serie, int *n)
+{
+  sqlite3_stmt *stmt;
+  char *sql;
+  int rc, capacidade = 0;
+
+  *serie = NULL;
+  *n = 0;
+  sql = sqlite3_mprintf("SELECT dezenas FROM \"%w\".dezenas_juntadas", t->schema);
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) return rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    if (*n == capacidade) {
+      uint64_t *p;
+      capacidade = capacidade ? 2 * capacidade : 4096;
+      p = sqlite3_realloc64(*serie, capacidade * sizeof(uint64_t));
+      if (!p) {
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      *serie = p;
+    }
+    (*serie)[(*n)++] = (uint64_t) sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    sqlite3_free(*serie);
+    *serie = NULL;
+    return rc;
+  }
+  return SQLITE_OK;
+}
+
+static int coberturaFilter(sqlite3_vtab_cursor *cur, int idxNum,
+  const char *idxStr, int argc, sqlite3_value **argv)
+{
+  cobertura_cursor_t *c = (cobertura_cursor_t *) cur;
+  cobertura_tabela_t *t = (cobertura_tabela_t *) cur->pVtab;
+  sqlite3_int64 k = 10, threads = sysconf(_SC_NPROCESSORS_ONLN);
+  void *(*varre)(void *) = POPCNT_NATIVO() ? varre_popcnt : varre_generica;
+  particao_t *particoes;
+  pthread_t *ids;
+  char *criada;
+  volatile int interrompida = 0;
+  uint64_t *serie;
+  int rc, j, i, n, arg = 0;
+
+  if (idxNum & ARG_TOP) {
+    if (sqlite3_value_numeric_type(argv[arg]) != SQLITE_INTEGER
+        || (k = sqlite3_value_int64(argv[arg])) < 0 || k > MAX_TOP) {
+      sqlite3_free(t->base.zErrMsg);
+      t->base.zErrMsg = sqlite3_mprintf("top deve ser inteiro entre 0 e %d", MAX_TOP);
+      return SQLITE_ERROR;
+    }
+    ++arg;
+  }
+  if (idxNum & ARG_THREADS) {
+    if (sqlite3_value_numeric_type(argv[arg]) != SQLITE_INTEGER
+        || (threads = sqlite3_value_int64(argv[arg])) < 1 || threads > MAX_THREADS) {
+      sqlite3_free(t->base.zErrMsg);
+      t->base.zErrMsg = sqlite3_mprintf("threads deve ser inteiro entre 1 e %d", MAX_THREADS);
+      return SQLITE_ERROR;
+    }
+  }
+  if (threads < 1) threads = 1;
+  if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+  rc = carrega_serie(t, &serie, &n);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+
+  sqlite3_free(c->top);
+  memset(c->histograma, 0, sizeof(c->histograma));
+  memset(c->quadras, 0, sizeof(c->quadras));
+  memset(c->quinas, 0, sizeof(c->quinas));
+  c->k = (int) k;
+  c->threads = (int) threads;
+  c->ntop = c->j = 0;
+  c->top = sqlite3_malloc64((threads * k + 1) * sizeof(desempenho_t));
+  particoes = sqlite3_malloc64(threads * sizeof(particao_t));
+  ids = sqlite3_malloc64(threads * sizeof(pthread_t));
+  criada = sqlite3_malloc64(threads);
+  if (!c->top || !particoes || !ids || !criada) {
+    sqlite3_free(particoes);
+    sqlite3_free(ids);
+    sqlite3_free(criada);
+    sqlite3_free(serie);
+    return SQLITE_NOMEM;
+  }
+
+  // partições de tamanhos iguais, cada uma com seu trecho do buffer do top
+  for (j = 0; j < threads; ++j) {
+    particao_t *p = &particoes[j];
+    memset(p, 0, sizeof(particao_t));
+    p->serie = serie;
+    p->n = n;
+    p->inicio = (sqlite3_int64) N_COMBINACOES * j / threads;
+    p->fim = (sqlite3_int64) N_COMBINACOES * (j + 1) / threads;
+    p->k = c->k;
+    p->top = c->top + j * k;
+    p->interrompida = &interrompida;
+  }
+
+  // a primeira partição é varrida pela thread principal, que verifica
+  // interrupções da conexão, e as partições cujas threads não puderam ser
+  // criadas são varridas em seguida
+  for (j = 1; j < threads; ++j) {
+    criada[j] = pthread_create(&ids[j], NULL, varre, &particoes[j]) == 0;
+  }
+  particoes[0].db = t->db;
+  varre(&particoes[0]);
+  for (j = 1; j < threads; ++j) {
+    if (criada[j]) {
+      pthread_join(ids[j], NULL);
+    } else {
+      particoes[j].db = t->db;
+      varre(&particoes[j]);
+    }
+  }
+
+  // consolidação dos resultados parciais
+  for (j = 0; j < threads; ++j) {
+    particao_t *p = &particoes[j];
+    for (i = 0; i <= N_SORTEADAS; ++i) {
+      c->histograma[i] += p->histograma[i];
+      c->quadras[i] += p->quadras[i];
+      c->quinas[i] += p->quinas[i];
+    }
+    memmove(c->top + c->ntop, p->top, p->ntop * sizeof(desempenho_t));
+    c->ntop += p->ntop;
+  }
+  qsort(c->top, c->ntop, sizeof(desempenho_t), ordem_decrescente);
+  if (c->ntop > c->k) c->ntop = c->k;
+
+  sqlite3_free(particoes);
+  sqlite3_free(ids);
+  sqlite3_free(criada);
+  sqlite3_free(serie);
+  return interrompida ? SQLITE_INTERRUPT : SQLITE_OK;
+}
+
+static int coberturaNext(sqlite3_vtab_cursor *cur)
+{
+  ++((cobertura_cursor_t *) cur)->j;
+  return SQLITE_OK;
+}
+
+static int coberturaEof(sqlite3_vtab_cursor *cur)
+{
+  cobertura_cursor_t *c = (cobertura_cursor_t *) cur;
+  return c->j >= N_SORTEADAS + 1 + c->ntop;
+}
+
+static int coberturaColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cobertura_cursor_t *c = (cobertura_cursor_t *) cur;
+  const int h = c->j;
+  const desempenho_t *d = (h > N_SORTEADAS) ? &c->top[h - N_SORTEADAS - 1] : NULL;
+
+  switch (col) {
+    case COL_TIPO:
+      sqlite3_result_text(ctx, d ? "top" : "histograma", -1, SQLITE_STATIC);
+      break;
+    case COL_ACERTOS:
+      sqlite3_result_int(ctx, d ? d->acertos : h);
+      break;
+    case COL_COMBINACOES:
+      if (!d) sqlite3_result_int64(ctx, c->histograma[h]);
+      break;
+    case COL_RANK:
+      if (d) sqlite3_result_int64(ctx, d->rank);
+      break;
+    case COL_DEZENAS:
+      if (d) sqlite3_result_int64(ctx, (sqlite3_int64) d->mask);
+      break;
+    case COL_QUADRAS:
+      sqlite3_result_int64(ctx, d ? d->quadras : c->quadras[h]);
+      break;
+    case COL_QUINAS:
+      sqlite3_result_int64(ctx, d ? d->quinas : c->quinas[h]);
+      break;
+    case COL_TOP:
+      sqlite3_result_int(ctx, c->k);
+      break;
+    case COL_THREADS:
+      sqlite3_result_int(ctx, c->threads);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int coberturaRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((cobertura_cursor_t *) cur)->j + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_cobertura = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  coberturaConnect,
+  coberturaBestIndex,
+  coberturaDisconnect,
+  0,              /* xDestroy */
+  coberturaOpen,
+  coberturaClose,
+  coberturaFilter,
+  coberturaNext,
+  coberturaEof,
+  coberturaColumn,
+  coberturaRowid,
+};
+
+/* ------------------------------------------------------------------------ */
+
+/* limites dos argumentos de "desdobramento" */
+#define MAX_CANDIDATOS 30
+#define MAX_SEGUNDOS 600
+
+/* apostas avaliadas a cada escolha gulosa sem coberturas pré-calculadas */
+#define AMOSTRA 256
+
+/* limite das coberturas pré-calculadas de todas as apostas, em posições */
+#define MAX_COBERTURAS (1 << 24)
+
+/* tempo padrão da busca local em segundos */
+#define SEGUNDOS_PADRAO 2.0
+
+/* quantidade de movimentos da busca local entre verificações do prazo */
+#define MOVIMENTOS 256
+
+/* temperatura do recozimento da busca local, ajustada empiricamente */
+#define TEMPERATURA 0.15
+
+/* estado compartilhado entre as threads da busca por desdobramentos */
+typedef struct desdobramento_s
+{
+  int v, t, m;                      /* candidatos, garantia e acertos */
+  int n;                            /* subconjuntos cobertos por aposta */
+  sqlite3_int64 blocos;             /* quantidade de subconjuntos, C(v,m) */
+  sqlite3_int64 limite;             /* limite inferior de apostas */
+  uint32_t *coberturas;             /* coberturas de todas as apostas ou NULL */
+  uint32_t *subconjuntos;           /* bitmasks dos subconjuntos por posição */
+  uint32_t *melhor;                 /* melhor desdobramento até então */
+  int nmelhor;
+  double prazo;
+  volatile int *interrompida;
+  pthread_mutex_t mutex;
+}
+desdobramento_t;
+
+/* estado de cada thread da busca local */
+typedef struct busca_s
+{
+  desdobramento_t *d;
+  sqlite3 *db;                      /* conexão, somente na thread principal */
+  uint64_t semente;
+  uint32_t *apostas;
+  uint32_t *multiplicidade;         /* apostas que cobrem cada subconjunto */
+  uint32_t *descobertos;            /* subconjuntos descobertos */
+  uint32_t *posicao;                /* posição de cada um em "descobertos" */
+  uint32_t ndescobertos;
+  uint32_t *saem, *entram;          /* buffers das coberturas */
+}
+busca_t;
+
+static double agora(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t aleatorio(uint64_t *s)
+{
+  *s ^= *s << 13;
+  *s ^= *s >> 7;
+  *s ^= *s << 17;
+  return *s;
+}
+
+/* bit aleatório do bitmask não nulo */
+static SEMPRE_INLINE uint32_t bit_aleatorio(uint32_t x, uint64_t *semente)
+{
+  int p;
+  for (p = aleatorio(semente) % __builtin_popcount(x); p > 0; --p) x &= x - 1;
+  return x & -x;
+}
+
+/* bitmask dos elementos de "elementos" selecionados pelo bitmask local */
+static inline uint64_t expande(uint32_t local, const int *elementos)
+{
+  uint64_t mask = 0;
+  for (; local; local &= local - 1) {
+    mask |= (uint64_t) 1 << elementos[__builtin_ctzl(local)];
+  }
+  return mask;
+}
+
+/*
+ * Posições colexicográficas dos subconjuntos de "acertos" candidatos cobertos
+ * pela aposta, i.e.; com os quais compartilha ao menos "garantia" números,
+ * formados por i números da aposta e acertos-i dos demais para cada i.
+*/
+static void enumera_cobertura(const desdobramento_t *d, uint32_t aposta, uint32_t *saida)
+{
+  int dentro[N_SORTEADAS], fora[MAX_CANDIDATOS], nd = 0, nf = 0, i, n = 0;
+  uint32_t a, b;
+
+  for (i = 0; i < d->v; ++i) {
+    if (aposta >> i & 1) dentro[nd++] = i; else fora[nf++] = i;
+  }
+  for (i = d->t; i <= d->m && i <= N_SORTEADAS; ++i) {
+    const int j = d->m - i;
+    if (j > nf) continue;
+    for (a = (1u << i) - 1; a < (1u << N_SORTEADAS); a = (uint32_t) sucessor(a)) {
+      const uint64_t A = expande(a, dentro);
+      if (j == 0) {
+        saida[n++] = (uint32_t) rank(A);
+        continue;
+      }
+      for (b = (1u << j) - 1; b < (1u << nf); b = (uint32_t) sucessor(b)) {
+        saida[n++] = (uint32_t) rank(A | expande(b, fora));
+      }
+    }
+  }
+}
+
+/* cobertura da aposta, pré-calculada ou enumerada no buffer */
+static inline const uint32_t *cobre(const desdobramento_t *d, uint32_t aposta, uint32_t *buffer)
+{
+  if (d->coberturas) return d->coberturas + rank(aposta) * d->n;
+  enumera_cobertura(d, aposta, buffer);
+  return buffer;
+}
+
+/* nenhuma aposta, com todos os subconjuntos descobertos */
+static void reinicia(busca_t *b)
+{
+  uint32_t j;
+  memset(b->multiplicidade, 0, b->d->blocos * sizeof(uint32_t));
+  for (j = 0; j < b->d->blocos; ++j) b->descobertos[j] = b->posicao[j] = j;
+  b->ndescobertos = b->d->blocos;
+}
+
+/* aplica a aposta, retornando a quantidade de subconjuntos cobertos de novo */
+static int adiciona(busca_t *b, uint32_t aposta)
+{
+  const uint32_t *cobertura = cobre(b->d, aposta, b->entram);
+  int j, novos = 0;
+  for (j = 0; j < b->d->n; ++j) {
+    const uint32_t r = cobertura[j];
+    if (b->multiplicidade[r]++ == 0) {
+      // retira da lista dos descobertos trazendo o último à sua posição
+      const uint32_t ultimo = b->descobertos[--b->ndescobertos];
+      b->descobertos[b->posicao[r]] = ultimo;
+      b->posicao[ultimo] = b->posicao[r];
+      ++novos;
+    }
+  }
+  return novos;
+}
+
+/* remove a aposta, retornando a quantidade de subconjuntos descobertos */
+static int remove_aposta(busca_t *b, uint32_t aposta)
+{
+  const uint32_t *cobertura = cobre(b->d, aposta, b->saem);
+  int j, perdidos = 0;
+  for (j = 0; j < b->d->n; ++j) {
+    const uint32_t r = cobertura[j];
+    if (--b->multiplicidade[r] == 0) {
+      b->posicao[r] = b->ndescobertos;
+      b->descobertos[b->ndescobertos++] = r;
+      ++perdidos;
+    }
+  }
+  return perdidos;
+}
+
+/*
+ * Busca local a partir do melhor desdobramento publicado: retira a aposta de
+ * menor cobertura exclusiva e troca números das apostas por recozimento
+ * simulado até cobrir todos os subconjuntos, publicando o novo desdobramento
+ * com uma aposta a menos, e assim sucessivamente até o prazo.
+*/
+static SEMPRE_INLINE void *busca_local(void *arg)
+{
+  busca_t *b = (busca_t *) arg;
+  desdobramento_t *d = b->d;
+  long movimentos = 0;
+
+  for (;;) {
+    int k, j, pior = 0, menor = INT32_MAX;
+
+    pthread_mutex_lock(&d->mutex);
+    k = d->nmelhor;
+    memcpy(b->apostas, d->melhor, k * sizeof(uint32_t));
+    pthread_mutex_unlock(&d->mutex);
+    if (k <= d->limite || k <= 1) break;
+
+    reinicia(b);
+    for (j = 0; j < k; ++j) adiciona(b, b->apostas[j]);
+    for (j = 0; j < k; ++j) {
+      const uint32_t *cobertura = cobre(d, b->apostas[j], b->saem);
+      int i, exclusivos = 0;
+      for (i = 0; i < d->n; ++i) exclusivos += b->multiplicidade[cobertura[i]] == 1;
+      if (exclusivos < menor || (exclusivos == menor && aleatorio(&b->semente) & 1)) {
+        menor = exclusivos;
+        pior = j;
+      }
+    }
+    remove_aposta(b, b->apostas[pior]);
+    b->apostas[pior] = b->apostas[--k];
+
+    while (b->ndescobertos > 0) {
+      uint32_t antiga, nova, alvo;
+      int delta, i, n;
+
+      if (++movimentos % MOVIMENTOS == 0) {
+#if SQLITE_VERSION_NUMBER >= 3041000
+        if (b->db && sqlite3_is_interrupted(b->db)) *d->interrompida = 1;
+#endif
+        if (*d->interrompida || agora() > d->prazo) return NULL;
+        // outra thread já encontrou desdobramento deste tamanho
+        if (d->nmelhor <= k) break;
+      }
+      // subconjunto descoberto aleatório
+      alvo = d->subconjuntos[b->descobertos[aleatorio(&b->semente) % b->ndescobertos]];
+      // primeira aposta a partir de uma posição aleatória a um número de
+      // cobri-lo, ou a própria se não houver, troca um número fora do
+      // subconjunto por um dentro dele
+      for (i = j = aleatorio(&b->semente) % k, n = 0; n < k; ++n, i = i + 1 < k ? i + 1 : 0) {
+        if (__builtin_popcount(b->apostas[i] & alvo) == d->t - 1) {
+          j = i;
+          break;
+        }
+      }
+      antiga = b->apostas[j];
+      nova = antiga & ~bit_aleatorio(antiga & ~alvo, &b->semente);
+      nova |= bit_aleatorio(alvo & ~antiga, &b->semente);
+
+      delta = remove_aposta(b, antiga) - adiciona(b, nova);
+      if (delta <= 0 || (aleatorio(&b->semente) >> 11) * 0x1.0p-53 < exp(-delta / TEMPERATURA)) {
+        b->apostas[j] = nova;
+      } else {
+        remove_aposta(b, nova);
+        adiciona(b, antiga);
+      }
+    }
+
+    if (b->ndescobertos == 0) {
+      pthread_mutex_lock(&d->mutex);
+      if (k < d->nmelhor) {
+        memcpy(d->melhor, b->apostas, k * sizeof(uint32_t));
+        d->nmelhor = k;
+      }
+      pthread_mutex_unlock(&d->mutex);
+    }
+  }
+  return NULL;
+}
+
+static void *busca_generica(void *arg) { return busca_local(arg); }
+static POPCNT void *busca_popcnt(void *arg) { return busca_local(arg); }
+
+/* entrada do heap de apostas por quantidade de subconjuntos descobertos */
+typedef struct candidata_s
+{
+  int cobertos;
+  uint32_t aposta;
+}
+candidata_t;
+
+/* reposiciona "e" a partir da posição j do heap de máximo */
+static void desce(candidata_t *heap, sqlite3_int64 n, sqlite3_int64 j, candidata_t e)
+{
+  sqlite3_int64 filho;
+  for (; (filho = 2 * j + 1) < n; j = filho) {
+    if (filho + 1 < n && heap[filho + 1].cobertos > heap[filho].cobertos) ++filho;
+    if (heap[filho].cobertos <= e.cobertos) break;
+    heap[j] = heap[filho];
+  }
+  heap[j] = e;
+}
+
+/*
+ * Quantidade de subconjuntos descobertos que a aposta cobriria, contados na
+ * lista dos descobertos quando menor que sua cobertura.
+*/
+static SEMPRE_INLINE int ganho(busca_t *b, uint32_t aposta)
+{
+  const desdobramento_t *d = b->d;
+  int i, cobertos = 0;
+
+  if (b->ndescobertos < (uint32_t) d->n) {
+    for (i = 0; i < b->ndescobertos; ++i) {
+      cobertos += __builtin_popcount(d->subconjuntos[b->descobertos[i]] & aposta) >= d->t;
+    }
+  } else {
+    const uint32_t *cobertura = cobre(d, aposta, b->entram);
+    for (i = 0; i < d->n; ++i) cobertos += b->multiplicidade[cobertura[i]] == 0;
+  }
+  return cobertos;
+}
+
+/* aposta aleatória que cobre o subconjunto */
+static SEMPRE_INLINE uint32_t completa(busca_t *b, uint32_t subconjunto)
+{
+  const uint32_t todos = (uint32_t) ((1ULL << b->d->v) - 1);
+  uint32_t aposta = 0;
+  while (__builtin_popcount(aposta) < N_SORTEADAS) {
+    const uint32_t restantes = (subconjunto & ~aposta) ? subconjunto & ~aposta : todos & ~aposta;
+    aposta |= bit_aleatorio(restantes, &b->semente);
+  }
+  return aposta;
+}
+
+/*
+ * Desdobramento guloso inicial: escolhe repetidamente a aposta que cobre mais
+ * subconjuntos ainda descobertos. Com as coberturas pré-calculadas, todas as
+ * apostas são candidatas num heap e só a do topo é reavaliada, pois as
+ * coberturas só diminuem; senão, a cada escolha são candidatas apenas
+ * AMOSTRA apostas aleatórias completando subconjuntos descobertos.
+*/
+static SEMPRE_INLINE int gulosa(desdobramento_t *d, busca_t *b, sqlite3 *db)
+{
+  const sqlite3_int64 total = d->coberturas ? BINOMIAL[d->v][N_SORTEADAS] : 0;
+  candidata_t *heap = NULL, e;
+  sqlite3_int64 n = 0;
+  uint32_t aposta;
+  long avaliacoes = 0;
+
+  reinicia(b);
+  d->nmelhor = 0;
+
+  if (!d->coberturas) {
+    while (b->ndescobertos > 0) {
+      int j, melhor = -1, cobertos;
+#if SQLITE_VERSION_NUMBER >= 3041000
+      if (sqlite3_is_interrupted(db)) return SQLITE_INTERRUPT;
+#endif
+      for (j = 0; j < AMOSTRA; ++j) {
+        const uint32_t alvo = d->subconjuntos[b->descobertos[aleatorio(&b->semente) % b->ndescobertos]];
+        aposta = completa(b, alvo);
+        if ((cobertos = ganho(b, aposta)) > melhor) {
+          melhor = cobertos;
+          e.aposta = aposta;
+        }
+      }
+      adiciona(b, e.aposta);
+      d->melhor[d->nmelhor++] = e.aposta;
+    }
+    return SQLITE_OK;
+  }
+
+  heap = sqlite3_malloc64(total * sizeof(candidata_t));
+  if (!heap) return SQLITE_NOMEM;
+  // apostas em ordem aleatória, desempatando as escolhas
+  for (aposta = (1u << N_SORTEADAS) - 1; n < total; aposta = (uint32_t) sucessor(aposta)) {
+    sqlite3_int64 j = aleatorio(&b->semente) % (n + 1);
+    heap[n] = heap[j];
+    heap[j].cobertos = d->n;
+    heap[j].aposta = aposta;
+    ++n;
+  }
+
+  while (b->ndescobertos > 0 && n > 0) {
+    int maximo;
+#if SQLITE_VERSION_NUMBER >= 3041000
+    if (++avaliacoes % MOVIMENTOS == 0 && sqlite3_is_interrupted(db)) {
+      sqlite3_free(heap);
+      return SQLITE_INTERRUPT;
+    }
+#else
+    (void) avaliacoes;
+#endif
+    e = heap[0];
+    e.cobertos = ganho(b, e.aposta);
+    maximo = n > 1 ? heap[1].cobertos : 0;
+    if (n > 2 && heap[2].cobertos > maximo) maximo = heap[2].cobertos;
+    if (e.cobertos > 0 && e.cobertos >= maximo) {
+      adiciona(b, e.aposta);
+      d->melhor[d->nmelhor++] = e.aposta;
+      e.cobertos = 0;
+    }
+    if (e.cobertos == 0) {
+      // aposta escolhida ou inútil deixa o heap
+      if (--n > 0) desce(heap, n, 0, heap[n]);
+    } else {
+      desce(heap, n, 0, e);
+    }
+  }
+  sqlite3_free(heap);
+  return SQLITE_OK;
+}
+
+/* conjunto de candidatos como bitmask ou texto com os números */
+static uint64_t candidatos(sqlite3_value *arg)
+{
+  uint64_t mask = 0;
+  if (sqlite3_value_type(arg) == SQLITE_INTEGER) {
+    mask = (uint64_t) sqlite3_value_int64(arg);
+  } else if (sqlite3_value_type(arg) == SQLITE_TEXT) {
+    const unsigned char *z = sqlite3_value_text(arg);
+    while (*z) {
+      int numero = 0;
+      if (*z < '0' || *z > '9') {
+        ++z;
+        continue;
+      }
+      for (; *z >= '0' && *z <= '9' && numero <= N_DEZENAS; ++z) numero = 10 * numero + *z - '0';
+      if (numero < 1 || numero > N_DEZENAS) return UINT64_MAX;
+      mask |= (uint64_t) 1 << (numero - 1);
+    }
+  }
+  return mask;
+}
+
+/*
+ *   desdobramento(candidatos, garantia, acertos[, segundos[, threads]]) ->
+ *     '{"apostas":[...],"quantidade":K,"prova":{"subconjuntos":N,
+ *       "cobertos":N,"multiplicidade_minima":M,"limite_inferior":L}}'
+ *
+ * onde "apostas" são os bitmasks das apostas de 6 números e "prova" resulta
+ * da verificação exaustiva e independente da busca de que cada subconjunto
+ * de "acertos" candidatos compartilha ao menos "garantia" números com alguma
+ * aposta.
+*/
+static SEMPRE_INLINE void desdobramento(sqlite3_context *ctx, int argc, sqlite3_value **argv,
+  void *(*busca)(void *))
+{
+  sqlite3 *db = sqlite3_context_db_handle(ctx);
+  const uint64_t mask = candidatos(argv[0]);
+  desdobramento_t d;
+  busca_t *buscas = NULL;
+  pthread_t *ids = NULL;
+  char *criada = NULL;
+  volatile int interrompida = 0;
+  int elementos[MAX_CANDIDATOS], threads = sysconf(_SC_NPROCESSORS_ONLN);
+  double segundos = SEGUNDOS_PADRAO;
+  sqlite3_int64 cobertos = 0, minima = -1;
+  sqlite3_str *json;
+  uint64_t s;
+  int j, i, rc = SQLITE_OK;
+
+  memset(&d, 0, sizeof(d));
+  d.v = __builtin_popcountll(mask);
+  d.t = sqlite3_value_int(argv[1]);
+  d.m = sqlite3_value_int(argv[2]);
+  if (argc > 3) segundos = sqlite3_value_double(argv[3]);
+  if (argc > 4) threads = sqlite3_value_int(argv[4]);
+  if (mask >> N_DEZENAS || d.v < N_SORTEADAS || d.v > MAX_CANDIDATOS) {
+    sqlite3_result_error(ctx, "candidatos devem ser de 6 a 30 números entre 1 e 60", -1);
+    return;
+  }
+  if (d.t < 1 || d.t > N_SORTEADAS || d.m < d.t || d.m > N_SORTEADAS) {
+    sqlite3_result_error(ctx, "garantia e acertos devem estar entre 1 e 6" \
+      " com acertos não menor que a garantia", -1);
+    return;
+  }
+  if (!(segundos >= 0 && segundos <= MAX_SEGUNDOS) || threads < 1 || threads > MAX_THREADS) {
+    sqlite3_result_error(ctx, "segundos ou threads fora dos limites", -1);
+    return;
+  }
+  for (j = 0, s = mask; s; s &= s - 1) elementos[j++] = __builtin_ctzll(s);
+
+  d.blocos = BINOMIAL[d.v][d.m];
+  for (i = d.t; i <= d.m && i <= N_SORTEADAS; ++i) {
+    if (d.m - i <= d.v - N_SORTEADAS) {
+      d.n += BINOMIAL[N_SORTEADAS][i] * BINOMIAL[d.v - N_SORTEADAS][d.m - i];
+    }
+  }
+  d.limite = (d.blocos + d.n - 1) / d.n;
+  d.interrompida = &interrompida;
+  pthread_mutex_init(&d.mutex, NULL);
+
+  d.melhor = sqlite3_malloc64(BINOMIAL[d.v][N_SORTEADAS] * sizeof(uint32_t));
+  buscas = sqlite3_malloc64(threads * sizeof(busca_t));
+  ids = sqlite3_malloc64(threads * sizeof(pthread_t));
+  criada = sqlite3_malloc64(threads);
+  if (!d.melhor || !buscas || !ids || !criada) {
+    rc = SQLITE_NOMEM;
+    goto fim;
+  }
+  memset(buscas, 0, threads * sizeof(busca_t));
+  for (j = 0; j < threads; ++j) {
+    busca_t *b = &buscas[j];
+    b->d = &d;
+    b->semente = 0x9E3779B97F4A7C15ULL * (j + 1);
+    b->apostas = sqlite3_malloc64(BINOMIAL[d.v][N_SORTEADAS] * sizeof(uint32_t));
+    b->multiplicidade = sqlite3_malloc64(d.blocos * sizeof(uint32_t));
+    b->descobertos = sqlite3_malloc64(d.blocos * sizeof(uint32_t));
+    b->posicao = sqlite3_malloc64(d.blocos * sizeof(uint32_t));
+    b->saem = sqlite3_malloc64(d.n * sizeof(uint32_t));
+    b->entram = sqlite3_malloc64(d.n * sizeof(uint32_t));
+    if (!b->apostas || !b->multiplicidade || !b->descobertos || !b->posicao
+        || !b->saem || !b->entram) {
+      rc = SQLITE_NOMEM;
+      goto fim;
+    }
+  }
+
+  // bitmasks dos subconjuntos, em ordem colexicográfica, e coberturas
+  // pré-calculadas se couberem no limite, senão enumeradas sob demanda
+  d.subconjuntos = sqlite3_malloc64(d.blocos * sizeof(uint32_t));
+  if (!d.subconjuntos) {
+    rc = SQLITE_NOMEM;
+    goto fim;
+  }
+  for (j = 0, s = (1u << d.m) - 1; j < d.blocos; ++j, s = sucessor(s)) {
+    d.subconjuntos[j] = (uint32_t) s;
+  }
+  if (BINOMIAL[d.v][N_SORTEADAS] * d.n <= MAX_COBERTURAS) {
+    d.coberturas = sqlite3_malloc64(BINOMIAL[d.v][N_SORTEADAS] * d.n * sizeof(uint32_t));
+    if (d.coberturas) {
+      uint32_t aposta = (1u << N_SORTEADAS) - 1;
+      for (j = 0; j < BINOMIAL[d.v][N_SORTEADAS]; ++j, aposta = (uint32_t) sucessor(aposta)) {
+        enumera_cobertura(&d, aposta, d.coberturas + (sqlite3_int64) j * d.n);
+      }
+    }
+  }
+
+  rc = gulosa(&d, &buscas[0], db);
+  if (rc != SQLITE_OK) goto fim;
+
+  // busca local em paralelo até o prazo, com a thread principal verificando
+  // interrupções da conexão
+  d.prazo = agora() + segundos;
+  for (j = 1; j < threads; ++j) {
+    criada[j] = pthread_create(&ids[j], NULL, busca, &buscas[j]) == 0;
+  }
+  buscas[0].db = db;
+  busca(&buscas[0]);
+  for (j = 1; j < threads; ++j) {
+    if (criada[j]) pthread_join(ids[j], NULL);
+  }
+  if (interrompida) {
+    rc = SQLITE_INTERRUPT;
+    goto fim;
+  }
+
+  // prova da cobertura, independente das estruturas da busca
+  for (s = (1u << d.m) - 1; s < (1ULL << d.v); s = sucessor(s)) {
+    sqlite3_int64 multiplicidade = 0;
+    for (j = 0; j < d.nmelhor; ++j) {
+      multiplicidade += __builtin_popcountll(s & d.melhor[j]) >= d.t;
+    }
+    cobertos += multiplicidade > 0;
+    if (minima < 0 || multiplicidade < minima) minima = multiplicidade;
+  }
+  if (cobertos != d.blocos) {
+    sqlite3_result_error(ctx, "desdobramento não cobre todos os subconjuntos", -1);
+    goto fim;
+  }
+
+  json = sqlite3_str_new(db);
+  sqlite3_str_appendall(json, "{\"apostas\":[");
+  for (j = 0; j < d.nmelhor; ++j) {
+    sqlite3_str_appendf(json, j ? ",%lld" : "%lld",
+      (sqlite3_int64) expande(d.melhor[j], elementos));
+  }
+  sqlite3_str_appendf(json, "],\"quantidade\":%d,\"prova\":{\"subconjuntos\":%lld," \
+    "\"cobertos\":%lld,\"multiplicidade_minima\":%lld,\"limite_inferior\":%lld}}",
+    d.nmelhor, d.blocos, cobertos, minima, d.limite);
+  if (sqlite3_str_errcode(json) != SQLITE_OK) {
+    rc = sqlite3_str_errcode(json);
+    sqlite3_free(sqlite3_str_finish(json));
+    goto fim;
+  }
+  sqlite3_result_text(ctx, sqlite3_str_finish(json), -1, sqlite3_free);
+
+fim:
+  if (rc == SQLITE_NOMEM) {
+    sqlite3_result_error_nomem(ctx);
+  } else if (rc != SQLITE_OK) {
+    sqlite3_result_error_code(ctx, rc);
+  }
+  for (j = 0; buscas && j < threads; ++j) {
+    sqlite3_free(buscas[j].apostas);
+    sqlite3_free(buscas[j].multiplicidade);
+    sqlite3_free(buscas[j].descobertos);
+    sqlite3_free(buscas[j].posicao);
+    sqlite3_free(buscas[j].saem);
+    sqlite3_free(buscas[j].entram);
+  }
+  sqlite3_free(buscas);
+  sqlite3_free(ids);
+  sqlite3_free(criada);
+  sqlite3_free(d.melhor);
+  sqlite3_free(d.coberturas);
+  sqlite3_free(d.subconjuntos);
+  pthread_mutex_destroy(&d.mutex);
+}
+
+static void desdobramento_generico(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  desdobramento(ctx, argc, argv, busca_generica);
+}
+
+static POPCNT void desdobramento_popcnt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  desdobramento(ctx, argc, argv, busca_popcnt);
+}
+
+int sqlite3_combinacoes_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  static const struct {
+    const char *name;
+    int nargs;
+    int flags;
+    void (*func)(sqlite3_context *, int, sqlite3_value **);
+  } FUNCS[] = {
+    // acessam arquivos arbitrários, vedadas em views e triggers
+    { "COMB_BITMAP_MONTA", 1, SQLITE_UTF8 | SQLITE_DIRECTONLY, comb_bitmap_monta },
+    { "COMB_BITMAP_ABRE",  1, SQLITE_UTF8 | SQLITE_DIRECTONLY, comb_bitmap_abre },
+    { "COMB_SORTEADA",     1, SQLITE_UTF8, comb_sorteada },
+    { "COMB_NAO_SORTEADA", 1, SQLITE_UTF8, comb_nao_sorteada },
+  };
+  const int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+  bitmap_t *b;
+  int j;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  sqlite3_create_function(db, "COMB_RANK", 1, flags, NULL, comb_rank, NULL, NULL);
+  sqlite3_create_function(db, "COMB_UNRANK", 1, flags, NULL, comb_unrank, NULL, NULL);
+  sqlite3_create_function(db, "COMB_UNRANK", 2, flags, NULL, comb_unrank, NULL, NULL);
+  for (j = 3; j <= 5; ++j) {
+    sqlite3_create_function(db, "DESDOBRAMENTO", j, SQLITE_UTF8, NULL,
+      POPCNT_NATIVO() ? desdobramento_popcnt : desdobramento_generico, NULL, NULL);
+  }
+
+  /* bitmap exclusivo da conexão */
+
+  b = (bitmap_t *) sqlite3_malloc(sizeof(bitmap_t));
+  if (!b) return SQLITE_NOMEM;
+  memset(b, 0, sizeof(bitmap_t));
+
+  for (j = 0; j < sizeof(FUNCS) / sizeof(FUNCS[0]); ++j) {
+    ++b->refs;
+    sqlite3_create_function_v2(db, FUNCS[j].name, FUNCS[j].nargs, FUNCS[j].flags,
+      b, FUNCS[j].func, NULL, NULL, release_bitmap);
+  }
+  return sqlite3_create_module(db, "cobertura", &modulo_cobertura, NULL);
+}
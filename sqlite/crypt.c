@@ -3,6 +3,11 @@
  *
  *    MD5, ENC, DEC, GET_CRYTP, SET_CRYPT
  *
+ * Variantes para BLOBs armazenados, processados em blocos de tamanho fixo via
+ * "incremental blob I/O", com consumo constante de memória:
+ *
+ *    MD5_BLOB, ENC_BLOB, DEC_BLOB
+ *
  * Dependências:
  *
  *    pacotes libsqlite3-dev e libssl-dev
@@ -25,43 +30,141 @@ SQLITE_EXTENSION_INIT1
 #include <string.h>
 #include <stdlib.h>
 #include <openssl/md5.h>
+#include <openssl/evp.h>
 
 #if SQLITE_VERSION_NUMBER < 3007011
 #define sqlite3_stricmp(a, b) sqlite3_strnicmp((a), (b), strlen(a))
 #endif
 
+#define EXT_STATS_EXTENSAO "crypt"
+#include "ext-stats.h"
+
+/* tamanho dos blocos de bytes processados pelas variantes para BLOBs */
+#define CHUNK_SIZE 65536
+
+/*
+ * Formata o digest como string de 32 dígitos hexadecimais terminada com NUL
+ * no buffer de tamanho mínimo (MD5_DIGEST_LENGTH << 1) + 1.
+*/
+static char *hexdigest(const unsigned char *digest, char *rz)
+{
+  static const char HEX[] = "0123456789abcdef";
+  int i;
+
+  for (i = 0; i < MD5_DIGEST_LENGTH; i++)
+  {
+    rz[i << 1] = HEX[digest[i] >> 4];
+    rz[(i << 1) + 1] = HEX[digest[i] & 15];
+  }
+  rz[MD5_DIGEST_LENGTH << 1] = 0;
+
+  return rz;
+}
+
 /*
  * Retorna o MD5 128-bit checksum do argumento como string de 32 dígitos
  * hexadecimais ou NULL se o argumento é NULL.
+ *
+ * Se o argumento é BLOB, todos os seus bytes são considerados, inclusive
+ * eventuais NULs.
 */
 static void md5(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
   unsigned char digest[MD5_DIGEST_LENGTH];
-  unsigned char *z;
-  char *rz;
-  int i;
+  char rz[(MD5_DIGEST_LENGTH << 1) + 1];
+  const unsigned char *z;
+  int n;
+
+  switch (sqlite3_value_type(argv[0])) {
+    case SQLITE_NULL:
+      sqlite3_result_null(ctx);
+      return ;
+    case SQLITE_BLOB:
+      z = (const unsigned char *) sqlite3_value_blob(argv[0]);
+      break;
+    default:
+      z = (const unsigned char *) sqlite3_value_text(argv[0]);
+  }
+  n = sqlite3_value_bytes(argv[0]);
 
-  if (SQLITE_NULL == sqlite3_value_type(argv[0])) {
-    sqlite3_result_null(ctx);
+  if (!EVP_Digest(z, n, digest, NULL, EVP_md5(), NULL)) {
+    sqlite3_result_error(ctx, "falha no cálculo do MD5", -1);
     return ;
   }
-  z = (unsigned char *) sqlite3_value_text(argv[0]);
 
-  rz = sqlite3_malloc((MD5_DIGEST_LENGTH << 1) + 1);
-  if (!rz) {
-    sqlite3_result_error_nomem(ctx);
-    return ;
+  sqlite3_result_text(ctx, hexdigest(digest, rz), -1, SQLITE_TRANSIENT);
+}
+
+/*
+ * Abre o BLOB identificado pelos argumentos (tabela, coluna, rowid) para
+ * leitura ou escrita conforme "flags", notificando eventual falha como erro.
+*/
+static sqlite3_blob *abre_blob(sqlite3_context *ctx, sqlite3_value **argv, int flags)
+{
+  sqlite3 *db = sqlite3_context_db_handle(ctx);
+  sqlite3_blob *blob;
+  const char *tabela, *coluna;
+  char *z;
+
+  if (SQLITE_NULL == sqlite3_value_type(argv[0])
+      || SQLITE_NULL == sqlite3_value_type(argv[1])
+      || SQLITE_INTEGER != sqlite3_value_numeric_type(argv[2])) {
+    sqlite3_result_error(ctx,
+      "argumentos devem ser nome da tabela, nome da coluna e rowid", -1);
+    return NULL;
   }
+  tabela = (const char *) sqlite3_value_text(argv[0]);
+  coluna = (const char *) sqlite3_value_text(argv[1]);
 
-  MD5(z, strlen((char *) z), (unsigned char *) &digest);
+  if (SQLITE_OK != sqlite3_blob_open(db, "main", tabela, coluna,
+        sqlite3_value_int64(argv[2]), flags, &blob)) {
+    z = sqlite3_mprintf("BLOB inacessível: %s", sqlite3_errmsg(db));
+    sqlite3_result_error(ctx, z, -1);
+    sqlite3_free(z);
+    sqlite3_blob_close(blob);
+    return NULL;
+  }
+  return blob;
+}
 
-  for (i = 0; i < MD5_DIGEST_LENGTH; i++)
-  {
-    sqlite3_snprintf(3, rz + (i << 1), "%02x", (unsigned int) digest[i]);
+/*
+ * Retorna o MD5 128-bit checksum do BLOB armazenado na coluna e registro
+ * identificados pelos argumentos (tabela, coluna, rowid), como string de
+ * 32 dígitos hexadecimais, lendo o conteúdo em blocos de CHUNK_SIZE bytes.
+*/
+static void md5_blob(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  unsigned char digest[MD5_DIGEST_LENGTH];
+  char rz[(MD5_DIGEST_LENGTH << 1) + 1];
+  unsigned char *buffer;
+  sqlite3_blob *blob;
+  EVP_MD_CTX *md;
+  int n, j, k, rc;
+
+  if (!(blob = abre_blob(ctx, argv, 0))) return ;
+
+  buffer = sqlite3_malloc(CHUNK_SIZE);
+  md = EVP_MD_CTX_new();
+  if (!buffer || !md) {
+    sqlite3_result_error_nomem(ctx);
+  } else {
+    rc = EVP_DigestInit_ex(md, EVP_md5(), NULL);
+    for (n = sqlite3_blob_bytes(blob), j = 0; rc && j < n; j += k)
+    {
+      k = (n - j < CHUNK_SIZE) ? n - j : CHUNK_SIZE;
+      rc = SQLITE_OK == sqlite3_blob_read(blob, buffer, k, j)
+           && EVP_DigestUpdate(md, buffer, k);
+    }
+    if (rc && EVP_DigestFinal_ex(md, digest, NULL)) {
+      sqlite3_result_text(ctx, hexdigest(digest, rz), -1, SQLITE_TRANSIENT);
+    } else {
+      sqlite3_result_error(ctx, "falha na leitura do BLOB", -1);
+    }
   }
 
-  sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
-  sqlite3_free(rz);
+  EVP_MD_CTX_free(md);
+  sqlite3_free(buffer);
+  sqlite3_blob_close(blob);
 }
 
 static unsigned char lrotate(unsigned char val, int n)
@@ -155,26 +258,80 @@ typedef struct crypt_s
   char *method;
   char (*cifrar_char)(char c, char k);
   char (*decifrar_char)(char c, char k);
+  /* tabelas de substituição indexadas pelo byte da chave e byte do texto,
+     montadas na vinculação do método, dispensando chamadas por ponteiro */
+  unsigned char cifra[256][256];
+  unsigned char decifra[256][256];
+  /* quantidade de funções SQL que compartilham a instância */
+  int refs;
 }
 crypt_t;
 
-static crypt_t engine;  // var global iniciada com NULLs
+/*
+ * Cada conexão que carrega a extensão tem sua própria instância do engine,
+ * vinculada às funções SQL como "user data" e liberada quando a última
+ * dessas funções é descartada, i.e.; no fechamento da conexão.
+*/
+static void release_engine(void *ptr)
+{
+  crypt_t *engine = (crypt_t *) ptr;
+  if (--engine->refs == 0) sqlite3_free(engine);
+}
+
+/*
+ * Monta as tabelas de substituição do engine conforme funções do método.
+*/
+static void monta_tabelas(crypt_t *e)
+{
+  int c, k;
+
+  for (k = 0; k < 256; ++k) {
+    for (c = 0; c < 256; ++c) {
+      e->cifra[k][c] = (unsigned char) e->cifrar_char((char) c, (char) k);
+      e->decifra[k][c] = (unsigned char) e->decifrar_char((char) c, (char) k);
+    }
+  }
+}
+
+/*
+ * Aplica a tabela de substituição aos "n" bytes de "src", gravando o
+ * resultado em "dst", tal que "offset" é a posição absoluta do primeiro
+ * byte no texto original, que determina o alinhamento com a chave.
+ *
+ * O laço interno percorre trechos alinhados à chave sem aritmética modular,
+ * viabilizando "unrolling" e "pipelining" pelo compilador.
+*/
+static void aplica_tabela(const unsigned char tabela[256][256],
+  const unsigned char *chave, int k, sqlite3_int64 offset,
+  const unsigned char *src, unsigned char *dst, int n)
+{
+  int i, j = (int) (offset % k), m;
+
+  for (i = 0; i < n; j = 0) {
+    m = (k - j < n - i) ? k - j : n - i;
+    for (m += i; i < m; ++i, ++j) dst[i] = tabela[chave[j]][src[i]];
+  }
+}
 
 /*
  * Retorna texto cifrado usando criptografia por chave simétrica, tal que os
  * argumentos são a chave criptográfica e o texto.
  *
+ * Se o texto é BLOB, então o resultado também é BLOB de mesmo tamanho,
+ * considerando todos os seus bytes, inclusive eventuais NULs.
+ *
  * ENC é a função inversa de DEC:
  *
  *    SELECT ENC(chave, DEC(chave, texto)) == texto;
 */
 static void enc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  const char *chave, *texto;
-  char *cifrado;
-  int j, k;
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
+  const unsigned char *chave, *texto;
+  unsigned char buffer[256], *cifrado;
+  int k, n, is_blob;
 
-  if (!engine.method) {
+  if (!engine->method) {
     sqlite3_result_error(ctx, "método criptográfico não definido", -1);
     return ;
   }
@@ -183,39 +340,43 @@ static void enc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     sqlite3_result_error(ctx, "chave criptográfica é NULL", -1);
     return ;
   }
-  chave = (char *) sqlite3_value_text(argv[0]);
-  if (strlen(chave) == 0) {
+  chave = sqlite3_value_text(argv[0]);
+  if ((k = sqlite3_value_bytes(argv[0])) == 0) {
     sqlite3_result_error(ctx, "chave de comprimento zero", -1);
     return ;
   }
 
-  if (SQLITE_NULL == sqlite3_value_type(argv[1])) {
-    sqlite3_result_null(ctx);
-    return ;
+  switch (sqlite3_value_type(argv[1])) {
+    case SQLITE_NULL:
+      sqlite3_result_null(ctx);
+      return ;
+    case SQLITE_BLOB:
+      is_blob = 1;
+      texto = sqlite3_value_blob(argv[1]);
+      break;
+    default:
+      is_blob = 0;
+      texto = sqlite3_value_text(argv[1]);
   }
-  texto = (char *) sqlite3_value_text(argv[1]);
+  n = sqlite3_value_bytes(argv[1]);
 
-  cifrado = sqlite3_malloc( strlen(texto) + 1 );
+  /* textos curtos são copiados do buffer, os demais transferidos */
+  cifrado = (n < sizeof(buffer)) ? buffer : sqlite3_malloc(n + 1);
   if (!cifrado) {
     sqlite3_result_error_nomem(ctx);
     return ;
   }
 
-  if (argc >= 0) {
-    for (k = strlen(chave), j = 0; texto[j]; ++j)
-    {
-      cifrado[j] = engine.cifrar_char(texto[j], chave[j%k]);
-    }
+  aplica_tabela((argc >= 0) ? engine->cifra : engine->decifra, chave, k, 0,
+    texto, cifrado, n);
+  cifrado[n] = 0;
+
+  if (is_blob) {
+    sqlite3_result_blob(ctx, cifrado, n, (cifrado == buffer) ? SQLITE_TRANSIENT : sqlite3_free);
   } else {
-    for (k = strlen(chave), j = 0; texto[j]; ++j)
-    {
-      cifrado[j] = engine.decifrar_char(texto[j], chave[j%k]);
-    }
+    sqlite3_result_text(ctx, (char *) cifrado, n,
+      (cifrado == buffer) ? SQLITE_TRANSIENT : sqlite3_free);
   }
-  cifrado[j] = 0;
-
-  sqlite3_result_text(ctx, cifrado, -1, SQLITE_TRANSIENT);
-  sqlite3_free(cifrado);
 }
 
 /*
@@ -232,13 +393,84 @@ static void dec(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 }
 
 /*
- * Informa o nome do método incumbente de criptografia de caracteres, senão
- * notifica a indefinição como erro, cancelando requisições encadeadas.
+ * Cifra "in place" o BLOB armazenado na coluna e registro identificados pelos
+ * argumentos (chave, tabela, coluna, rowid), processando-o em blocos de
+ * CHUNK_SIZE bytes, retornando a quantidade de bytes processados.
+ *
+ * ENC_BLOB é a função inversa de DEC_BLOB.
+*/
+static void enc_blob(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
+  const unsigned char *chave;
+  unsigned char *buffer;
+  sqlite3_blob *blob;
+  int n, j, k, m, rc;
+
+  if (!engine->method) {
+    sqlite3_result_error(ctx, "método criptográfico não definido", -1);
+    return ;
+  }
+
+  if (SQLITE_NULL == sqlite3_value_type(argv[0])) {
+    sqlite3_result_error(ctx, "chave criptográfica é NULL", -1);
+    return ;
+  }
+  chave = sqlite3_value_text(argv[0]);
+  if ((k = sqlite3_value_bytes(argv[0])) == 0) {
+    sqlite3_result_error(ctx, "chave de comprimento zero", -1);
+    return ;
+  }
+
+  if (!(blob = abre_blob(ctx, argv+1, 1))) return ;
+
+  buffer = sqlite3_malloc(CHUNK_SIZE);
+  if (!buffer) {
+    sqlite3_result_error_nomem(ctx);
+  } else {
+    rc = SQLITE_OK;
+    for (n = sqlite3_blob_bytes(blob), j = 0; rc == SQLITE_OK && j < n; j += m)
+    {
+      m = (n - j < CHUNK_SIZE) ? n - j : CHUNK_SIZE;
+      rc = sqlite3_blob_read(blob, buffer, m, j);
+      if (rc == SQLITE_OK) {
+        aplica_tabela((argc > 0) ? engine->cifra : engine->decifra, chave, k, j,
+          buffer, buffer, m);
+        rc = sqlite3_blob_write(blob, buffer, m, j);
+      }
+    }
+    if (rc == SQLITE_OK) {
+      sqlite3_result_int(ctx, n);
+    } else {
+      sqlite3_result_error_code(ctx, rc);
+    }
+    sqlite3_free(buffer);
+  }
+
+  sqlite3_blob_close(blob);
+}
+
+/*
+ * Decifra "in place" o BLOB armazenado na coluna e registro identificados
+ * pelos argumentos (chave, tabela, coluna, rowid), processando-o em blocos de
+ * CHUNK_SIZE bytes, retornando a quantidade de bytes processados.
+ *
+ * DEC_BLOB é a função inversa de ENC_BLOB.
+*/
+static void dec_blob(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  enc_blob(ctx, -argc, argv);
+}
+
+/*
+ * Informa o nome do método incumbente de criptografia de caracteres da conexão,
+ * senão notifica a indefinição como erro, cancelando requisições encadeadas.
 */
 static void get_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  if (engine.method) {
-    sqlite3_result_text(ctx, engine.method, -1, SQLITE_TRANSIENT);
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
+  if (engine->method) {
+    sqlite3_result_text(ctx, engine->method, -1, SQLITE_STATIC);
   } else {
     sqlite3_result_error(ctx, "método criptográfico não definido", -1);
   }
@@ -248,33 +480,34 @@ static void get_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
  * Configura o engine de criptografia de caracteres vinculando as funções do
  * método que corresponde ao argumento.
 */
-static void bind_method(const char *method)
+static void bind_method(crypt_t *engine, const char *method)
 {
   if (sqlite3_stricmp(method, "both") == 0) {
-    engine.method = "both";
-    engine.cifrar_char = both_cifrar_char;
-    engine.decifrar_char = both_decifrar_char;
+    engine->method = "both";
+    engine->cifrar_char = both_cifrar_char;
+    engine->decifrar_char = both_decifrar_char;
   } else if (sqlite3_stricmp(method, "twin") == 0) {
-    engine.method = "twin";
-    engine.cifrar_char = twin_cifrar_char;
-    engine.decifrar_char = twin_cifrar_char;
+    engine->method = "twin";
+    engine->cifrar_char = twin_cifrar_char;
+    engine->decifrar_char = twin_cifrar_char;
   } else if (sqlite3_stricmp(method, "single") == 0) {
-    engine.method = "single";
-    engine.cifrar_char = single_cifrar_char;
-    engine.decifrar_char = single_decifrar_char;
+    engine->method = "single";
+    engine->cifrar_char = single_cifrar_char;
+    engine->decifrar_char = single_decifrar_char;
   } else if (sqlite3_stricmp(method, "usual") == 0) {
-    engine.method = "usual";
-    engine.cifrar_char = usual_cifrar_char;
-    engine.decifrar_char = usual_decifrar_char;
+    engine->method = "usual";
+    engine->cifrar_char = usual_cifrar_char;
+    engine->decifrar_char = usual_decifrar_char;
   } else if (sqlite3_stricmp(method, "alternate") == 0) {
-    engine.method = "alternate";
-    engine.cifrar_char = alternate_cifrar_char;
-    engine.decifrar_char = alternate_decifrar_char;
+    engine->method = "alternate";
+    engine->cifrar_char = alternate_cifrar_char;
+    engine->decifrar_char = alternate_decifrar_char;
   } else if (sqlite3_stricmp(method, "naive") == 0) {
-    engine.method = "naive";
-    engine.cifrar_char = naive_cifrar_char;
-    engine.decifrar_char = naive_cifrar_char;
+    engine->method = "naive";
+    engine->cifrar_char = naive_cifrar_char;
+    engine->decifrar_char = naive_cifrar_char;
   }
+  if (engine->method) monta_tabelas(engine);
 }
 
 #define IS_SPACE(c) (((c) == 0x20) || (((c) >= 0x09) && ((c) <= 0x0D)))
@@ -306,13 +539,51 @@ static const char *trim(const char *src)
   return e;
 }
 
+#if SQLITE_VERSION_NUMBER >= 3007013
+/*
+ * Checa o esquema da tabela PROPERTIES, recriando-a se incompatível ou
+ * inexistente, postergada até a primeira definição de método para que a
+ * carga da extensão não modifique o db.
+*/
+static void prepara_properties(sqlite3 *db)
+{
+  const char *CREATE_TABLE = "CREATE TABLE IF NOT EXISTS properties" \
+    "(key TEXT NOT NULL UNIQUE ON CONFLICT IGNORE, value TEXT NOT NULL);";
+
+  sqlite3_stmt *stmt;
+  char *s, *z;
+  int n;
+
+  /* check-up do esquema da tabela PROPERTIES */
+
+  sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE " \
+    "type == 'table' AND name == 'properties';", -1, &stmt, NULL);
+  if (SQLITE_ROW == sqlite3_step(stmt)) {
+    for (s = (char *) sqlite3_column_text(stmt, 0); *s != '('; ++s) ;
+    for (z = (char *) CREATE_TABLE; *z != '('; ++z) ;
+    n = sqlite3_strnicmp(s, z, strlen(s));
+    sqlite3_finalize(stmt);
+    if (n) {
+      sqlite3_exec(db, "DROP TABLE IF EXISTS properties;", NULL, NULL, NULL);
+    }
+  } else {
+    sqlite3_finalize(stmt);
+  }
+
+  /* criação redundante da tabela */
+
+  sqlite3_exec(db, CREATE_TABLE, NULL, NULL, NULL);
+}
+#endif
+
 /*
  * Procedimento para definir o método incumbente de criptografia de caracteres
- * conforme seu nome que é o argumento único esperado e se for ilegal, o erro
- * será notificado seguido da lista de nomes válidos.
+ * da conexão, conforme seu nome que é o argumento único esperado e se for
+ * ilegal, o erro será notificado seguido da lista de nomes válidos.
 */
 static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
   char *s, *z = NULL;
   int j;
 
@@ -322,18 +593,19 @@ static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     s = (char *) trim((const char *) sqlite3_value_text(argv[0]));
     if (!s) {
       z ="o argumento é uma string vazia";
-    } else if (!engine.method || sqlite3_stricmp(s, engine.method)) {
+    } else if (!engine->method || sqlite3_stricmp(s, engine->method)) {
       // pesquisa a string no array de nomes de métodos
       for (j = 0; j < NUM_METHODS && sqlite3_stricmp(s, METHODS[j]); ++j) ;
       if (j == NUM_METHODS) {
         z = "método é desconhecido";
       } else {
         // vincula o método ao engine de criptografia
-        bind_method(s);
+        bind_method(engine, s);
 #if SQLITE_VERSION_NUMBER >= 3007013
 {
   // preserva o nome do método para uso persistente entre sessões
   sqlite3_stmt *stmt;
+  prepara_properties(sqlite3_context_db_handle(ctx));
   sqlite3_prepare_v2(sqlite3_context_db_handle(ctx),
     "INSERT OR REPLACE INTO properties VALUES ('method', ?);", -1, &stmt, NULL);
   sqlite3_bind_text(stmt, 1, s, -1, NULL);
@@ -365,55 +637,66 @@ static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   }
 }
 
-int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+int sqlite3_crypt_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
 {
+  static const struct {
+    const char *name;
+    int nargs;
+    void (*func)(sqlite3_context *, int, sqlite3_value **);
+  } FUNCS[] = {
+    { "ENC",       2, enc },
+    { "DEC",       2, dec },
+    { "ENC_BLOB",  4, enc_blob },
+    { "DEC_BLOB",  4, dec_blob },
+    { "GET_CRYPT", 0, get_crypt },
+    { "SET_CRYPT", 1, set_crypt },
+  };
+  crypt_t *engine;
+  int j;
+
   SQLITE_EXTENSION_INIT2(api)
 
   sqlite3_create_function(db, "MD5",  1, SQLITE_UTF8, NULL, md5, NULL, NULL);
-  sqlite3_create_function(db, "ENC",  2, SQLITE_UTF8, NULL, enc, NULL, NULL);
-  sqlite3_create_function(db, "DEC",  2, SQLITE_UTF8, NULL, dec, NULL, NULL);
-  sqlite3_create_function(db, "GET_CRYPT", 0, SQLITE_UTF8, NULL, get_crypt, NULL, NULL);
-  sqlite3_create_function(db, "SET_CRYPT", 1, SQLITE_UTF8, NULL, set_crypt, NULL, NULL);
+  sqlite3_create_function(db, "MD5_BLOB", 3, SQLITE_UTF8, NULL, md5_blob, NULL, NULL);
+
+  /* instância do engine exclusiva da conexão */
+
+  engine = (crypt_t *) sqlite3_malloc(sizeof(crypt_t));
+  if (!engine) return SQLITE_NOMEM;
+  memset(engine, 0, sizeof(crypt_t));
+
+  for (j = 0; j < sizeof(FUNCS) / sizeof(FUNCS[0]); ++j) {
+    ++engine->refs;
+    sqlite3_create_function_v2(db, FUNCS[j].name, FUNCS[j].nargs, SQLITE_UTF8,
+      engine, FUNCS[j].func, NULL, NULL, release_engine);
+  }
 
 #if SQLITE_VERSION_NUMBER >= 3007013
   {
-    const char *CREATE_TABLE = "CREATE TABLE IF NOT EXISTS properties" \
-      "(key TEXT NOT NULL UNIQUE ON CONFLICT IGNORE, value TEXT NOT NULL);";
-
     sqlite3_stmt *stmt;
-    char *s, *z;
+    const char *s;
     int n;
 
-    /* check-up do esquema da tabela PROPERTIES */
+    /* configuração persistente do engine criptográfico, se disponível,
+       evitando erro que seria notificado na abertura da conexão quando
+       a extensão é registrada via sqlite3_auto_extension */
 
-    sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE " \
+    sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE " \
       "type == 'table' AND name == 'properties';", -1, &stmt, NULL);
-    if (SQLITE_ROW == sqlite3_step(stmt)) {
-      for (s = (char *) sqlite3_column_text(stmt, 0); *s != '('; ++s) ;
-      for (z = (char *) CREATE_TABLE; *z != '('; ++z) ;
-      if (sqlite3_strnicmp(s, z, strlen(s))) {
-        sqlite3_prepare_v2(db,
-          "DROP TABLE IF EXISTS properties;", -1, &stmt, NULL);
-        sqlite3_step(stmt);
-      }
+    n = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    if (n == SQLITE_ROW) {
+      sqlite3_prepare_v2(db,
+        "SELECT value FROM properties WHERE key == 'method';", -1, &stmt, NULL);
     }
-
-    /* criação redundante da tabela */
-
-    sqlite3_prepare_v2(db, CREATE_TABLE, -1, &stmt, NULL);
-    sqlite3_step(stmt);
-
-    /* configuração persistente do engine criptográfico */
-
-    sqlite3_prepare_v2(db,
-      "SELECT value FROM properties WHERE key == 'method';", -1, &stmt, NULL);
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
       // recupera valor associado a chave 'method'
-      s = (char *) sqlite3_column_text(stmt, 0);
+      s = (const char *) sqlite3_column_text(stmt, 0);
       // pesquisa o valor no array de nomes de métodos
       for (n = 0; n < NUM_METHODS; ++n) {
         if (sqlite3_stricmp(s, METHODS[n]) == 0) {
-          bind_method(s);
+          bind_method(engine, s);
           break;
         }
       }
@@ -423,5 +706,5 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
   }
 #endif
 
-  return 0;
+  return ext_stats_inicia(db);
 }
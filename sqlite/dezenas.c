@@ -0,0 +1,1388 @@
+/*
+ * Tabelas virtuais "eponymous" derivadas da tabela "concursos":
+ *
+ *    DEZENAS_SORTEADAS (concurso, dezena)
+ *
+ *    ESTADO_EM (dezena, frequencia, latencia, concurso HIDDEN)
+ *
+ *    REINCIDENCIAS (concurso, lag, mascara, quantidade, persistentes,
+ *                   n_persistentes, maior_sequencia, lag_max HIDDEN)
+ *
+ *    TRANSICOES (lag, a, b, contagem, esperado, residuo, lag_max HIDDEN)
+ *
+ * DEZENAS_SORTEADAS tem o mesmo formato da tabela de conveniência homônima
+ * criada em "sql/monta.sql".
+ * Cada registro de "concursos" é desmembrado sob demanda em seis linhas, uma
+ * por dezena sorteada em ordem crescente, com "rowid" sequencial na mesma
+ * numeração da tabela preenchida pelos "triggers", dispensando seu
+ * armazenamento, seu índice e as escritas a cada inserção.
+ *
+ * Restrições de igualdade e de intervalo sobre "concurso" e "dezena" são
+ * repassadas à consulta interna de "concursos", que usa a chave primária, e a
+ * ordenação por "concurso" ou "concurso, dezena" é atendida diretamente.
+ *
+ * A tabela virtual só é visível quando o db não contém a tabela homônima,
+ * removida via "sql/dezenas-virtuais.sql", e requer o carregamento desta
+ * extensão em todas as sessões que a consultem, inclusive as de atualização.
+ *
+ * ESTADO_EM é a "table-valued function" das frequências e latências dos 60
+ * números imediatamente após qualquer concurso, tal como "info_dezenas" se a
+ * série terminasse nele, incluindo os números jamais sorteados com frequência
+ * zero e latência NULL:
+ *
+ *    SELECT * FROM estado_em(1000);
+ *
+ * ou a sequência dos estados após cada concurso de um intervalo, i.e.; a
+ * matriz N×60 das séries temporais, na ordem dos concursos e das dezenas:
+ *
+ *    SELECT concurso, dezena, frequencia, latencia FROM estado_em
+ *      WHERE concurso BETWEEN 1 AND 2000;
+ *
+ * A série dos concursos é mantida em memória por conexão e esquema como
+ * bitmasks das dezenas sorteadas, com as frequências e os concursos mais
+ * recentes de cada número acumulados a cada 64 concursos, de modo que cada
+ * estado isolado custa no máximo 63 aplicações de bitmasks a partir do
+ * acúmulo anterior e cada estado seguinte da sequência custa uma única
+ * aplicação. A memória é recarregada quando a tabela "concursos" do esquema
+ * é modificada.
+ *
+ * A "table-valued function" ESTADO_EM, inclusive qualificada por esquema,
+ * consulta "main.concursos". Para dbs anexados a instância deve ser criada
+ * com o nome do esquema como argumento, mantendo sua própria série:
+ *
+ *    CREATE VIRTUAL TABLE temp.estado_aux USING estado_em(aux);
+ *    SELECT * FROM estado_aux(1000);
+ *
+ * REINCIDENCIAS é a "table-valued function" das dezenas reincidentes de cada
+ * concurso nos "lag_max" concursos anteriores, por padrão apenas o anterior,
+ * obtida numa única passagem por "dezenas_juntadas":
+ *
+ *    SELECT concurso, mascara FROM reincidencias(1) WHERE quantidade > 0;
+ *
+ * Para cada concurso e cada lag de 1 a "lag_max" cujo concurso "concurso-lag"
+ * existe, "mascara" é o bitmask das dezenas sorteadas em ambos, "quantidade"
+ * é sua contagem, "persistentes" é o bitmask das dezenas sorteadas em todos
+ * os concursos de "concurso-lag" a "concurso", "n_persistentes" é sua
+ * contagem e "maior_sequencia" é a maior quantidade de concursos consecutivos
+ * terminados em "concurso" em que alguma de suas dezenas foi sorteada.
+ *
+ * TRANSICOES é a "table-valued function" da matriz 60×60 de transições de
+ * cada lag de 1 a "lag_max", por padrão 1, obtida numa única passagem por
+ * "dezenas_juntadas": para cada par de concursos distantes exatamente "lag",
+ * "contagem" é a quantidade de pares com o número "a" sorteado no anterior
+ * e "b" no posterior, "esperado" é a contagem esperada se independentes e
+ * "residuo" é o resíduo padronizado ajustado, aproximadamente normal padrão:
+ *
+ *    SELECT lag, a, b, contagem, residuo FROM transicoes(3)
+ *      WHERE abs(residuo) > 3.5;
+ *
+ * Concurso repetido em "dezenas_juntadas" interrompe TRANSICOES com erro.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc dezenas.c -Wall -fPIC -shared -lm -o dezenas.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/dezenas.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/dezenas.so");
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+
+/* quantidade de dezenas sorteadas por concurso */
+#define N_SORTEADAS 6
+
+/* quantidade de números da Mega-Sena */
+#define N_DEZENAS 60
+
+enum colunas { COL_CONCURSO = 0, COL_DEZENA };
+
+/*
+ * Bits de "idxNum" indicando as restrições repassadas a xFilter, na ordem dos
+ * respectivos argumentos: para cada coluna, igualdade ou limites inferior e
+ * superior.
+*/
+#define CONCURSO_EQ   1
+#define CONCURSO_MIN  2
+#define CONCURSO_MAX  4
+#define DEZENA_EQ     8
+#define DEZENA_MIN    16
+#define DEZENA_MAX    32
+#define ORDEM_DESC    64
+
+typedef struct tabela_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+  char *schema;
+}
+tabela_t;
+
+typedef struct cursor_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt;
+  sqlite3_int64 concurso;
+  int dezenas[N_SORTEADAS];
+  int j;                    /* índice da dezena corrente */
+  int dmin, dmax;           /* intervalo das dezenas */
+  int desc;                 /* flag de ordem decrescente */
+  int eof;
+}
+cursor_t;
+
+static int xConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(concurso INTEGER, dezena INTEGER)");
+  if (rc != SQLITE_OK) return rc;
+#ifdef SQLITE_VTAB_INNOCUOUS
+  // consultada pelas views "info_dezenas" e "acertos" e pelos triggers
+  sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->db = db;
+  t->schema = sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int xDisconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(((tabela_t *) vtab)->schema);
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+/* bit da restrição conforme a coluna e o operador ou zero se inaplicável */
+static int restricao(int coluna, int op)
+{
+  int base = (coluna == COL_CONCURSO) ? CONCURSO_EQ : DEZENA_EQ;
+  switch (op) {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      return base;
+    case SQLITE_INDEX_CONSTRAINT_GT:
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      return base << 1;
+    case SQLITE_INDEX_CONSTRAINT_LT:
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      return base << 2;
+  }
+  return 0;
+}
+
+/*
+ * As restrições são convertidas em intervalos fechados em xFilter e avaliadas
+ * novamente pelo SQLite, visto que o tipo dos valores comparados é arbitrário.
+*/
+static int xBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j, k, bits = 0, argv = 0;
+  int usadas[6] = { -1, -1, -1, -1, -1, -1 };
+  double linhas = 3000.0 * N_SORTEADAS;
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    int bit;
+    if (!c->usable || (c->iColumn != COL_CONCURSO && c->iColumn != COL_DEZENA)) continue;
+    if ((bit = restricao(c->iColumn, c->op)) && !(bits & bit)) {
+      bits |= bit;
+      for (k = 0; (1 << k) != bit; ++k) ;
+      usadas[k] = j;
+    }
+  }
+  // a igualdade dispensa os limites da mesma coluna
+  if (bits & CONCURSO_EQ) {
+    bits &= ~(CONCURSO_MIN|CONCURSO_MAX);
+    usadas[1] = usadas[2] = -1;
+  }
+  if (bits & DEZENA_EQ) {
+    bits &= ~(DEZENA_MIN|DEZENA_MAX);
+    usadas[4] = usadas[5] = -1;
+  }
+  for (k = 0; k < 6; ++k) {
+    if (usadas[k] >= 0) info->aConstraintUsage[usadas[k]].argvIndex = ++argv;
+  }
+
+  if (bits & CONCURSO_EQ) {
+    linhas = N_SORTEADAS;
+  } else if ((bits & (CONCURSO_MIN|CONCURSO_MAX)) == (CONCURSO_MIN|CONCURSO_MAX)) {
+    linhas /= 10;
+  } else if (bits & (CONCURSO_MIN|CONCURSO_MAX)) {
+    linhas /= 3;
+  }
+  if (bits & DEZENA_EQ) {
+    linhas /= 10;
+  } else if (bits & (DEZENA_MIN|DEZENA_MAX)) {
+    linhas /= 3;
+  }
+
+  // ordenação por "concurso" ou "concurso, dezena" no mesmo sentido
+  if (info->nOrderBy >= 1 && info->nOrderBy <= 2
+      && info->aOrderBy[0].iColumn == COL_CONCURSO
+      && (info->nOrderBy == 1 || (info->aOrderBy[1].iColumn == COL_DEZENA
+          && info->aOrderBy[1].desc == info->aOrderBy[0].desc))) {
+    info->orderByConsumed = 1;
+    if (info->aOrderBy[0].desc) bits |= ORDEM_DESC;
+  }
+
+  info->idxNum = bits;
+  info->estimatedRows = (sqlite3_int64) linhas;
+  info->estimatedCost = linhas;
+  return SQLITE_OK;
+}
+
+static int xOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cursor_t *c = sqlite3_malloc(sizeof(cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int xClose(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_finalize(((cursor_t *) cur)->stmt);
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+static int compara(const void *a, const void *b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+/* carrega as dezenas do próximo concurso com alguma no intervalo */
+static int proximo_concurso(cursor_t *c)
+{
+  int rc, j;
+
+  while ((rc = sqlite3_step(c->stmt)) == SQLITE_ROW) {
+    c->concurso = sqlite3_column_int64(c->stmt, 0);
+    for (j = 0; j < N_SORTEADAS; ++j) {
+      c->dezenas[j] = sqlite3_column_int(c->stmt, j+1);
+    }
+    qsort(c->dezenas, N_SORTEADAS, sizeof(int), compara);
+    for (j = 0; j < N_SORTEADAS; ++j) {
+      int dz = c->dezenas[c->desc ? N_SORTEADAS-1-j : j];
+      if (dz >= c->dmin && dz <= c->dmax) {
+        c->j = j;
+        return SQLITE_OK;
+      }
+    }
+  }
+  c->eof = 1;
+  return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+/* dezena corrente conforme o sentido da ordenação */
+static int dezena(cursor_t *c)
+{
+  return c->dezenas[c->desc ? N_SORTEADAS-1-c->j : c->j];
+}
+
+static int xNext(sqlite3_vtab_cursor *cur)
+{
+  cursor_t *c = (cursor_t *) cur;
+
+  while (++c->j < N_SORTEADAS) {
+    int dz = dezena(c);
+    if (dz >= c->dmin && dz <= c->dmax) return SQLITE_OK;
+  }
+  return proximo_concurso(c);
+}
+
+/*
+ * Limite inteiro inclusivo de uma restrição sobre coluna inteira, ou o
+ * próprio limite padrão se o valor não é numérico.
+*/
+static sqlite3_int64 inclusivo(sqlite3_value *v, int inferior, sqlite3_int64 padrao)
+{
+  double d;
+  switch (sqlite3_value_numeric_type(v)) {
+    case SQLITE_INTEGER:
+      return sqlite3_value_int64(v);
+    case SQLITE_FLOAT:
+      d = sqlite3_value_double(v);
+      if (d < -9e18 || d > 9e18) return padrao;
+      return (sqlite3_int64) (inferior ? ceil(d) : floor(d));
+  }
+  return padrao;
+}
+
+static int xFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  cursor_t *c = (cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  sqlite3_int64 cmin = 0, cmax = LLONG_MAX, dmin = 1, dmax = N_DEZENAS;
+  int n = 0, rc;
+  char *sql;
+
+  if (idxNum & CONCURSO_EQ) {
+    cmin = inclusivo(argv[n], 1, cmin);
+    cmax = inclusivo(argv[n++], 0, cmax);
+  }
+  if (idxNum & CONCURSO_MIN) cmin = inclusivo(argv[n++], 1, cmin);
+  if (idxNum & CONCURSO_MAX) cmax = inclusivo(argv[n++], 0, cmax);
+  if (idxNum & DEZENA_EQ) {
+    dmin = inclusivo(argv[n], 1, dmin);
+    dmax = inclusivo(argv[n++], 0, dmax);
+  }
+  if (idxNum & DEZENA_MIN) dmin = inclusivo(argv[n++], 1, dmin);
+  if (idxNum & DEZENA_MAX) dmax = inclusivo(argv[n++], 0, dmax);
+
+  sqlite3_finalize(c->stmt);
+  c->stmt = NULL;
+  c->eof = 0;
+  c->desc = (idxNum & ORDEM_DESC) != 0;
+  c->dmin = (int) (dmin < 1 ? 1 : dmin);
+  c->dmax = (int) (dmax > N_DEZENAS ? N_DEZENAS : dmax);
+  if (cmin > cmax || c->dmin > c->dmax) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+
+  sql = sqlite3_mprintf("SELECT concurso, dezena1, dezena2, dezena3, dezena4,"
+    " dezena5, dezena6 FROM \"%w\".concursos WHERE concurso BETWEEN ?1 AND ?2%s"
+    " ORDER BY concurso%s", t->schema,
+    (idxNum & (DEZENA_EQ|DEZENA_MIN|DEZENA_MAX)) ? " AND (dezena1 BETWEEN ?3 AND ?4"
+      " OR dezena2 BETWEEN ?3 AND ?4 OR dezena3 BETWEEN ?3 AND ?4"
+      " OR dezena4 BETWEEN ?3 AND ?4 OR dezena5 BETWEEN ?3 AND ?4"
+      " OR dezena6 BETWEEN ?3 AND ?4)" : "",
+    c->desc ? " DESC" : "");
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &c->stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+  sqlite3_bind_int64(c->stmt, 1, cmin);
+  sqlite3_bind_int64(c->stmt, 2, cmax);
+  if (idxNum & (DEZENA_EQ|DEZENA_MIN|DEZENA_MAX)) {
+    sqlite3_bind_int(c->stmt, 3, c->dmin);
+    sqlite3_bind_int(c->stmt, 4, c->dmax);
+  }
+  return proximo_concurso(c);
+}
+
+static int xEof(sqlite3_vtab_cursor *cur)
+{
+  return ((cursor_t *) cur)->eof;
+}
+
+static int xColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cursor_t *c = (cursor_t *) cur;
+
+  if (col == COL_CONCURSO) {
+    sqlite3_result_int64(ctx, c->concurso);
+  } else {
+    sqlite3_result_int(ctx, dezena(c));
+  }
+  return SQLITE_OK;
+}
+
+/* equivalente ao "rowid" da tabela preenchida em ordem pelos "triggers" */
+static int xRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  cursor_t *c = (cursor_t *) cur;
+  *rowid = (c->concurso - 1) * N_SORTEADAS + (c->desc ? N_SORTEADAS-1-c->j : c->j) + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  xConnect,
+  xBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  xOpen,
+  xClose,
+  xFilter,
+  xNext,
+  xEof,
+  xColumn,
+  xRowid,
+};
+
+/* ------------------------------------------------------------------------ */
+
+/* intervalo entre os acúmulos de frequências e latências */
+#define PASSO 64
+
+typedef struct acumulo_s
+{
+  int frequencia[N_DEZENAS];
+  sqlite3_int64 ultimo[N_DEZENAS];  /* concurso mais recente ou zero */
+}
+acumulo_t;
+
+/* série dos concursos do esquema em memória, compartilhada pelos cursores */
+typedef struct historico_s
+{
+  sqlite3_int64 versao, alteracoes, minimo, maximo;
+  int valido;               /* flag de carga sem escritas pendentes */
+  int n, capacidade;
+  sqlite3_int64 *concursos;
+  uint64_t *mascaras;
+  acumulo_t *acumulos;      /* estado antes dos concursos de índice k*PASSO */
+}
+historico_t;
+
+enum colunas_estado {
+  COL_E_DEZENA = 0, COL_E_FREQUENCIA, COL_E_LATENCIA, COL_E_CONCURSO
+};
+
+typedef struct estado_tabela_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+  char *schema;
+  historico_t historico;    /* série do esquema "schema" */
+  sqlite3_stmt *assinatura;
+}
+estado_tabela_t;
+
+typedef struct estado_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  acumulo_t estado;
+  sqlite3_int64 concurso;   /* concurso do estado corrente */
+  int p, fim;               /* índices do concurso corrente e final */
+  int unico;                /* flag de estado isolado */
+  int d;                    /* índice da dezena corrente */
+  int eof;
+}
+estado_cursor_t;
+
+static void libera_historico(historico_t *h)
+{
+  sqlite3_free(h->concursos);
+  sqlite3_free(h->mascaras);
+  sqlite3_free(h->acumulos);
+  h->concursos = NULL;
+  h->mascaras = NULL;
+  h->acumulos = NULL;
+  h->n = h->capacidade = 0;
+  h->valido = 0;
+}
+
+/* amplia os arrays da série para comportar mais um concurso */
+static int reserva(historico_t *h)
+{
+  int m = h->capacidade ? h->capacidade * 2 : 4096;
+  void *a, *b, *c;
+  if (h->n < h->capacidade) return SQLITE_OK;
+  a = sqlite3_realloc64(h->concursos, m * sizeof(sqlite3_int64));
+  if (a) h->concursos = a;
+  b = sqlite3_realloc64(h->mascaras, m * sizeof(uint64_t));
+  if (b) h->mascaras = b;
+  c = sqlite3_realloc64(h->acumulos, (m / PASSO + 1) * sizeof(acumulo_t));
+  if (c) h->acumulos = c;
+  if (!a || !b || !c) return SQLITE_NOMEM;
+  h->capacidade = m;
+  return SQLITE_OK;
+}
+
+/* aplica o bitmask das dezenas sorteadas no concurso ao estado */
+static void aplica(acumulo_t *e, uint64_t mascara, sqlite3_int64 concurso)
+{
+  while (mascara) {
+    int d = __builtin_ctzll(mascara);
+    ++e->frequencia[d];
+    e->ultimo[d] = concurso;
+    mascara &= mascara - 1;
+  }
+}
+
+/* acúmulo antes do concurso de índice j a partir do acúmulo anterior */
+static void acumula(historico_t *h, int j)
+{
+  acumulo_t *a = &h->acumulos[j / PASSO];
+  int k;
+  memcpy(a, a - 1, sizeof(acumulo_t));
+  for (k = j - PASSO; k < j; ++k) aplica(a, h->mascaras[k], h->concursos[k]);
+}
+
+/*
+ * Atualiza a série em memória se a tabela "concursos" foi modificada por
+ * outra conexão, conforme "data_version" do esquema, ou por esta conexão,
+ * conforme sqlite3_total_changes, desde a carga anterior.
+ *
+ * Reversões da própria conexão não alteram a assinatura, portanto a série
+ * carregada com escritas pendentes no esquema, i.e.; em transação de escrita,
+ * é recarregada a cada consulta até o final da transação. Transações
+ * explícitas apenas de leitura reaproveitam a série.
+*/
+static int carrega_historico(estado_tabela_t *t)
+{
+  historico_t *h = &t->historico;
+  sqlite3_int64 versao, alteracoes, minimo, maximo;
+#if SQLITE_VERSION_NUMBER >= 3034000
+  int definitivo = sqlite3_txn_state(t->db, t->schema) != SQLITE_TXN_WRITE;
+#else
+  int definitivo = sqlite3_get_autocommit(t->db);
+#endif
+  sqlite3_stmt *stmt;
+  char *sql;
+  int rc, k;
+
+  if (!t->assinatura) {
+    sql = sqlite3_mprintf("SELECT (SELECT data_version FROM"
+      " \"%w\".pragma_data_version), (SELECT min(concurso) FROM \"%w\".concursos),"
+      " (SELECT max(concurso) FROM \"%w\".concursos)", t->schema, t->schema, t->schema);
+    if (!sql) return SQLITE_NOMEM;
+    rc = sqlite3_prepare_v2(t->db, sql, -1, &t->assinatura, NULL);
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) return rc;
+  }
+  if (sqlite3_step(t->assinatura) != SQLITE_ROW) return sqlite3_reset(t->assinatura);
+  versao = sqlite3_column_int64(t->assinatura, 0);
+  minimo = sqlite3_column_int64(t->assinatura, 1);
+  maximo = sqlite3_column_int64(t->assinatura, 2);
+  rc = sqlite3_reset(t->assinatura);
+  if (rc != SQLITE_OK) return rc;
+  alteracoes = sqlite3_total_changes(t->db);
+
+  if (h->valido && h->versao == versao && h->alteracoes == alteracoes
+      && h->minimo == minimo && h->maximo == maximo) return SQLITE_OK;
+
+  sql = sqlite3_mprintf("SELECT concurso, dezena1, dezena2, dezena3, dezena4,"
+    " dezena5, dezena6 FROM \"%w\".concursos ORDER BY concurso", t->schema);
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) return rc;
+
+  h->n = 0;
+  h->valido = 0;
+  if ((rc = reserva(h)) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    return rc;
+  }
+  memset(&h->acumulos[0], 0, sizeof(acumulo_t));
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    uint64_t mascara = 0;
+    if ((rc = reserva(h)) != SQLITE_OK) break;
+    if (h->n > 0 && h->n % PASSO == 0) acumula(h, h->n);
+    for (k = 1; k <= N_SORTEADAS; ++k) {
+      int d = sqlite3_column_int(stmt, k);
+      if (d >= 1 && d <= N_DEZENAS) mascara |= (uint64_t) 1 << (d-1);
+    }
+    h->concursos[h->n] = sqlite3_column_int64(stmt, 0);
+    h->mascaras[h->n++] = mascara;
+  }
+  if (h->n > 0 && h->n % PASSO == 0) acumula(h, h->n);
+  k = sqlite3_finalize(stmt);
+  if (rc == SQLITE_DONE) rc = k;
+  if (rc != SQLITE_OK) {
+    h->n = 0;
+    return rc;
+  }
+  h->valido = definitivo;
+  h->versao = versao;
+  h->alteracoes = alteracoes;
+  h->minimo = minimo;
+  h->maximo = maximo;
+  return SQLITE_OK;
+}
+
+/* índice do primeiro concurso maior que o número dado */
+static int posterior(historico_t *h, sqlite3_int64 concurso)
+{
+  int a = 0, b = h->n;
+  while (a < b) {
+    int m = (a + b) / 2;
+    if (h->concursos[m] <= concurso) a = m + 1; else b = m;
+  }
+  return a;
+}
+
+/* estado imediatamente antes do concurso de índice p */
+static void estado_antes(historico_t *h, int p, acumulo_t *e)
+{
+  int j = (p / PASSO) * PASSO;
+  memcpy(e, &h->acumulos[p / PASSO], sizeof(acumulo_t));
+  for (; j < p; ++j) aplica(e, h->mascaras[j], h->concursos[j]);
+}
+
+static int estadoConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  estado_tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(dezena INTEGER," \
+    " frequencia INTEGER, latencia INTEGER, concurso HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+#ifdef SQLITE_VTAB_INNOCUOUS
+  sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+  t = sqlite3_malloc(sizeof(estado_tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(estado_tabela_t));
+  t->db = db;
+  // esquema informado como argumento do módulo ou o da própria tabela
+  t->schema = (argc > 3) ? sqlite3_mprintf("%s", argv[3]) : sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  if (argc > 3 && strchr("'\"[`", t->schema[0])) {
+    size_t n = strlen(t->schema);
+    memmove(t->schema, t->schema + 1, n);
+    if (n > 1) t->schema[n-2] = 0;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int estadoDisconnect(sqlite3_vtab *vtab)
+{
+  libera_historico(&((estado_tabela_t *) vtab)->historico);
+  sqlite3_finalize(((estado_tabela_t *) vtab)->assinatura);
+  sqlite3_free(((estado_tabela_t *) vtab)->schema);
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+/*
+ * Igualdade sobre "concurso" seleciona o estado isolado, enquanto limites
+ * selecionam a sequência dos estados após cada concurso do intervalo, que na
+ * ausência de restrições abrange a série completa.
+*/
+static int estadoBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j, k, bits = 0, argv = 0;
+  int usadas[3] = { -1, -1, -1 };
+  double linhas = 3000.0 * N_DEZENAS;
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    int bit;
+    if (!c->usable || c->iColumn != COL_E_CONCURSO) continue;
+    if ((bit = restricao(COL_CONCURSO, c->op)) && !(bits & bit)) {
+      bits |= bit;
+      for (k = 0; (1 << k) != bit; ++k) ;
+      usadas[k] = j;
+    }
+  }
+  if (bits & CONCURSO_EQ) {
+    bits = CONCURSO_EQ;
+    usadas[1] = usadas[2] = -1;
+    linhas = N_DEZENAS;
+  } else if (bits) {
+    linhas /= (bits == (CONCURSO_MIN|CONCURSO_MAX)) ? 10 : 3;
+  }
+  for (k = 0; k < 3; ++k) {
+    if (usadas[k] < 0) continue;
+    info->aConstraintUsage[usadas[k]].argvIndex = ++argv;
+    // somente a igualdade é exata, dado que os estados são dos concursos
+    info->aConstraintUsage[usadas[k]].omit = (k == 0);
+  }
+  if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == COL_E_DEZENA
+      && !info->aOrderBy[0].desc && (bits & CONCURSO_EQ)) {
+    info->orderByConsumed = 1;
+  }
+  info->idxNum = bits;
+  info->estimatedRows = (sqlite3_int64) linhas;
+  info->estimatedCost = linhas / 10;
+  return SQLITE_OK;
+}
+
+static int estadoOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  estado_cursor_t *c = sqlite3_malloc(sizeof(estado_cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(estado_cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int estadoClose(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+static int estadoFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  estado_cursor_t *c = (estado_cursor_t *) cur;
+  estado_tabela_t *t = (estado_tabela_t *) cur->pVtab;
+  historico_t *h = &t->historico;
+  sqlite3_int64 cmin = LLONG_MIN, cmax = LLONG_MAX;
+  int n = 0, rc;
+
+  rc = carrega_historico(t);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+
+  c->eof = 0;
+  c->d = 0;
+  c->unico = (idxNum & CONCURSO_EQ) != 0;
+  if (c->unico) {
+    // estado após o concurso, inexistente ou não, com latências relativas
+    if (sqlite3_value_type(argv[0]) != SQLITE_INTEGER
+        && sqlite3_value_numeric_type(argv[0]) != SQLITE_INTEGER) {
+      c->eof = 1;
+      return SQLITE_OK;
+    }
+    c->concurso = sqlite3_value_int64(argv[0]);
+    estado_antes(h, posterior(h, c->concurso), &c->estado);
+    return SQLITE_OK;
+  }
+
+  if (idxNum & CONCURSO_MIN) cmin = inclusivo(argv[n++], 1, cmin);
+  if (idxNum & CONCURSO_MAX) cmax = inclusivo(argv[n++], 0, cmax);
+  c->p = (cmin == LLONG_MIN) ? 0 : posterior(h, cmin - 1);
+  c->fim = posterior(h, cmax);
+  if (c->p >= c->fim) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  estado_antes(h, c->p, &c->estado);
+  aplica(&c->estado, h->mascaras[c->p], h->concursos[c->p]);
+  c->concurso = h->concursos[c->p];
+  return SQLITE_OK;
+}
+
+static int estadoNext(sqlite3_vtab_cursor *cur)
+{
+  estado_cursor_t *c = (estado_cursor_t *) cur;
+  historico_t *h = &((estado_tabela_t *) cur->pVtab)->historico;
+
+  if (++c->d < N_DEZENAS) return SQLITE_OK;
+  c->d = 0;
+  if (c->unico || ++c->p >= c->fim) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  aplica(&c->estado, h->mascaras[c->p], h->concursos[c->p]);
+  c->concurso = h->concursos[c->p];
+  return SQLITE_OK;
+}
+
+static int estadoEof(sqlite3_vtab_cursor *cur)
+{
+  return ((estado_cursor_t *) cur)->eof;
+}
+
+static int estadoColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  estado_cursor_t *c = (estado_cursor_t *) cur;
+
+  switch (col) {
+    case COL_E_DEZENA:
+      sqlite3_result_int(ctx, c->d + 1);
+      break;
+    case COL_E_FREQUENCIA:
+      sqlite3_result_int(ctx, c->estado.frequencia[c->d]);
+      break;
+    case COL_E_LATENCIA:
+      if (c->estado.frequencia[c->d]) {
+        sqlite3_result_int64(ctx, c->concurso - c->estado.ultimo[c->d]);
+      } else {
+        sqlite3_result_null(ctx);
+      }
+      break;
+    case COL_E_CONCURSO:
+      sqlite3_result_int64(ctx, c->concurso);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int estadoRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  estado_cursor_t *c = (estado_cursor_t *) cur;
+  *rowid = c->concurso * N_DEZENAS + c->d;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_estado = {
+  0,              /* iVersion */
+  estadoConnect,  /* xCreate: eponymous e instâncias por esquema */
+  estadoConnect,
+  estadoBestIndex,
+  estadoDisconnect,
+  estadoDisconnect,
+  estadoOpen,
+  estadoClose,
+  estadoFilter,
+  estadoNext,
+  estadoEof,
+  estadoColumn,
+  estadoRowid,
+};
+
+/* ------------------------------------------------------------------------ */
+
+/* limite do argumento "lag_max" */
+#define MAX_LAG 1000
+
+enum colunas_reincidencias {
+  COL_R_CONCURSO = 0, COL_R_LAG, COL_R_MASCARA, COL_R_QUANTIDADE,
+  COL_R_PERSISTENTES, COL_R_N_PERSISTENTES, COL_R_MAIOR_SEQUENCIA, COL_R_LAG_MAX
+};
+
+typedef struct reincidencias_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt;
+  int k;                        /* "lag_max" */
+  sqlite3_int64 *concursos;     /* anel dos k concursos mais recentes */
+  uint64_t *dezenas;
+  int n;                        /* quantidade de concursos lidos */
+  int sequencia[N_DEZENAS];     /* concursos consecutivos de cada dezena */
+  int maior;                    /* maior sequência do concurso corrente */
+  int lag;                      /* lag da linha corrente */
+  uint64_t mascara, persistentes;
+  sqlite3_int64 rowid;
+  int eof;
+}
+reincidencias_cursor_t;
+
+static int reincidenciasConnect(sqlite3 *db, void *aux, int argc,
+  const char *const *argv, sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(concurso INTEGER, lag INTEGER," \
+    " mascara INTEGER, quantidade INTEGER, persistentes INTEGER," \
+    " n_persistentes INTEGER, maior_sequencia INTEGER, lag_max HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+#ifdef SQLITE_VTAB_INNOCUOUS
+  sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->db = db;
+  t->schema = sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int reincidenciasBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j;
+
+  info->estimatedCost = 3000.0;
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if (c->iColumn == COL_R_LAG_MAX && c->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      if (!c->usable) return SQLITE_CONSTRAINT;
+      info->aConstraintUsage[j].argvIndex = 1;
+      info->aConstraintUsage[j].omit = 1;
+      info->idxNum = 1;
+    }
+  }
+  if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == COL_R_CONCURSO
+      && !info->aOrderBy[0].desc) {
+    info->orderByConsumed = 1;
+  }
+  return SQLITE_OK;
+}
+
+static int reincidenciasOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  reincidencias_cursor_t *c = sqlite3_malloc(sizeof(reincidencias_cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(reincidencias_cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int reincidenciasClose(sqlite3_vtab_cursor *cur)
+{
+  reincidencias_cursor_t *c = (reincidencias_cursor_t *) cur;
+  sqlite3_finalize(c->stmt);
+  sqlite3_free(c->concursos);
+  sqlite3_free(c->dezenas);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/* posição no anel do concurso lido "lag" leituras antes do corrente */
+#define ANEL(c, lag) (((c)->n - 1 - (lag)) % ((c)->k + 1))
+
+/*
+ * Avança até a próxima combinação de concurso e lag cujo concurso anterior
+ * existe, lendo novos concursos quando necessário.
+*/
+static int reincidenciasNext(sqlite3_vtab_cursor *cur)
+{
+  reincidencias_cursor_t *c = (reincidencias_cursor_t *) cur;
+
+  for (;;) {
+    // próximo lag do concurso corrente, se seu concurso anterior existe
+    if (c->n > 0 && c->lag < c->k && c->lag + 1 < c->n) {
+      sqlite3_int64 anterior;
+      int j;
+      ++c->lag;
+      // o anel é crescente, logo o concurso anterior está até "lag" leituras
+      // atrás, exatamente "lag" se os concursos intermediários existem
+      anterior = c->concursos[ANEL(c, 0)] - c->lag;
+      c->persistentes = c->dezenas[ANEL(c, 0)];
+      for (j = 1; j <= c->lag && j < c->n && c->concursos[ANEL(c, j)] > anterior; ++j) {
+        c->persistentes &= c->dezenas[ANEL(c, j)];
+      }
+      if (j <= c->lag && j < c->n && c->concursos[ANEL(c, j)] == anterior) {
+        c->mascara = c->dezenas[ANEL(c, 0)] & c->dezenas[ANEL(c, j)];
+        c->persistentes = (j == c->lag) ? c->persistentes & c->mascara : 0;
+        ++c->rowid;
+        return SQLITE_OK;
+      }
+      continue;
+    }
+    // leitura do próximo concurso
+    {
+      int rc = sqlite3_step(c->stmt), d;
+      sqlite3_int64 concurso;
+      uint64_t dezenas;
+      if (rc != SQLITE_ROW) {
+        c->eof = 1;
+        return rc == SQLITE_DONE ? SQLITE_OK : rc;
+      }
+      concurso = sqlite3_column_int64(c->stmt, 0);
+      dezenas = (uint64_t) sqlite3_column_int64(c->stmt, 1);
+      // atualiza as sequências de concursos consecutivos de cada dezena
+      {
+        int consecutivo = c->n > 0 && c->concursos[ANEL(c, 0)] == concurso - 1;
+        c->maior = 0;
+        for (d = 0; d < N_DEZENAS; ++d) {
+          if (dezenas >> d & 1) {
+            c->sequencia[d] = consecutivo ? c->sequencia[d] + 1 : 1;
+            if (c->sequencia[d] > c->maior) c->maior = c->sequencia[d];
+          } else {
+            c->sequencia[d] = 0;
+          }
+        }
+      }
+      ++c->n;
+      c->concursos[ANEL(c, 0)] = concurso;
+      c->dezenas[ANEL(c, 0)] = dezenas;
+      c->lag = 0;
+    }
+  }
+}
+
+static int reincidenciasFilter(sqlite3_vtab_cursor *cur, int idxNum,
+  const char *idxStr, int argc, sqlite3_value **argv)
+{
+  reincidencias_cursor_t *c = (reincidencias_cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  sqlite3_int64 k = 1;
+  char *sql;
+  int rc;
+
+  if (idxNum) {
+    if (sqlite3_value_numeric_type(argv[0]) != SQLITE_INTEGER
+        || (k = sqlite3_value_int64(argv[0])) < 1 || k > MAX_LAG) {
+      sqlite3_free(t->base.zErrMsg);
+      t->base.zErrMsg = sqlite3_mprintf("lag_max deve ser inteiro entre 1 e %d", MAX_LAG);
+      return SQLITE_ERROR;
+    }
+  }
+
+  sqlite3_finalize(c->stmt);
+  c->stmt = NULL;
+  sqlite3_free(c->concursos);
+  sqlite3_free(c->dezenas);
+  c->k = (int) k;
+  c->concursos = sqlite3_malloc((c->k + 1) * sizeof(sqlite3_int64));
+  c->dezenas = sqlite3_malloc((c->k + 1) * sizeof(uint64_t));
+  if (!c->concursos || !c->dezenas) return SQLITE_NOMEM;
+  c->n = c->lag = 0;
+  c->rowid = 0;
+  c->eof = 0;
+
+  sql = sqlite3_mprintf("SELECT concurso, dezenas FROM \"%w\".dezenas_juntadas"
+    " ORDER BY concurso", t->schema);
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &c->stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+  return reincidenciasNext(cur);
+}
+
+static int reincidenciasEof(sqlite3_vtab_cursor *cur)
+{
+  return ((reincidencias_cursor_t *) cur)->eof;
+}
+
+static int reincidenciasColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  reincidencias_cursor_t *c = (reincidencias_cursor_t *) cur;
+
+  switch (col) {
+    case COL_R_CONCURSO:
+      sqlite3_result_int64(ctx, c->concursos[ANEL(c, 0)]);
+      break;
+    case COL_R_LAG:
+      sqlite3_result_int(ctx, c->lag);
+      break;
+    case COL_R_MASCARA:
+      sqlite3_result_int64(ctx, (sqlite3_int64) c->mascara);
+      break;
+    case COL_R_QUANTIDADE:
+      sqlite3_result_int(ctx, __builtin_popcountll(c->mascara));
+      break;
+    case COL_R_PERSISTENTES:
+      sqlite3_result_int64(ctx, (sqlite3_int64) c->persistentes);
+      break;
+    case COL_R_N_PERSISTENTES:
+      sqlite3_result_int(ctx, __builtin_popcountll(c->persistentes));
+      break;
+    case COL_R_MAIOR_SEQUENCIA:
+      sqlite3_result_int(ctx, c->maior);
+      break;
+    case COL_R_LAG_MAX:
+      sqlite3_result_int(ctx, c->k);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int reincidenciasRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((reincidencias_cursor_t *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_reincidencias = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  reincidenciasConnect,
+  reincidenciasBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  reincidenciasOpen,
+  reincidenciasClose,
+  reincidenciasFilter,
+  reincidenciasNext,
+  reincidenciasEof,
+  reincidenciasColumn,
+  reincidenciasRowid,
+};
+
+/* ------------------------------------------------------------------------ */
+
+enum colunas_transicoes {
+  COL_T_LAG = 0, COL_T_A, COL_T_B, COL_T_CONTAGEM, COL_T_ESPERADO,
+  COL_T_RESIDUO, COL_T_LAG_MAX
+};
+
+/* contagens acumuladas de um lag */
+typedef struct transicao_s
+{
+  int matriz[N_DEZENAS][N_DEZENAS];   /* "a" no concurso e "b" lag depois */
+  int origem[N_DEZENAS];              /* pares com "a" no concurso */
+  int destino[N_DEZENAS];             /* pares com "b" lag depois */
+  int pares;                          /* pares de concursos distantes lag */
+}
+transicao_t;
+
+typedef struct transicoes_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  transicao_t *lags;                  /* contagens dos lags 1 a k */
+  int k;                              /* "lag_max" */
+  int j;                              /* linha corrente */
+}
+transicoes_cursor_t;
+
+static int transicoesConnect(sqlite3 *db, void *aux, int argc,
+  const char *const *argv, sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(lag INTEGER, a INTEGER," \
+    " b INTEGER, contagem INTEGER, esperado REAL, residuo REAL, lag_max HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+#ifdef SQLITE_VTAB_INNOCUOUS
+  sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->db = db;
+  t->schema = sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int transicoesBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j;
+
+  info->estimatedCost = 3000.0;
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if (c->iColumn == COL_T_LAG_MAX && c->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      if (!c->usable) return SQLITE_CONSTRAINT;
+      info->aConstraintUsage[j].argvIndex = 1;
+      info->aConstraintUsage[j].omit = 1;
+      info->idxNum = 1;
+    }
+  }
+  // linhas na ordem de lag, a e b
+  for (j = 0; j < info->nOrderBy; ++j) {
+    if (info->aOrderBy[j].iColumn != COL_T_LAG + j || info->aOrderBy[j].desc) break;
+  }
+  if (info->nOrderBy > 0 && j == info->nOrderBy) info->orderByConsumed = 1;
+  return SQLITE_OK;
+}
+
+static int transicoesOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  transicoes_cursor_t *c = sqlite3_malloc(sizeof(transicoes_cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(transicoes_cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int transicoesClose(sqlite3_vtab_cursor *cur)
+{
+  transicoes_cursor_t *c = (transicoes_cursor_t *) cur;
+  sqlite3_free(c->lags);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/*
+ * Acumula numa única passagem por "dezenas_juntadas" as contagens de todos os
+ * lags, confrontando cada concurso com os até k anteriores mantidos num anel
+ * e iterando apenas os bits das dezenas sorteadas em ambos.
+*/
+static int transicoesFilter(sqlite3_vtab_cursor *cur, int idxNum,
+  const char *idxStr, int argc, sqlite3_value **argv)
+{
+  transicoes_cursor_t *c = (transicoes_cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  sqlite3_int64 k = 1, *concursos;
+  uint64_t *dezenas;
+  sqlite3_stmt *stmt;
+  char *sql;
+  int rc, n = 0;
+
+  if (idxNum) {
+    if (sqlite3_value_numeric_type(argv[0]) != SQLITE_INTEGER
+        || (k = sqlite3_value_int64(argv[0])) < 1 || k > MAX_LAG) {
+      sqlite3_free(t->base.zErrMsg);
+      t->base.zErrMsg = sqlite3_mprintf("lag_max deve ser inteiro entre 1 e %d", MAX_LAG);
+      return SQLITE_ERROR;
+    }
+  }
+
+  sqlite3_free(c->lags);
+  c->k = (int) k;
+  c->j = 0;
+  c->lags = sqlite3_malloc64(k * sizeof(transicao_t));
+  concursos = sqlite3_malloc64(k * sizeof(sqlite3_int64));
+  dezenas = sqlite3_malloc64(k * sizeof(uint64_t));
+  if (!c->lags || !concursos || !dezenas) {
+    sqlite3_free(concursos);
+    sqlite3_free(dezenas);
+    return SQLITE_NOMEM;
+  }
+  memset(c->lags, 0, k * sizeof(transicao_t));
+
+  sql = sqlite3_mprintf("SELECT concurso, dezenas FROM \"%w\".dezenas_juntadas"
+    " ORDER BY concurso", t->schema);
+  rc = sql ? sqlite3_prepare_v2(t->db, sql, -1, &stmt, NULL) : SQLITE_NOMEM;
+  sqlite3_free(sql);
+  if (rc == SQLITE_OK) {
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      const sqlite3_int64 concurso = sqlite3_column_int64(stmt, 0);
+      const uint64_t atual = (uint64_t) sqlite3_column_int64(stmt, 1);
+      int j;
+      // concurso repetido resultaria em lag nulo, fora das matrizes
+      if (n > 0 && concurso <= concursos[(n - 1) % k]) {
+        sqlite3_finalize(stmt);
+        sqlite3_free(concursos);
+        sqlite3_free(dezenas);
+        sqlite3_free(t->base.zErrMsg);
+        t->base.zErrMsg = sqlite3_mprintf("concurso %lld repetido em dezenas_juntadas",
+          concurso);
+        return SQLITE_ERROR;
+      }
+      // concursos anteriores do anel, do mais recente ao mais antigo
+      for (j = 1; j <= n && j <= k; ++j) {
+        const int p = (n - j) % k;
+        const sqlite3_int64 lag = concurso - concursos[p];
+        transicao_t *tr;
+        uint64_t a, b;
+        if (lag > k) break;
+        tr = &c->lags[lag - 1];
+        ++tr->pares;
+        for (a = dezenas[p]; a; a &= a - 1) {
+          const int i = __builtin_ctzll(a);
+          ++tr->origem[i];
+          for (b = atual; b; b &= b - 1) ++tr->matriz[i][__builtin_ctzll(b)];
+        }
+        for (b = atual; b; b &= b - 1) ++tr->destino[__builtin_ctzll(b)];
+      }
+      concursos[n % k] = concurso;
+      dezenas[n % k] = atual;
+      ++n;
+    }
+    sqlite3_finalize(stmt);
+  }
+  sqlite3_free(concursos);
+  sqlite3_free(dezenas);
+  if (rc != SQLITE_DONE) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc == SQLITE_NOMEM ? rc : SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+static int transicoesNext(sqlite3_vtab_cursor *cur)
+{
+  ++((transicoes_cursor_t *) cur)->j;
+  return SQLITE_OK;
+}
+
+static int transicoesEof(sqlite3_vtab_cursor *cur)
+{
+  transicoes_cursor_t *c = (transicoes_cursor_t *) cur;
+  return c->j >= c->k * N_DEZENAS * N_DEZENAS;
+}
+
+/*
+ * Valor esperado da contagem sob independência, R_a × C_b / N, e resíduo
+ * padronizado ajustado do par na tabela 2×2 "a antes" × "b depois", i.e.;
+ * (O - E) / sqrt(E × (1 - R_a/N) × (1 - C_b/N)), aproximadamente normal
+ * padrão sob independência, NULL se indefinido.
+*/
+static int transicoesColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  transicoes_cursor_t *c = (transicoes_cursor_t *) cur;
+  const int lag = c->j / (N_DEZENAS * N_DEZENAS);
+  const int a = c->j / N_DEZENAS % N_DEZENAS, b = c->j % N_DEZENAS;
+  const transicao_t *tr = &c->lags[lag];
+  const double n = tr->pares;
+  const double esperado = n > 0 ? (double) tr->origem[a] * tr->destino[b] / n : 0;
+
+  switch (col) {
+    case COL_T_LAG:
+      sqlite3_result_int(ctx, lag + 1);
+      break;
+    case COL_T_A:
+      sqlite3_result_int(ctx, a + 1);
+      break;
+    case COL_T_B:
+      sqlite3_result_int(ctx, b + 1);
+      break;
+    case COL_T_CONTAGEM:
+      sqlite3_result_int(ctx, tr->matriz[a][b]);
+      break;
+    case COL_T_ESPERADO:
+      if (n > 0) sqlite3_result_double(ctx, esperado);
+      break;
+    case COL_T_RESIDUO:
+      {
+        const double v = esperado * (1 - tr->origem[a] / n) * (1 - tr->destino[b] / n);
+        if (n > 0 && v > 0) sqlite3_result_double(ctx, (tr->matriz[a][b] - esperado) / sqrt(v));
+      }
+      break;
+    case COL_T_LAG_MAX:
+      sqlite3_result_int(ctx, c->k);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int transicoesRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((transicoes_cursor_t *) cur)->j + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_transicoes = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  transicoesConnect,
+  transicoesBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  transicoesOpen,
+  transicoesClose,
+  transicoesFilter,
+  transicoesNext,
+  transicoesEof,
+  transicoesColumn,
+  transicoesRowid,
+};
+
+int sqlite3_dezenas_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  int rc;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  rc = sqlite3_create_module(db, "dezenas_sorteadas", &modulo, NULL);
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_module(db, "reincidencias", &modulo_reincidencias, NULL);
+  }
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_module(db, "transicoes", &modulo_transicoes, NULL);
+  }
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_module(db, "estado_em", &modulo_estado, NULL);
+  }
+  return rc;
+}
@@ -0,0 +1,549 @@
+/*
+ * Instrumentação opcional das funções registradas pelas extensões, ativada
+ * na compilação com -DEXT_STATS, e.g.:
+ *
+ *    make build DEFS=-DEXT_STATS
+ *
+ * Incluído após SQLITE_EXTENSION_INIT1 e antes de qualquer função, substitui
+ * via macros o registro de funções do SQLite por versões que interpõem a cada
+ * chamada a contagem de chamadas, erros, bytes produzidos e tempos acumulado
+ * e máximo por função, tal que as extensões não precisam ser modificadas
+ * além de definir EXT_STATS_EXTENSAO e chamar ext_stats_inicia(db) ao final
+ * do seu registro.
+ *
+ * As contagens são globais ao processo, atualizadas com operações atômicas
+ * "relaxed", e expostas na tabela virtual epônima:
+ *
+ *    EXT_STATS (extensao, funcao, chamadas, erros, bytes,
+ *               tempo_total, tempo_medio, tempo_max)
+ *
+ * com tempos em microssegundos, e zeradas via:
+ *
+ *    SELECT ext_stats_reset();
+ *
+ * A primeira extensão instrumentada carregada na conexão cria a tabela e as
+ * funções auxiliares, e as seguintes agregam suas contagens repassando-as via
+ * ext_stats_registra(ponteiro), que aceita somente ponteiros do tipo
+ * "ext_stats" conforme sqlite3_bind_pointer.
+ *
+ * Sem EXT_STATS resta apenas ext_stats_inicia(db) avaliando SQLITE_OK.
+*/
+#ifndef EXT_STATS_H
+#define EXT_STATS_H
+
+#ifndef EXT_STATS
+
+#define ext_stats_inicia(db) SQLITE_OK
+
+#else
+
+#include <string.h>
+#include <time.h>
+
+#ifndef EXT_STATS_EXTENSAO
+#error "EXT_STATS_EXTENSAO deve nomear a extensão instrumentada"
+#endif
+
+#define EXT_STATS_MAX_FUNCOES   64
+#define EXT_STATS_MAX_TABELAS   16
+#define EXT_STATS_PONTEIRO      "ext_stats"
+
+typedef struct ext_stats_funcao_s
+{
+  char nome[32];
+  sqlite3_int64 chamadas, erros, bytes;
+  sqlite3_int64 tempo_total, tempo_max;   /* nanossegundos */
+}
+ext_stats_funcao_t;
+
+typedef struct ext_stats_tabela_s
+{
+  const char *extensao;
+  int n;
+  ext_stats_funcao_t funcoes[EXT_STATS_MAX_FUNCOES];
+}
+ext_stats_tabela_t;
+
+/* tabelas das extensões instrumentadas carregadas na conexão */
+typedef struct ext_stats_conexao_s
+{
+  int n;
+  ext_stats_tabela_t *tabelas[EXT_STATS_MAX_TABELAS];
+}
+ext_stats_conexao_t;
+
+/*
+ * Registro de função interposto, dados do usuário da função original, sem
+ * contador se excedido EXT_STATS_MAX_FUNCOES, caso em que a função é apenas
+ * repassada.
+*/
+typedef struct ext_stats_ligacao_s
+{
+  ext_stats_funcao_t *funcao;
+  void *dados;
+  void (*xFunc)(sqlite3_context *, int, sqlite3_value **);
+  void (*xStep)(sqlite3_context *, int, sqlite3_value **);
+  void (*xFinal)(sqlite3_context *);
+  void (*xValue)(sqlite3_context *);
+  void (*xInverse)(sqlite3_context *, int, sqlite3_value **);
+  void (*xDestroy)(void *);
+}
+ext_stats_ligacao_t;
+
+static ext_stats_tabela_t ext_stats_tabela = { EXT_STATS_EXTENSAO, 0 };
+
+static sqlite3_int64 ext_stats_agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void ext_stats_conta(ext_stats_funcao_t *f, sqlite3_int64 inicio)
+{
+  sqlite3_int64 t = ext_stats_agora() - inicio, max;
+
+  if (!f) return;
+  __atomic_fetch_add(&f->chamadas, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&f->tempo_total, t, __ATOMIC_RELAXED);
+  max = __atomic_load_n(&f->tempo_max, __ATOMIC_RELAXED);
+  while (t > max && !__atomic_compare_exchange_n(&f->tempo_max, &max, t, 1,
+    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) ;
+}
+
+/* ligação da função em execução, acessada antes da substituição das macros */
+static ext_stats_ligacao_t *ext_stats_ligacao(sqlite3_context *ctx)
+{
+  return (ext_stats_ligacao_t *) sqlite3_user_data(ctx);
+}
+
+static void ext_stats_xFunc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_ligacao_t *l = ext_stats_ligacao(ctx);
+  sqlite3_int64 inicio = ext_stats_agora();
+  l->xFunc(ctx, argc, argv);
+  ext_stats_conta(l->funcao, inicio);
+}
+
+static void ext_stats_xStep(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_ligacao_t *l = ext_stats_ligacao(ctx);
+  sqlite3_int64 inicio = ext_stats_agora();
+  l->xStep(ctx, argc, argv);
+  ext_stats_conta(l->funcao, inicio);
+}
+
+static void ext_stats_xInverse(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_ligacao_t *l = ext_stats_ligacao(ctx);
+  sqlite3_int64 inicio = ext_stats_agora();
+  l->xInverse(ctx, argc, argv);
+  ext_stats_conta(l->funcao, inicio);
+}
+
+/* finalização e valor corrente contam somente o tempo, não a chamada */
+static void ext_stats_xFinal(sqlite3_context *ctx)
+{
+  ext_stats_ligacao_t *l = ext_stats_ligacao(ctx);
+  sqlite3_int64 inicio = ext_stats_agora();
+  l->xFinal(ctx);
+  if (l->funcao) {
+    __atomic_fetch_add(&l->funcao->tempo_total, ext_stats_agora() - inicio, __ATOMIC_RELAXED);
+  }
+}
+
+static void ext_stats_xValue(sqlite3_context *ctx)
+{
+  ext_stats_ligacao_t *l = ext_stats_ligacao(ctx);
+  sqlite3_int64 inicio = ext_stats_agora();
+  l->xValue(ctx);
+  if (l->funcao) {
+    __atomic_fetch_add(&l->funcao->tempo_total, ext_stats_agora() - inicio, __ATOMIC_RELAXED);
+  }
+}
+
+static void ext_stats_xDestroy(void *p)
+{
+  ext_stats_ligacao_t *l = (ext_stats_ligacao_t *) p;
+  if (l->xDestroy) l->xDestroy(l->dados);
+  sqlite3_free(l);
+}
+
+/* contador da função na tabela da extensão, nomes indiferentes à caixa */
+static ext_stats_funcao_t *ext_stats_funcao(const char *nome)
+{
+  ext_stats_tabela_t *t = &ext_stats_tabela;
+  ext_stats_funcao_t *f;
+  int j;
+
+  for (j = 0; j < t->n; ++j) {
+    if (sqlite3_stricmp(t->funcoes[j].nome, nome) == 0) return &t->funcoes[j];
+  }
+  if (t->n == EXT_STATS_MAX_FUNCOES) return NULL;
+  f = &t->funcoes[t->n++];
+  memset(f, 0, sizeof(ext_stats_funcao_t));
+  sqlite3_snprintf(sizeof(f->nome), f->nome, "%s", nome);
+  for (j = 0; f->nome[j]; ++j) {
+    if (f->nome[j] >= 'A' && f->nome[j] <= 'Z') f->nome[j] += 'a' - 'A';
+  }
+  return f;
+}
+
+static int ext_stats_cria(sqlite3 *db, const char *nome, int nArg,
+  int eTextRep, void *dados,
+  void (*xFunc)(sqlite3_context *, int, sqlite3_value **),
+  void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+  void (*xFinal)(sqlite3_context *),
+  void (*xValue)(sqlite3_context *),
+  void (*xInverse)(sqlite3_context *, int, sqlite3_value **),
+  void (*xDestroy)(void *))
+{
+  ext_stats_ligacao_t *l = sqlite3_malloc(sizeof(ext_stats_ligacao_t));
+
+  // sempre via ligação, pois sqlite3_user_data é interposta
+  if (!l) {
+    if (xDestroy) xDestroy(dados);
+    return SQLITE_NOMEM;
+  }
+  l->funcao = ext_stats_funcao(nome);
+  l->dados = dados;
+  l->xFunc = xFunc;
+  l->xStep = xStep;
+  l->xFinal = xFinal;
+  l->xValue = xValue;
+  l->xInverse = xInverse;
+  l->xDestroy = xDestroy;
+  if (xValue) {
+    return sqlite3_create_window_function(db, nome, nArg, eTextRep, l,
+      ext_stats_xStep, ext_stats_xFinal, ext_stats_xValue, ext_stats_xInverse,
+      ext_stats_xDestroy);
+  }
+  return sqlite3_create_function_v2(db, nome, nArg, eTextRep, l,
+    xFunc ? ext_stats_xFunc : NULL, xStep ? ext_stats_xStep : NULL,
+    xFinal ? ext_stats_xFinal : NULL, ext_stats_xDestroy);
+}
+
+/* substitutos das funções da API, "inline" pois nem todos são usados */
+
+static inline int ext_stats_create_window_function(sqlite3 *db, const char *nome,
+  int nArg, int eTextRep, void *dados,
+  void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+  void (*xFinal)(sqlite3_context *),
+  void (*xValue)(sqlite3_context *),
+  void (*xInverse)(sqlite3_context *, int, sqlite3_value **),
+  void (*xDestroy)(void *))
+{
+  return ext_stats_cria(db, nome, nArg, eTextRep, dados,
+    NULL, xStep, xFinal, xValue, xInverse, xDestroy);
+}
+
+static inline int ext_stats_create_function_v2(sqlite3 *db, const char *nome, int nArg,
+  int eTextRep, void *dados,
+  void (*xFunc)(sqlite3_context *, int, sqlite3_value **),
+  void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+  void (*xFinal)(sqlite3_context *),
+  void (*xDestroy)(void *))
+{
+  return ext_stats_cria(db, nome, nArg, eTextRep, dados,
+    xFunc, xStep, xFinal, NULL, NULL, xDestroy);
+}
+
+static inline int ext_stats_create_function(sqlite3 *db, const char *nome, int nArg,
+  int eTextRep, void *dados,
+  void (*xFunc)(sqlite3_context *, int, sqlite3_value **),
+  void (*xStep)(sqlite3_context *, int, sqlite3_value **),
+  void (*xFinal)(sqlite3_context *))
+{
+  return ext_stats_cria(db, nome, nArg, eTextRep, dados,
+    xFunc, xStep, xFinal, NULL, NULL, NULL);
+}
+
+static inline void *ext_stats_user_data(sqlite3_context *ctx)
+{
+  return ext_stats_ligacao(ctx)->dados;
+}
+
+static inline void ext_stats_erro(sqlite3_context *ctx)
+{
+  ext_stats_funcao_t *f = ext_stats_ligacao(ctx)->funcao;
+  if (f) __atomic_fetch_add(&f->erros, 1, __ATOMIC_RELAXED);
+}
+
+static inline void ext_stats_bytes(sqlite3_context *ctx, const void *z, sqlite3_int64 n)
+{
+  ext_stats_funcao_t *f = ext_stats_ligacao(ctx)->funcao;
+  if (!f) return;
+  if (n < 0) n = z ? strlen((const char *) z) : 0;
+  __atomic_fetch_add(&f->bytes, n, __ATOMIC_RELAXED);
+}
+
+/* tabela virtual epônima das contagens das extensões da conexão */
+
+enum ext_stats_colunas {
+  EXT_STATS_EXTENSAO_COL = 0, EXT_STATS_FUNCAO, EXT_STATS_CHAMADAS, EXT_STATS_ERROS,
+  EXT_STATS_BYTES, EXT_STATS_TEMPO_TOTAL, EXT_STATS_TEMPO_MEDIO, EXT_STATS_TEMPO_MAX
+};
+
+typedef struct ext_stats_vtab_s
+{
+  sqlite3_vtab base;
+  ext_stats_conexao_t *conexao;
+}
+ext_stats_vtab_t;
+
+typedef struct ext_stats_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int tabela, funcao;
+  sqlite3_int64 rowid;
+}
+ext_stats_cursor_t;
+
+static int ext_stats_connect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  ext_stats_vtab_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(extensao TEXT, funcao TEXT," \
+    " chamadas INTEGER, erros INTEGER, bytes INTEGER, tempo_total REAL," \
+    " tempo_medio REAL, tempo_max REAL)");
+  if (rc != SQLITE_OK) return rc;
+  t = sqlite3_malloc(sizeof(ext_stats_vtab_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(ext_stats_vtab_t));
+  t->conexao = (ext_stats_conexao_t *) aux;
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int ext_stats_disconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+static int ext_stats_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  info->estimatedCost = 100;
+  info->estimatedRows = 100;
+  return SQLITE_OK;
+}
+
+static int ext_stats_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  ext_stats_cursor_t *c = sqlite3_malloc(sizeof(ext_stats_cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(ext_stats_cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int ext_stats_close(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+/* avança até a próxima função registrada, saltando tabelas vazias */
+static int ext_stats_next(sqlite3_vtab_cursor *cur)
+{
+  ext_stats_cursor_t *c = (ext_stats_cursor_t *) cur;
+  ext_stats_conexao_t *x = ((ext_stats_vtab_t *) cur->pVtab)->conexao;
+
+  ++c->funcao;
+  while (c->tabela < x->n && c->funcao >= x->tabelas[c->tabela]->n) {
+    ++c->tabela;
+    c->funcao = 0;
+  }
+  ++c->rowid;
+  return SQLITE_OK;
+}
+
+static int ext_stats_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  ext_stats_cursor_t *c = (ext_stats_cursor_t *) cur;
+  c->tabela = 0;
+  c->funcao = -1;
+  c->rowid = 0;
+  return ext_stats_next(cur);
+}
+
+static int ext_stats_eof(sqlite3_vtab_cursor *cur)
+{
+  ext_stats_cursor_t *c = (ext_stats_cursor_t *) cur;
+  return c->tabela >= ((ext_stats_vtab_t *) cur->pVtab)->conexao->n;
+}
+
+static int ext_stats_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  ext_stats_cursor_t *c = (ext_stats_cursor_t *) cur;
+  const ext_stats_tabela_t *t = ((ext_stats_vtab_t *) cur->pVtab)->conexao->tabelas[c->tabela];
+  const ext_stats_funcao_t *f = &t->funcoes[c->funcao];
+  const sqlite3_int64 chamadas = __atomic_load_n(&f->chamadas, __ATOMIC_RELAXED);
+
+  switch (col) {
+    case EXT_STATS_EXTENSAO_COL:
+      sqlite3_result_text(ctx, t->extensao, -1, SQLITE_STATIC);
+      break;
+    case EXT_STATS_FUNCAO:
+      sqlite3_result_text(ctx, f->nome, -1, SQLITE_TRANSIENT);
+      break;
+    case EXT_STATS_CHAMADAS:
+      sqlite3_result_int64(ctx, chamadas);
+      break;
+    case EXT_STATS_ERROS:
+      sqlite3_result_int64(ctx, __atomic_load_n(&f->erros, __ATOMIC_RELAXED));
+      break;
+    case EXT_STATS_BYTES:
+      sqlite3_result_int64(ctx, __atomic_load_n(&f->bytes, __ATOMIC_RELAXED));
+      break;
+    case EXT_STATS_TEMPO_TOTAL:
+      sqlite3_result_double(ctx, __atomic_load_n(&f->tempo_total, __ATOMIC_RELAXED) / 1e3);
+      break;
+    case EXT_STATS_TEMPO_MEDIO:
+      if (chamadas > 0) {
+        sqlite3_result_double(ctx,
+          __atomic_load_n(&f->tempo_total, __ATOMIC_RELAXED) / 1e3 / chamadas);
+      }
+      break;
+    case EXT_STATS_TEMPO_MAX:
+      sqlite3_result_double(ctx, __atomic_load_n(&f->tempo_max, __ATOMIC_RELAXED) / 1e3);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int ext_stats_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((ext_stats_cursor_t *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module ext_stats_modulo = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  ext_stats_connect,
+  ext_stats_best_index,
+  ext_stats_disconnect,
+  0,              /* xDestroy */
+  ext_stats_open,
+  ext_stats_close,
+  ext_stats_filter,
+  ext_stats_next,
+  ext_stats_eof,
+  ext_stats_column,
+  ext_stats_rowid,
+};
+
+/* agrega a tabela de contagens repassada à lista da conexão */
+static void ext_stats_registra(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_conexao_t *x = (ext_stats_conexao_t *) ext_stats_ligacao(ctx);
+  ext_stats_tabela_t *t = sqlite3_value_pointer(argv[0], EXT_STATS_PONTEIRO);
+  int j;
+
+  if (!t) {
+    sqlite3_result_error(ctx, "ext_stats_registra requer ponteiro \"ext_stats\"", -1);
+    return;
+  }
+  for (j = 0; j < x->n && x->tabelas[j] != t; ++j) ;
+  if (j == x->n) {
+    if (x->n == EXT_STATS_MAX_TABELAS) {
+      sqlite3_result_error(ctx, "excesso de extensões instrumentadas", -1);
+      return;
+    }
+    x->tabelas[x->n++] = t;
+  }
+  sqlite3_result_int(ctx, x->n);
+}
+
+/* zera as contagens das extensões da conexão, retornando a quantidade */
+static void ext_stats_reset(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_conexao_t *x = (ext_stats_conexao_t *) ext_stats_ligacao(ctx);
+  int j, k, n = 0;
+
+  for (j = 0; j < x->n; ++j) {
+    for (k = 0; k < x->tabelas[j]->n; ++k, ++n) {
+      ext_stats_funcao_t *f = &x->tabelas[j]->funcoes[k];
+      __atomic_store_n(&f->chamadas, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&f->erros, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&f->bytes, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&f->tempo_total, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&f->tempo_max, 0, __ATOMIC_RELAXED);
+    }
+  }
+  sqlite3_result_int(ctx, n);
+}
+
+/*
+ * Registra a tabela de contagens da extensão na conexão, criando a tabela
+ * virtual e as funções auxiliares se for a primeira extensão instrumentada.
+*/
+static int ext_stats_inicia(sqlite3 *db)
+{
+  ext_stats_conexao_t *x;
+  sqlite3_stmt *stmt;
+  int rc;
+
+  if (sqlite3_prepare_v2(db, "SELECT ext_stats_registra(?1)", -1, &stmt, NULL) != SQLITE_OK) {
+    x = sqlite3_malloc(sizeof(ext_stats_conexao_t));
+    if (!x) return SQLITE_NOMEM;
+    memset(x, 0, sizeof(ext_stats_conexao_t));
+    rc = sqlite3_create_module_v2(db, "ext_stats", &ext_stats_modulo, x, sqlite3_free);
+    if (rc != SQLITE_OK) return rc;
+    rc = sqlite3_create_function(db, "ext_stats_registra", 1, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+      x, ext_stats_registra, NULL, NULL);
+    if (rc == SQLITE_OK) {
+      rc = sqlite3_create_function(db, "ext_stats_reset", 0, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+        x, ext_stats_reset, NULL, NULL);
+    }
+    if (rc != SQLITE_OK) return rc;
+    rc = sqlite3_prepare_v2(db, "SELECT ext_stats_registra(?1)", -1, &stmt, NULL);
+    if (rc != SQLITE_OK) return rc;
+  }
+  sqlite3_bind_pointer(stmt, 1, &ext_stats_tabela, EXT_STATS_PONTEIRO, NULL);
+  rc = sqlite3_step(stmt);
+  sqlite3_finalize(stmt);
+  return rc == SQLITE_ROW ? SQLITE_OK : rc;
+}
+
+/* interposição das chamadas das extensões à API do SQLite */
+
+#undef sqlite3_create_function
+#undef sqlite3_create_function_v2
+#undef sqlite3_create_window_function
+#undef sqlite3_user_data
+#undef sqlite3_result_error
+#undef sqlite3_result_error_nomem
+#undef sqlite3_result_error_code
+#undef sqlite3_result_text
+#undef sqlite3_result_blob
+
+#define sqlite3_create_function         ext_stats_create_function
+#define sqlite3_create_function_v2      ext_stats_create_function_v2
+#define sqlite3_create_window_function  ext_stats_create_window_function
+#define sqlite3_user_data               ext_stats_user_data
+
+#ifdef SQLITE_CORE
+#define EXT_STATS_API(f) sqlite3_##f
+#else
+#define EXT_STATS_API(f) sqlite3_api->f
+#endif
+
+#define sqlite3_result_error(ctx, z, n) \
+  (ext_stats_erro(ctx), EXT_STATS_API(result_error)((ctx), (z), (n)))
+#define sqlite3_result_error_nomem(ctx) \
+  (ext_stats_erro(ctx), EXT_STATS_API(result_error_nomem)(ctx))
+#define sqlite3_result_error_code(ctx, rc) \
+  (ext_stats_erro(ctx), EXT_STATS_API(result_error_code)((ctx), (rc)))
+#define sqlite3_result_text(ctx, z, n, d) \
+  (ext_stats_bytes((ctx), (z), (n)), EXT_STATS_API(result_text)((ctx), (z), (n), (d)))
+#define sqlite3_result_blob(ctx, z, n, d) \
+  (ext_stats_bytes((ctx), (z), (n)), EXT_STATS_API(result_blob)((ctx), (z), (n), (d)))
+
+#endif /* EXT_STATS */
+
+#endif /* EXT_STATS_H */
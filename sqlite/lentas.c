@@ -0,0 +1,450 @@
+/*
+ * Registro das requisições lentas da conexão, via callback de "profile" de
+ * sqlite3_trace_v2, consultável na tabela virtual epônima:
+ *
+ *    CONSULTAS_LENTAS (seq, instante, tempo, sql, passos_scan, ordenacoes,
+ *                      autoindices, passos_vm, plano)
+ *
+ * Cada execução de statement com duração em milissegundos maior ou igual ao
+ * limiar é registrada num buffer circular das REGISTROS_MAX mais recentes com
+ * o texto da requisição com os parâmetros expandidos, os contadores do
+ * statement nessa execução – passos em varreduras completas de tabelas,
+ * ordenações, linhas inseridas em índices automáticos e passos da VM – e o
+ * plano de execução tal como o exibido por ".eqp on" no shell, capturado no
+ * momento da execução. A duração é medida pelo SQLite com a resolução do
+ * relógio do VFS, tipicamente de 1 ms, p.ex.:
+ *
+ *    SELECT tempo, passos_scan, sql, plano FROM consultas_lentas
+ *      ORDER BY tempo DESC LIMIT 5;
+ *
+ * O limiar tem default de 100 ms, é configurável via variável de ambiente
+ * LENTAS_LIMIAR e consultado ou alterado na conexão, retornando o anterior:
+ *
+ *    SELECT lentas_limiar(0);   -- registra todas as requisições
+ *
+ * e o buffer esvaziado via:
+ *
+ *    SELECT lentas_reset();
+ *
+ * Se a variável de ambiente LENTAS_LOG nomeia um arquivo, os registros no
+ * buffer ao fechamento da conexão são acrescentados a este no formato de
+ * script SQL comentado, o que permite examinar as requisições dos scripts
+ * executados em sequência pelo shell, p.ex. acrescentando a "sqlite/onload":
+ *
+ *    .load './sqlite/lentas.so'
+ *
+ * e executando:
+ *
+ *    LENTAS_LOG=/tmp/lentas.sql LENTAS_LIMIAR=50 ./monta
+ *
+ * Os contadores de cada statement são zerados ao final de toda execução, para
+ * que sejam individuais, e a extensão substitui callbacks de sqlite3_trace_v2
+ * eventualmente instalados na conexão, p.ex. via ".trace" do shell.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc lentas.c -Wall -fPIC -shared -o lentas.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/lentas.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/lentas.so");
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* quantidade de requisições lentas mantidas no buffer circular */
+#define REGISTROS_MAX 256
+
+/* limiar default em milissegundos */
+#define LIMIAR_DEFAULT 100.0
+
+/* profundidade máxima das linhas do plano de execução */
+#define PLANO_MAX 64
+
+#ifndef SQLITE_DIRECTONLY
+#define SQLITE_DIRECTONLY 0
+#endif
+
+enum colunas {
+  COL_SEQ = 0, COL_INSTANTE, COL_TEMPO, COL_SQL, COL_PASSOS_SCAN,
+  COL_ORDENACOES, COL_AUTOINDICES, COL_PASSOS_VM, COL_PLANO
+};
+
+typedef struct registro_s
+{
+  sqlite3_int64 seq;
+  time_t instante;
+  double tempo;             /* milissegundos */
+  char *sql;
+  char *plano;
+  int passos_scan, ordenacoes, autoindices, passos_vm;
+}
+registro_t;
+
+/* estado da conexão compartilhado pelo callback, tabela e funções */
+typedef struct lentas_s
+{
+  sqlite3 *db;
+  double limiar;
+  int ocupado;              /* flag da captura do plano em andamento */
+  sqlite3_int64 seq;        /* quantidade de registros desde o início */
+  registro_t registros[REGISTROS_MAX];
+}
+lentas_t;
+
+typedef struct tabela_s
+{
+  sqlite3_vtab base;
+  lentas_t *lentas;
+}
+tabela_t;
+
+typedef struct cursor_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_int64 seq;        /* seq do registro corrente */
+}
+cursor_t;
+
+static void libera_registro(registro_t *r)
+{
+  sqlite3_free(r->sql);
+  sqlite3_free(r->plano);
+  memset(r, 0, sizeof(registro_t));
+}
+
+/* registro de número serial "seq" no buffer circular */
+static registro_t *registro(lentas_t *l, sqlite3_int64 seq)
+{
+  return &l->registros[(seq - 1) % REGISTROS_MAX];
+}
+
+/* menor seq ainda presente no buffer */
+static sqlite3_int64 primeiro(const lentas_t *l)
+{
+  return l->seq > REGISTROS_MAX ? l->seq - REGISTROS_MAX + 1 : 1;
+}
+
+/*
+ * Plano de execução da requisição em linhas indentadas conforme a hierarquia
+ * dos nós, ou NULL se a requisição não é mais compilável, p.ex. após remoção
+ * das tabelas que referencia.
+*/
+static char *plano(sqlite3 *db, const char *sql)
+{
+  sqlite3_stmt *stmt;
+  sqlite3_str *s;
+  int ids[PLANO_MAX], niveis[PLANO_MAX], n = 0;
+  char *z;
+
+  z = sqlite3_mprintf("EXPLAIN QUERY PLAN %s", sql);
+  if (!z) return NULL;
+  if (sqlite3_prepare_v2(db, z, -1, &stmt, NULL) != SQLITE_OK) {
+    sqlite3_free(z);
+    return NULL;
+  }
+  sqlite3_free(z);
+  s = sqlite3_str_new(db);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    int id = sqlite3_column_int(stmt, 0), pai = sqlite3_column_int(stmt, 1), nivel = 0, j;
+    for (j = n - 1; j >= 0; --j) {
+      if (ids[j] == pai) {
+        nivel = niveis[j] + 1;
+        break;
+      }
+    }
+    if (n < PLANO_MAX) {
+      ids[n] = id;
+      niveis[n++] = nivel;
+    }
+    sqlite3_str_appendf(s, "%s%*s%s", sqlite3_str_length(s) ? "\n" : "",
+      2 * nivel, "", sqlite3_column_text(stmt, 3));
+  }
+  sqlite3_finalize(stmt);
+  return sqlite3_str_finish(s);
+}
+
+static int profile(unsigned tipo, void *ctx, void *p, void *x)
+{
+  lentas_t *l = (lentas_t *) ctx;
+  sqlite3_stmt *stmt = (sqlite3_stmt *) p;
+  const double tempo = *(sqlite3_int64 *) x / 1e6;
+  registro_t *r;
+  int scan, ordenacoes, autoindices, passos;
+
+  // contadores individualizados por execução mesmo abaixo do limiar
+  scan = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+  ordenacoes = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+  autoindices = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+  passos = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+
+  if (tempo < l->limiar || l->ocupado) return 0;
+#if SQLITE_VERSION_NUMBER >= 3028000
+  if (sqlite3_stmt_isexplain(stmt)) return 0;
+#endif
+
+  r = registro(l, ++l->seq);
+  libera_registro(r);
+  r->seq = l->seq;
+  r->instante = time(NULL);
+  r->tempo = tempo;
+  r->passos_scan = scan;
+  r->ordenacoes = ordenacoes;
+  r->autoindices = autoindices;
+  r->passos_vm = passos;
+  r->sql = sqlite3_expanded_sql(stmt);
+  // a captura do plano executa outro statement, cujo profile é ignorado
+  l->ocupado = 1;
+  r->plano = plano(l->db, sqlite3_sql(stmt));
+  l->ocupado = 0;
+  return 0;
+}
+
+/* acrescenta os registros do buffer ao arquivo como script SQL comentado */
+static void grava_log(lentas_t *l, const char *arquivo)
+{
+  sqlite3_int64 seq;
+  FILE *f;
+
+  if (l->seq == 0 || !(f = fopen(arquivo, "a"))) return;
+  for (seq = primeiro(l); seq <= l->seq; ++seq) {
+    const registro_t *r = registro(l, seq);
+    char instante[32];
+    const char *c;
+
+    strftime(instante, sizeof(instante), "%Y-%m-%d %H:%M:%S", localtime(&r->instante));
+    fprintf(f, "-- %s | %.3f ms | scan %d | sort %d | autoindex %d | vm %d\n",
+      instante, r->tempo, r->passos_scan, r->ordenacoes, r->autoindices, r->passos_vm);
+    if (r->sql) {
+      // o terminador é acrescentado somente se ausente
+      size_t n = strlen(r->sql);
+      while (n > 0 && (r->sql[n-1] == ' ' || r->sql[n-1] == '\n')) --n;
+      fprintf(f, "%.*s%s\n", (int) n, r->sql, n > 0 && r->sql[n-1] == ';' ? "" : ";");
+    }
+    if (r->plano) {
+      fputs("--   ", f);
+      for (c = r->plano; *c; ++c) {
+        fputc(*c, f);
+        if (*c == '\n') fputs("--   ", f);
+      }
+      fputc('\n', f);
+    }
+    fputc('\n', f);
+  }
+  fclose(f);
+}
+
+/* invocada no fechamento da conexão ou recarga da extensão */
+static void destroi_lentas(void *p)
+{
+  lentas_t *l = (lentas_t *) p;
+  const char *arquivo = getenv("LENTAS_LOG");
+  int j;
+
+  if (arquivo && *arquivo) grava_log(l, arquivo);
+  for (j = 0; j < REGISTROS_MAX; ++j) libera_registro(&l->registros[j]);
+  sqlite3_free(l);
+}
+
+static int xConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(seq INTEGER, instante TEXT," \
+    " tempo REAL, sql TEXT, passos_scan INTEGER, ordenacoes INTEGER," \
+    " autoindices INTEGER, passos_vm INTEGER, plano TEXT)");
+  if (rc != SQLITE_OK) return rc;
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->lentas = (lentas_t *) aux;
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int xDisconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+static int xBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  info->estimatedCost = REGISTROS_MAX;
+  info->estimatedRows = REGISTROS_MAX;
+  return SQLITE_OK;
+}
+
+static int xOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cursor_t *c = sqlite3_malloc(sizeof(cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int xClose(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+static int xFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  ((cursor_t *) cur)->seq = primeiro(((tabela_t *) cur->pVtab)->lentas);
+  return SQLITE_OK;
+}
+
+static int xNext(sqlite3_vtab_cursor *cur)
+{
+  ++((cursor_t *) cur)->seq;
+  return SQLITE_OK;
+}
+
+/* o fim é reavaliado a cada linha, pois o buffer pode ter sido esvaziado */
+static int xEof(sqlite3_vtab_cursor *cur)
+{
+  const lentas_t *l = ((tabela_t *) cur->pVtab)->lentas;
+  return ((cursor_t *) cur)->seq > l->seq;
+}
+
+static int xColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  lentas_t *l = ((tabela_t *) cur->pVtab)->lentas;
+  const registro_t *r = registro(l, ((cursor_t *) cur)->seq);
+  char instante[32];
+
+  switch (col) {
+    case COL_SEQ:
+      sqlite3_result_int64(ctx, r->seq);
+      break;
+    case COL_INSTANTE:
+      strftime(instante, sizeof(instante), "%Y-%m-%d %H:%M:%S", localtime(&r->instante));
+      sqlite3_result_text(ctx, instante, -1, SQLITE_TRANSIENT);
+      break;
+    case COL_TEMPO:
+      sqlite3_result_double(ctx, r->tempo);
+      break;
+    case COL_SQL:
+      if (r->sql) sqlite3_result_text(ctx, r->sql, -1, SQLITE_TRANSIENT);
+      break;
+    case COL_PASSOS_SCAN:
+      sqlite3_result_int(ctx, r->passos_scan);
+      break;
+    case COL_ORDENACOES:
+      sqlite3_result_int(ctx, r->ordenacoes);
+      break;
+    case COL_AUTOINDICES:
+      sqlite3_result_int(ctx, r->autoindices);
+      break;
+    case COL_PASSOS_VM:
+      sqlite3_result_int(ctx, r->passos_vm);
+      break;
+    case COL_PLANO:
+      if (r->plano) sqlite3_result_text(ctx, r->plano, -1, SQLITE_TRANSIENT);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int xRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((cursor_t *) cur)->seq;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  xConnect,
+  xBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  xOpen,
+  xClose,
+  xFilter,
+  xNext,
+  xEof,
+  xColumn,
+  xRowid,
+};
+
+/* lentas_limiar([ms]) retorna o limiar vigente, alterando-o se informado */
+static void lentas_limiar(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  lentas_t *l = (lentas_t *) sqlite3_user_data(ctx);
+  const double anterior = l->limiar;
+
+  if (argc > 1) {
+    sqlite3_result_error(ctx, "lentas_limiar requer no máximo um argumento", -1);
+    return;
+  }
+  if (argc == 1) {
+    if (sqlite3_value_numeric_type(argv[0]) != SQLITE_INTEGER
+      && sqlite3_value_numeric_type(argv[0]) != SQLITE_FLOAT) {
+      sqlite3_result_error(ctx, "limiar deve ser numérico em milissegundos", -1);
+      return;
+    }
+    l->limiar = sqlite3_value_double(argv[0]);
+  }
+  sqlite3_result_double(ctx, anterior);
+}
+
+/* esvazia o buffer retornando a quantidade de registros descartados */
+static void lentas_reset(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  lentas_t *l = (lentas_t *) sqlite3_user_data(ctx);
+  const sqlite3_int64 n = l->seq - primeiro(l) + 1;
+  int j;
+
+  for (j = 0; j < REGISTROS_MAX; ++j) libera_registro(&l->registros[j]);
+  l->seq = 0;
+  sqlite3_result_int64(ctx, n);
+}
+
+int sqlite3_lentas_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  const char *limiar = getenv("LENTAS_LIMIAR");
+  lentas_t *l;
+  int rc;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  l = sqlite3_malloc(sizeof(lentas_t));
+  if (!l) return SQLITE_NOMEM;
+  memset(l, 0, sizeof(lentas_t));
+  l->db = db;
+  l->limiar = limiar && *limiar ? atof(limiar) : LIMIAR_DEFAULT;
+
+  // o estado é liberado com o módulo, no fechamento da conexão
+  rc = sqlite3_create_module_v2(db, "consultas_lentas", &modulo, l, destroi_lentas);
+  if (rc != SQLITE_OK) return rc;
+  rc = sqlite3_create_function(db, "lentas_limiar", -1, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+    l, lentas_limiar, NULL, NULL);
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_function(db, "lentas_reset", 0, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+      l, lentas_reset, NULL, NULL);
+  }
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, profile, l);
+  }
+  return rc;
+}
@@ -0,0 +1,64 @@
+/*
+ * Registro estático das extensões do projeto no shell "megasena-sqlite":
+ *
+ *    more-functions, calendar, regexp, crypt, resultados, dezenas,
+ *    combinacoes, series
+ *
+ * A função é invocada pelo próprio SQLite ao final de sqlite3_initialize(),
+ * quando a "amalgamation" é compilada com -DSQLITE_EXTRA_INIT, registrando as
+ * extensões via sqlite3_auto_extension, de modo que toda conexão aberta já as
+ * disponibiliza, dispensando ".load" e a configuração do "locale" a cada
+ * execução dos scripts.
+ *
+ * Compilação via makefile:
+ *
+ *    make megasena-sqlite AMALGAMATION=path_to/sqlite-amalgamation-3xxxxxx
+ *
+ * Uso em substituição ao comando "sqlite3 -init sqlite/onload":
+ *
+ *    sqlite/megasena-sqlite -separator ' ' megasena.sqlite
+ *
+ * Experimental: o registro estático foi verificado apenas com a libsqlite3
+ * do sistema, sem o shell da "amalgamation", cujo ganho no tempo de
+ * inicialização via "make bench-startup" permanece por medir.
+*/
+#include <sqlite3.h>
+#include <locale.h>
+
+typedef int (*entry_point_t)(sqlite3 *, char **, const sqlite3_api_routines *);
+
+int sqlite3_morefunctions_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_calendar_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_crypt_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_resultados_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_dezenas_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_combinacoes_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_series_init(sqlite3 *, char **, const sqlite3_api_routines *);
+#ifndef SEM_REGEXP
+int sqlite3_regexp_init(sqlite3 *, char **, const sqlite3_api_routines *);
+#endif
+
+int megasena_extra_init(const char *unused)
+{
+  static const entry_point_t EXTENSIONS[] = {
+    sqlite3_morefunctions_init,
+    sqlite3_calendar_init,
+    sqlite3_crypt_init,
+    sqlite3_resultados_init,
+    sqlite3_dezenas_init,
+    sqlite3_combinacoes_init,
+    sqlite3_series_init,
+#ifndef SEM_REGEXP
+    sqlite3_regexp_init,
+#endif
+  };
+  int j, rc = SQLITE_OK;
+
+  // configuração única do "locale" usado na formatação de valores monetários
+  (void) setlocale(LC_ALL, "");
+
+  for (j = 0; rc == SQLITE_OK && j < sizeof(EXTENSIONS)/sizeof(EXTENSIONS[0]); ++j) {
+    rc = sqlite3_auto_extension((void (*)(void)) EXTENSIONS[j]);
+  }
+  return rc;
+}
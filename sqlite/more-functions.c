@@ -9,14 +9,25 @@
  *
  * Bitwise aggregation: GROUP_BITOR, GROUP_NDXBITOR
  *
+ * Bitsets of games up to 128 numbers: BITSET, BITSET_AND, BITSET_OR,
+ *   BITSET_COUNT, BITSET_COMMON, BITSET_HAS, BITSET_LIST, JOGO
+ *
  * Miscellaneous: MASK60, QUADRANTE, ROWNUM
  *
+ * Statistics aggregation: HISTOGRAMA_PERFIL, BATERIA_ALEATORIEDADE,
+ *   CHISQ_CONTINGENCIA, ESTATISTICAS (também função de janela)
+ *
  * Compile: gcc more-functions.c -fPIC -shared -lm -o more-functions.so
  *
  * Usage: .load "path_to_lib/more-functions.so"
  * or also for JDBC: select load_extension("path_to_lib/more-functions.so");
+ *
+ * Compiled with -DSQLITE_CORE it may be statically linked into an application
+ * and registered via sqlite3_auto_extension(sqlite3_morefunctions_init).
 */
+#ifndef SQLITE_CORE
 #define COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE 1
+#endif
 
 #ifdef COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE
 #include "sqlite3ext.h"
@@ -26,6 +37,7 @@ SQLITE_EXTENSION_INIT1
 #endif
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -38,6 +50,9 @@ typedef int64_t   i64;
 #include <math.h>
 #include <errno.h>		/* LMH 2007-03-25 */
 
+#define EXT_STATS_EXTENSAO "more-functions"
+#include "ext-stats.h"
+
 /*
  * Wraps the pow math.h function
 */
@@ -81,106 +96,1357 @@ static void group_productStep(sqlite3_context *context, int argc, sqlite3_value
   p->rB += log(value);
 }
 
-static void group_productFinalize(sqlite3_context *context)
+static void group_productFinalize(sqlite3_context *context)
+{
+  ProductCtx *p;
+  double value = 0;
+  p = sqlite3_aggregate_context(context, 0);
+  value = exp(p->rB);
+  sqlite3_result_double(context, value);
+}
+
+#include <limits.h>
+
+#define I64_NBITS (sizeof(i64) * CHAR_BIT)
+
+static char *int2bin(i64 n, char *buf)
+{
+  char *t;
+  for (t = buf+I64_NBITS, *t = '\0'; t != buf; n >>= 1) *(--t) = (n & 1) | '0';
+  return buf;
+}
+
+/*
+ * Returns the binary representation string of an integer up to 64 bits.
+*/
+static void int2binFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  char buffer[I64_NBITS+1];
+
+  assert( 1 == argc );
+
+  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) ) {
+    int2bin(sqlite3_value_int64(argv[0]), buffer);
+    sqlite3_result_text(context, buffer, I64_NBITS, SQLITE_TRANSIENT);
+  } else {
+    sqlite3_result_error(context, "invalid type", -1);
+  }
+}
+
+
+/*
+ * Bitsets de largura fixa dos números de jogos de até 128 números, i.e.; a
+ * generalização dos bitmasks inteiros de 64 bits para jogos como Quina e
+ * Lotomania, com o número N no bit N-1 e armazenados como BLOBs de 16 bytes,
+ * as duas palavras de 64 bits em ordem "little-endian". As funções aceitam
+ * também bitmasks INTEGER, equivalentes a bitsets com a segunda palavra nula.
+*/
+#define BITSET_PALAVRAS 2
+#define BITSET_BYTES    (8 * BITSET_PALAVRAS)
+#define BITSET_MAX      (64 * BITSET_PALAVRAS)
+
+typedef struct Bitset {
+  uint64_t w[BITSET_PALAVRAS];
+}
+Bitset;
+
+/*
+ * Geometria do jogo: quantidade de números, de números sorteados por concurso
+ * e de colunas do boleto, cujas linhas agrupadas duas a duas e colunas duas a
+ * duas formam os quadrantes de "quadrante()".
+*/
+typedef struct Jogo {
+  const char *nome;
+  int numeros, sorteados, colunas;
+}
+Jogo;
+
+static const Jogo JOGOS[] = {
+  { "megasena",   60,  6, 10 },
+  { "quina",      80,  5, 10 },
+  { "lotomania", 100, 20, 10 },
+  { "lotofacil",  25, 15,  5 },
+};
+
+/*
+ * "popcount" nativo nos kernels sem exigir flags de compilação, com kernels
+ * genéricos para processadores sem a instrução, escolhidos em tempo de
+ * execução.
+*/
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <emmintrin.h>
+#define POPCNT __attribute__((target("popcnt")))
+#define POPCNT_NATIVO() (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"))
+#else
+#define POPCNT
+#define POPCNT_NATIVO() 0
+#endif
+
+#define SEMPRE_INLINE inline __attribute__((always_inline))
+
+/* kernels especializados na quantidade de palavras do jogo */
+
+static SEMPRE_INLINE int conta_1(const Bitset *a)
+{
+  return __builtin_popcountll(a->w[0]);
+}
+
+static SEMPRE_INLINE int comuns_1(const Bitset *a, const Bitset *b)
+{
+  return __builtin_popcountll(a->w[0] & b->w[0]);
+}
+
+static SEMPRE_INLINE int conta_2(const Bitset *a)
+{
+  return __builtin_popcountll(a->w[0]) + __builtin_popcountll(a->w[1]);
+}
+
+static SEMPRE_INLINE int comuns_2(const Bitset *a, const Bitset *b)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+  const __m128i x = _mm_and_si128(_mm_loadu_si128((const __m128i *) a->w),
+    _mm_loadu_si128((const __m128i *) b->w));
+  return __builtin_popcountll(_mm_cvtsi128_si64(x))
+    + __builtin_popcountll(_mm_cvtsi128_si64(_mm_unpackhi_epi64(x, x)));
+#else
+  return __builtin_popcountll(a->w[0] & b->w[0]) + __builtin_popcountll(a->w[1] & b->w[1]);
+#endif
+}
+
+static POPCNT int conta_1_popcnt(const Bitset *a) { return conta_1(a); }
+static POPCNT int comuns_1_popcnt(const Bitset *a, const Bitset *b) { return comuns_1(a, b); }
+static POPCNT int conta_2_popcnt(const Bitset *a) { return conta_2(a); }
+static POPCNT int comuns_2_popcnt(const Bitset *a, const Bitset *b) { return comuns_2(a, b); }
+
+/* kernels indexados por [popcnt nativo][palavras - 1] */
+static int (*const CONTA[2][2])(const Bitset *) = {
+  { conta_1, conta_2 }, { conta_1_popcnt, conta_2_popcnt }
+};
+static int (*const COMUNS[2][2])(const Bitset *, const Bitset *) = {
+  { comuns_1, comuns_2 }, { comuns_1_popcnt, comuns_2_popcnt }
+};
+
+/*
+ * Geometria vigente na conexão, compartilhada pelas funções que dependem do
+ * jogo, lida da tabela "properties" na carga da extensão:
+ *
+ *    INSERT INTO properties (key, value) VALUES ('jogo', 'quina');
+ *
+ * ou selecionada na sessão via "jogo(nome)".
+*/
+typedef struct Geometria {
+  const Jogo *jogo;
+  int palavras;             /* palavras de 64 bits necessárias ao jogo */
+  int (*conta)(const Bitset *);
+  int (*comuns)(const Bitset *, const Bitset *);
+  int refs;                 /* funções registradas com a geometria */
+}
+Geometria;
+
+static void seleciona_jogo(Geometria *g, const Jogo *jogo)
+{
+  const int nativo = POPCNT_NATIVO() != 0;
+
+  g->jogo = jogo;
+  g->palavras = (jogo->numeros + 63) / 64;
+  g->conta = CONTA[nativo][g->palavras - 1];
+  g->comuns = COMUNS[nativo][g->palavras - 1];
+}
+
+static const Jogo *procura_jogo(const char *nome)
+{
+  int i;
+  for (i=0; nome && i < sizeof(JOGOS)/sizeof(JOGOS[0]); i++) {
+    if (sqlite3_stricmp(nome, JOGOS[i].nome) == 0) return &JOGOS[i];
+  }
+  return 0;
+}
+
+static void libera_geometria(void *ptr)
+{
+  Geometria *g = (Geometria *) ptr;
+  if (--g->refs == 0) sqlite3_free(g);
+}
+
+/*
+ * Lê o bitmask INTEGER ou bitset BLOB do argumento, reportando erro se o tipo
+ * é inválido ou se contém números além dos do jogo.
+*/
+static int le_bitset(sqlite3_context *context, const Geometria *g, sqlite3_value *arg, Bitset *b)
+{
+  const unsigned char *z;
+  int i, n = g->jogo->numeros;
+  char erro[64];
+
+  memset(b, 0, sizeof(Bitset));
+  switch ( sqlite3_value_type(arg) ) {
+    case SQLITE_INTEGER:
+      b->w[0] = (uint64_t) sqlite3_value_int64(arg);
+      break;
+    case SQLITE_BLOB:
+      if (sqlite3_value_bytes(arg) == BITSET_BYTES) {
+        z = (const unsigned char *) sqlite3_value_blob(arg);
+        for (i=BITSET_BYTES-1; i >= 0; i--) b->w[i/8] = (b->w[i/8] << 8) | z[i];
+        break;
+      }
+    default:
+      sqlite3_result_error(context, "tipo do argumento é invalido", -1);
+      return 0;
+  }
+  if ((n < 64 && (b->w[0] >> n)) || (n < 128 && (b->w[1] >> (n < 64 ? 0 : n - 64)))) {
+    snprintf(erro, sizeof(erro), "bitset excede os números 1 a %d", n);
+    sqlite3_result_error(context, erro, -1);
+    return 0;
+  }
+  return 1;
+}
+
+/* resultado como bitmask INTEGER ou, se "blob", como bitset BLOB */
+static void resultado_bitset(sqlite3_context *context, const Bitset *b, int blob)
+{
+  unsigned char z[BITSET_BYTES];
+  int i;
+
+  if (!blob) {
+    sqlite3_result_int64(context, (i64) b->w[0]);
+    return;
+  }
+  for (i=0; i < BITSET_BYTES; i++) z[i] = (unsigned char) (b->w[i/8] >> (8 * (i%8)));
+  sqlite3_result_blob(context, z, BITSET_BYTES, SQLITE_TRANSIENT);
+}
+
+/*
+ * Monta máscara de incidência dos números do jogo agrupados via bitwise OR
+ * no único argumento, bitmask inteiro ou bitset.
+*/
+static void mask60Func(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  char buffer[BITSET_MAX];
+  Bitset b;
+  int i;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) && sqlite3_value_int64(argv[0]) < 0 ) {
+    sqlite3_result_error(context, "argumento é negativo", -1);
+  } else if (le_bitset(context, g, argv[0], &b)) {
+    for (i=0; i < g->jogo->numeros; i++) buffer[i] = ((b.w[i/64] >> (i%64)) & 1) | '0';
+    sqlite3_result_text(context, buffer, g->jogo->numeros, SQLITE_TRANSIENT);
+  }
+}
+
+/*
+ * Retorna o quadrante do número conforme apresentado no boleto do jogo.
+*/
+static void quadranteFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  char erro[64];
+  int d, q;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) ) {
+    d = sqlite3_value_int(argv[0]);
+    if (d < 1 || d > g->jogo->numeros) {
+      snprintf(erro, sizeof(erro), "argumento é menor que 1 ou maior que %d", g->jogo->numeros);
+      sqlite3_result_error(context, erro, -1);
+      return;
+    }
+    q = ((d-1) / (2 * g->jogo->colunas) + 1) * 10 + (((d-1) % g->jogo->colunas) / 2 + 1);
+    sqlite3_result_int(context, q);
+  } else {
+    sqlite3_result_error(context, "argumento não é do tipo inteiro", -1);
+    return;
+  }
+}
+
+/*
+ * jogo([nome]) -> '{"jogo":"megasena","numeros":60,"sorteados":6,"colunas":10,
+ *                   "palavras":1}'
+ *
+ * Geometria vigente na conexão, selecionando antes o jogo nomeado se houver.
+*/
+static void jogoFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  Geometria *g = (Geometria *) sqlite3_user_data(context);
+  const Jogo *jogo;
+  char buffer[256];
+
+  if (argc == 1) {
+    if (!(jogo = procura_jogo((const char *) sqlite3_value_text(argv[0])))) {
+      sqlite3_result_error(context, "jogo desconhecido: megasena, quina, lotomania ou lotofacil", -1);
+      return;
+    }
+    seleciona_jogo(g, jogo);
+  }
+  snprintf(buffer, sizeof(buffer),
+    "{\"jogo\":\"%s\",\"numeros\":%d,\"sorteados\":%d,\"colunas\":%d,\"palavras\":%d}",
+    g->jogo->nome, g->jogo->numeros, g->jogo->sorteados, g->jogo->colunas, g->palavras);
+  sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+}
+
+/*
+ * Seleciona o jogo configurado no db, se disponível, senão a Mega-Sena,
+ * evitando erro na abertura da conexão se a tabela "properties" inexiste.
+*/
+static void carrega_geometria(sqlite3 *db, Geometria *g)
+{
+  const Jogo *jogo = 0;
+  sqlite3_stmt *stmt = 0;
+
+  if (sqlite3_prepare_v2(db, "SELECT value FROM properties WHERE key == 'jogo'",
+    -1, &stmt, NULL) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+    jogo = procura_jogo((const char *) sqlite3_column_text(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  seleciona_jogo(g, jogo ? jogo : &JOGOS[0]);
+}
+
+#ifndef SQLITE_DETERMINISTIC
+#define SQLITE_DETERMINISTIC 0
+#endif
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+#ifndef SQLITE_DIRECTONLY
+#define SQLITE_DIRECTONLY 0
+#endif
+
+/*
+ * Máscaras constantes das categorias dos números da Mega-Sena, com o número
+ * N no bit N-1 tal como em "dezenas_juntadas": números pares, decádas (01-10,
+ * 11-20, ..., 51-60) que são também as linhas do boleto, colunas do boleto
+ * (números com a mesma unidade) e quadrantes conforme "quadrante()".
+*/
+#define MASK_PARES      0x0AAAAAAAAAAAAAAALL
+#define MASK_60         0x0FFFFFFFFFFFFFFFLL
+#define MASK_DECADA(i)  (0x3FFLL << (10 * (i)))
+#define MASK_COLUNA(j)  (0x0004010040100401LL << (j))
+#define MASK_QUADRANTE(b, p)  (0xC03LL << (2 * (p) + 20 * (b)))
+
+#define N_DECADAS     6
+#define N_COLUNAS     10
+#define N_QUADRANTES  15
+
+static const i64 DECADAS[N_DECADAS] = {
+  MASK_DECADA(0), MASK_DECADA(1), MASK_DECADA(2),
+  MASK_DECADA(3), MASK_DECADA(4), MASK_DECADA(5)
+};
+
+static const i64 COLUNAS[N_COLUNAS] = {
+  MASK_COLUNA(0), MASK_COLUNA(1), MASK_COLUNA(2), MASK_COLUNA(3), MASK_COLUNA(4),
+  MASK_COLUNA(5), MASK_COLUNA(6), MASK_COLUNA(7), MASK_COLUNA(8), MASK_COLUNA(9)
+};
+
+/* na ordem dos códigos 11..15, 21..25 e 31..35 de "quadrante()" */
+static const i64 QUADRANTES[N_QUADRANTES] = {
+  MASK_QUADRANTE(0, 0), MASK_QUADRANTE(0, 1), MASK_QUADRANTE(0, 2),
+  MASK_QUADRANTE(0, 3), MASK_QUADRANTE(0, 4),
+  MASK_QUADRANTE(1, 0), MASK_QUADRANTE(1, 1), MASK_QUADRANTE(1, 2),
+  MASK_QUADRANTE(1, 3), MASK_QUADRANTE(1, 4),
+  MASK_QUADRANTE(2, 0), MASK_QUADRANTE(2, 1), MASK_QUADRANTE(2, 2),
+  MASK_QUADRANTE(2, 3), MASK_QUADRANTE(2, 4)
+};
+
+#define POPCOUNT(m) __builtin_popcountll((unsigned long long) (m))
+
+typedef struct Perfil {
+  int pares;
+  int quadrantes[N_QUADRANTES];
+  int decadas[N_DECADAS];
+  int colunas[N_COLUNAS];
+  int soma;
+}
+Perfil;
+
+static void monta_perfil(i64 mask, Perfil *p)
+{
+  unsigned long long m;
+  int i;
+
+  p->pares = POPCOUNT(mask & MASK_PARES);
+  for (i=0; i < N_QUADRANTES; i++) p->quadrantes[i] = POPCOUNT(mask & QUADRANTES[i]);
+  for (i=0; i < N_DECADAS; i++) p->decadas[i] = POPCOUNT(mask & DECADAS[i]);
+  for (i=0; i < N_COLUNAS; i++) p->colunas[i] = POPCOUNT(mask & COLUNAS[i]);
+  for (p->soma=0, m=mask; m; m &= m-1) p->soma += __builtin_ctzll(m) + 1;
+}
+
+/* concatena o array de inteiros no formato JSON */
+static char *json_array(char *z, const int *v, int n)
+{
+  int i;
+  *z++ = '[';
+  for (i=0; i < n; i++) z += sprintf(z, i ? ",%d" : "%d", v[i]);
+  *z++ = ']';
+  *z = '\0';
+  return z;
+}
+
+/* valida o argumento bitmask dos números, reportando erro se inválido */
+static int perfil_mask(sqlite3_context *context, sqlite3_value *arg, i64 *mask)
+{
+  if ( SQLITE_INTEGER != sqlite3_value_type(arg) ) {
+    sqlite3_result_error(context, "tipo do argumento é invalido", -1);
+    return 0;
+  }
+  *mask = sqlite3_value_int64(arg);
+  if (*mask < 0 || (*mask & ~MASK_60)) {
+    sqlite3_result_error(context, "bitmask excede os números 1 a 60", -1);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * Perfil da combinação de números no bitmask do primeiro argumento, tal como
+ * em "dezenas_juntadas", obtido via máscaras constantes e popcount:
+ *
+ *   perfil(mask) -> '{"pares":P,"quadrantes":[...15],"decadas":[...6],
+ *                     "colunas":[...10],"soma":S}'
+ *
+ * ou somente o componente nomeado no segundo argumento, inteiro para "pares"
+ * e "soma" ou array JSON para os demais:
+ *
+ *   perfil(mask, 'pares')
+ *
+ * É determinística e inócua, portanto utilizável em colunas geradas e índices.
+*/
+static void perfilFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  char buffer[256], *z = buffer;
+  const char *campo = 0;
+  Perfil p;
+  i64 mask;
+
+  assert( 1 == argc || 2 == argc );
+
+  if (!perfil_mask(context, argv[0], &mask)) return;
+  monta_perfil(mask, &p);
+
+  if (argc == 2) {
+    campo = (const char *) sqlite3_value_text(argv[1]);
+    if (!campo) {
+      sqlite3_result_null(context);
+    } else if (strcmp(campo, "pares") == 0) {
+      sqlite3_result_int(context, p.pares);
+    } else if (strcmp(campo, "soma") == 0) {
+      sqlite3_result_int(context, p.soma);
+    } else if (strcmp(campo, "quadrantes") == 0) {
+      json_array(z, p.quadrantes, N_QUADRANTES);
+      sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+    } else if (strcmp(campo, "decadas") == 0) {
+      json_array(z, p.decadas, N_DECADAS);
+      sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+    } else if (strcmp(campo, "colunas") == 0) {
+      json_array(z, p.colunas, N_COLUNAS);
+      sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+    } else {
+      sqlite3_result_error(context, "componente do perfil desconhecido", -1);
+    }
+    return;
+  }
+
+  z += sprintf(z, "{\"pares\":%d,\"quadrantes\":", p.pares);
+  z = json_array(z, p.quadrantes, N_QUADRANTES);
+  z += sprintf(z, ",\"decadas\":");
+  z = json_array(z, p.decadas, N_DECADAS);
+  z += sprintf(z, ",\"colunas\":");
+  z = json_array(z, p.colunas, N_COLUNAS);
+  sprintf(z, ",\"soma\":%d}", p.soma);
+  sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+}
+
+typedef struct PerfilCtx {
+  i64 n;
+  i64 pares[7];
+  i64 quadrantes[N_QUADRANTES];
+  i64 decadas[N_DECADAS];
+  i64 colunas[N_COLUNAS];
+  i64 soma;
+  int somaMin, somaMax;
+}
+PerfilCtx;
+
+/*
+ * Acumula os perfis dos bitmasks agrupados: distribuição das quantidades de
+ * números pares, totais por quadrante, decáda e coluna e estatísticas das
+ * somas.
+*/
+static void histograma_perfilStep(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  PerfilCtx *h;
+  Perfil p;
+  i64 mask;
+  int i;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) ) return;
+  if (!perfil_mask(context, argv[0], &mask)) return;
+  h = sqlite3_aggregate_context(context, sizeof(PerfilCtx));
+  if (!h) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  monta_perfil(mask, &p);
+  if (p.pares <= 6) ++h->pares[p.pares];
+  for (i=0; i < N_QUADRANTES; i++) h->quadrantes[i] += p.quadrantes[i];
+  for (i=0; i < N_DECADAS; i++) h->decadas[i] += p.decadas[i];
+  for (i=0; i < N_COLUNAS; i++) h->colunas[i] += p.colunas[i];
+  if (h->n == 0 || p.soma < h->somaMin) h->somaMin = p.soma;
+  if (h->n == 0 || p.soma > h->somaMax) h->somaMax = p.soma;
+  h->soma += p.soma;
+  ++h->n;
+}
+
+static char *json_array64(char *z, const i64 *v, int n)
+{
+  int i;
+  *z++ = '[';
+  for (i=0; i < n; i++) z += sprintf(z, i ? ",%lld" : "%lld", (long long) v[i]);
+  *z++ = ']';
+  *z = '\0';
+  return z;
+}
+
+/*
+ *   histograma_perfil(mask) -> '{"n":N,"pares":[...7],"quadrantes":[...15],
+ *     "decadas":[...6],"colunas":[...10],"soma":{"min":A,"max":B,"media":M}}'
+ *
+ * onde "pares" é a quantidade de combinações com 0 a 6 números pares.
+*/
+static void histograma_perfilFinalize(sqlite3_context *context)
+{
+  PerfilCtx *h = sqlite3_aggregate_context(context, 0);
+  char buffer[1024], *z = buffer;
+
+  if (!h || h->n == 0) {
+    sqlite3_result_null(context);
+    return;
+  }
+  z += sprintf(z, "{\"n\":%lld,\"pares\":", (long long) h->n);
+  z = json_array64(z, h->pares, 7);
+  z += sprintf(z, ",\"quadrantes\":");
+  z = json_array64(z, h->quadrantes, N_QUADRANTES);
+  z += sprintf(z, ",\"decadas\":");
+  z = json_array64(z, h->decadas, N_DECADAS);
+  z += sprintf(z, ",\"colunas\":");
+  z = json_array64(z, h->colunas, N_COLUNAS);
+  sprintf(z, ",\"soma\":{\"min\":%d,\"max\":%d,\"media\":%.6f}}",
+    h->somaMin, h->somaMax, (double) h->soma / h->n);
+  sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+}
+
+/*
+ * Bateria de testes clássicos de aleatoriedade acumulados numa única
+ * passagem ordenada pelos bitmasks dos concursos.
+*/
+#define N_COMBINACOES   50063860      /* C(60,6) */
+#define SOMA_MIN        21
+#define SOMA_MAX        345
+#define GAP_MAX         256           /* classe final agrega gaps >= GAP_MAX */
+#define ANIVERSARIOS    512           /* concursos por grupo no birthday spacings */
+#define ESPERADO_MIN    5.0           /* frequência esperada mínima por classe */
+
+typedef struct BateriaCtx {
+  i64 n;
+  i64 frequencias[60];
+  i64 ultimo[60];                     /* índice+1 do último concurso com o número */
+  i64 gaps[GAP_MAX+1];
+  i64 coincidencias[7];               /* números comuns a concursos sucessivos */
+  i64 somas[SOMA_MAX+1];
+  i64 poker[N_DECADAS+1];             /* quantidade de decádas ocupadas */
+  i64 anterior;
+  i64 acima, abaixo, corridas;        /* runs acima/abaixo da soma média 183 */
+  int sinal;
+  i64 ranks[ANIVERSARIOS];
+  int nranks;
+  i64 grupos, repeticoes;
+}
+BateriaCtx;
+
+static i64 binomial(int n, int k)
+{
+  i64 r = 1;
+  int i;
+  if (k < 0 || k > n) return 0;
+  for (i=1; i <= k; i++) r = r * (n - k + i) / i;
+  return r;
+}
+
+/* rank colexicográfico da combinação de 6 números no bitmask */
+static i64 rank_colex(i64 mask)
+{
+  unsigned long long m;
+  i64 r = 0;
+  int i;
+  for (i=1, m=mask; m; m &= m-1, i++) r += binomial(__builtin_ctzll(m), i);
+  return r;
+}
+
+static int compara_i64(const void *a, const void *b)
+{
+  i64 x = *(const i64 *) a, y = *(const i64 *) b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Birthday spacings de Marsaglia: os ranks do grupo são os aniversários num
+ * "ano" de C(60,6) dias, contando os espaçamentos repetidos.
+*/
+static void bateria_aniversarios(BateriaCtx *h)
+{
+  i64 *r = h->ranks;
+  int i, n = h->nranks;
+
+  qsort(r, n, sizeof(i64), compara_i64);
+  for (i=n-1; i > 0; i--) r[i] -= r[i-1];
+  qsort(r+1, n-1, sizeof(i64), compara_i64);
+  for (i=2; i < n; i++) if (r[i] == r[i-1]) ++h->repeticoes;
+  ++h->grupos;
+  h->nranks = 0;
+}
+
+static void bateria_aleatoriedadeStep(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  BateriaCtx *h;
+  Perfil p;
+  i64 mask;
+  unsigned long long m;
+  int i, s, d;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) ) return;
+  if (!perfil_mask(context, argv[0], &mask)) return;
+  if (POPCOUNT(mask) != 6) {
+    sqlite3_result_error(context, "bitmask não contém 6 números", -1);
+    return;
+  }
+  h = sqlite3_aggregate_context(context, sizeof(BateriaCtx));
+  if (!h) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  monta_perfil(mask, &p);
+
+  for (m=mask; m; m &= m-1) {
+    i = __builtin_ctzll(m);
+    ++h->frequencias[i];
+    if (h->ultimo[i]) {
+      d = h->n + 1 - h->ultimo[i];
+      ++h->gaps[d < GAP_MAX ? d : GAP_MAX];
+    }
+    h->ultimo[i] = h->n + 1;
+  }
+  if (h->n > 0) ++h->coincidencias[POPCOUNT(mask & h->anterior)];
+  h->anterior = mask;
+
+  ++h->somas[p.soma];
+  for (i=d=0; i < N_DECADAS; i++) d += p.decadas[i] > 0;
+  ++h->poker[d];
+
+  s = p.soma > 183 ? 1 : p.soma < 183 ? -1 : 0;
+  if (s) {
+    if (s > 0) ++h->acima; else ++h->abaixo;
+    if (s != h->sinal) ++h->corridas;
+    h->sinal = s;
+  }
+
+  h->ranks[h->nranks++] = rank_colex(mask);
+  if (h->nranks == ANIVERSARIOS) bateria_aniversarios(h);
+  ++h->n;
+}
+
+/*
+ * Função gama incompleta regularizada superior Q(a,x) via série para
+ * x < a+1 ou fração continuada de Lentz caso contrário.
+*/
+static double gama_q(double a, double x)
+{
+  double soma, termo, b, c, d, f, an;
+  int i;
+
+  if (x <= 0) return 1.0;
+  if (x < a + 1) {
+    for (soma=termo=1/a, i=1; i < 1000; i++) {
+      termo *= x / (a + i);
+      soma += termo;
+      if (fabs(termo) < fabs(soma) * 1e-15) break;
+    }
+    return 1 - soma * exp(-x + a * log(x) - lgamma(a));
+  }
+  b = x + 1 - a;
+  c = 1 / 1e-300;
+  d = 1 / b;
+  f = d;
+  for (i=1; i < 1000; i++) {
+    an = -i * (i - a);
+    b += 2;
+    d = an * d + b;
+    if (fabs(d) < 1e-300) d = 1e-300;
+    c = b + an / c;
+    if (fabs(c) < 1e-300) c = 1e-300;
+    d = 1 / d;
+    f *= d * c;
+    if (fabs(d * c - 1) < 1e-15) break;
+  }
+  return exp(-x + a * log(x) - lgamma(a)) * f;
+}
+
+/* p-valor da estatística qui-quadrado com gl graus de liberdade */
+static double chi2_p(double x, int gl)
+{
+  return gl > 0 ? gama_q(gl / 2.0, x / 2.0) : 1.0;
+}
+
+/*
+ * Qui-quadrado de Pearson das frequências observadas nas n classes com as
+ * probabilidades dadas, agrupando classes adjacentes até a frequência
+ * esperada mínima.
+*/
+static double chi2_agrupado(const i64 *obs, const double *prob, int n, i64 total, int *gl)
+{
+  double chi2 = 0, o = 0, e = 0, ultimoO = 0, ultimoE = 0;
+  int i, classes = 0;
+
+  for (i=0; i < n; i++) {
+    o += obs[i];
+    e += prob[i] * total;
+    if (e >= ESPERADO_MIN) {
+      if (classes) chi2 += (ultimoO - ultimoE) * (ultimoO - ultimoE) / ultimoE;
+      ultimoO = o; ultimoE = e;
+      ++classes;
+      o = e = 0;
+    }
+  }
+  /* resíduo insuficiente é agregado à última classe formada */
+  ultimoO += o; ultimoE += e;
+  if (ultimoE > 0) {
+    chi2 += (ultimoO - ultimoE) * (ultimoO - ultimoE) / ultimoE;
+    if (!classes) classes = 1;
+  }
+  *gl = classes - 1;
+  return chi2;
+}
+
+/* teste sem graus de liberdade ou com estatística indefinida resulta em null */
+static char *json_teste(char *z, const char *nome, double estatistica, int gl, double p)
+{
+  if (gl < 1 || !isfinite(estatistica) || !isfinite(p)) {
+    return z + sprintf(z, ",\"%s\":null", nome);
+  }
+  return z + sprintf(z, ",\"%s\":{\"estatistica\":%.6f,\"gl\":%d,\"p\":%.6g}",
+    nome, estatistica, gl, p);
+}
+
+/*
+ *   bateria_aleatoriedade(mask) -> '{"n":N,"frequencia":{...},"serial":{...},
+ *     "gap":{...},"runs":{...},"soma":{...},"poker":{...},"aniversarios":{...}}'
+ *
+ * Cada teste reporta "estatistica", "gl" e o p-valor "p", devendo os
+ * bitmasks ser agregados na ordem dos concursos, explícita na agregação a
+ * partir da versão 3.44 do SQLite, pois a ordem de subconsultas não é
+ * garantida à agregação externa:
+ *
+ *   SELECT bateria_aleatoriedade(dezenas ORDER BY concurso) FROM dezenas_juntadas;
+ *
+ *   frequencia    qui-quadrado das frequências dos 60 números, escalado pela
+ *                 covariância do sorteio de 6 sem reposição
+ *   serial        números comuns a concursos sucessivos vs hipergeométrica
+ *   gap           intervalos entre ocorrências de cada número vs geométrica
+ *                 com p=0.1
+ *   runs          Wald-Wolfowitz das somas acima/abaixo da média 183, com
+ *                 estatística z e "gl" nulo
+ *   soma          distribuição exata das somas das combinações
+ *   poker         quantidade de decádas ocupadas pelos números
+ *   aniversarios  birthday spacings dos ranks colexicográficos em grupos de
+ *                 512 concursos, repetições vs Poisson com "esperado" e
+ *                 p-valor bilateral
+ *
+ * O teste é null quando não calculável com os concursos agregados, i.e.;
+ * sem ao menos duas classes com a frequência esperada mínima, com variância
+ * nula ou sem grupos completos.
+*/
+static void bateria_aleatoriedadeFinalize(sqlite3_context *context)
+{
+  BateriaCtx *h = sqlite3_aggregate_context(context, 0);
+  char buffer[2048], *z = buffer;
+  double prob[SOMA_MAX+1], maneiras[7][SOMA_MAX+1], poker[7][7];
+  double chi2, e, total, mu, var, lambda, pa, pb;
+  i64 nr;
+  int i, j, k, c, gl;
+
+  if (!h || h->n == 0) {
+    sqlite3_result_null(context);
+    return;
+  }
+  total = (double) N_COMBINACOES;
+  z += sprintf(z, "{\"n\":%lld", (long long) h->n);
+
+  /* variância de cada frequência menos a covariância entre frequências */
+  e = h->n / 10.0;
+  for (chi2=0, i=0; i < 60; i++) chi2 += (h->frequencias[i] - e) * (h->frequencias[i] - e);
+  chi2 /= h->n * (6.0 * 54) / (60 * 59);
+  z = json_teste(z, "frequencia", chi2, 59, chi2_p(chi2, 59));
+
+  for (k=0; k <= 6; k++) prob[k] = binomial(6, k) * binomial(54, 6-k) / total;
+  chi2 = chi2_agrupado(h->coincidencias, prob, 7, h->n - 1, &gl);
+  z = json_teste(z, "serial", chi2, gl, chi2_p(chi2, gl));
+
+  for (nr=0, i=1; i <= GAP_MAX; i++) nr += h->gaps[i];
+  for (i=1; i < GAP_MAX; i++) prob[i] = 0.1 * pow(0.9, i - 1);
+  prob[GAP_MAX] = pow(0.9, GAP_MAX - 1);
+  chi2 = chi2_agrupado(h->gaps+1, prob+1, GAP_MAX, nr, &gl);
+  z = json_teste(z, "gap", chi2, gl, chi2_p(chi2, gl));
+
+  nr = h->acima + h->abaixo;
+  mu = (nr > 1) ? 2.0 * h->acima * h->abaixo / nr + 1 : 0;
+  var = (nr > 1) ? (mu - 1) * (mu - 2) / (nr - 1) : 0;
+  if (var > 0) {
+    e = (h->corridas - mu) / sqrt(var);
+    z += sprintf(z, ",\"runs\":{\"estatistica\":%.6f,\"gl\":null,\"corridas\":%lld,\"p\":%.6g}",
+      e, (long long) h->corridas, erfc(fabs(e) / sqrt(2)));
+  } else {
+    z += sprintf(z, ",\"runs\":null");
+  }
+
+  /* quantidade de combinações por soma via programação dinâmica */
+  memset(maneiras, 0, sizeof(maneiras));
+  maneiras[0][0] = 1;
+  for (i=1; i <= 60; i++) {
+    for (k=6; k > 0; k--) {
+      for (j=SOMA_MAX; j >= i; j--) maneiras[k][j] += maneiras[k-1][j-i];
+    }
+  }
+  for (j=SOMA_MIN; j <= SOMA_MAX; j++) prob[j] = maneiras[6][j] / total;
+  chi2 = chi2_agrupado(h->somas+SOMA_MIN, prob+SOMA_MIN, SOMA_MAX-SOMA_MIN+1, h->n, &gl);
+  z = json_teste(z, "soma", chi2, gl, chi2_p(chi2, gl));
+
+  /* combinações por decádas ocupadas, escolhendo c números de cada decáda */
+  memset(poker, 0, sizeof(poker));
+  poker[0][0] = 1;
+  for (i=0; i < N_DECADAS; i++) {
+    for (k=6; k >= 0; k--) {
+      for (j=6; j >= 0; j--) {
+        e = poker[k][j];
+        if (e == 0) continue;
+        for (c=1; k + c <= 6 && j < 6; c++) poker[k+c][j+1] += e * binomial(10, c);
+      }
+    }
+  }
+  for (j=1; j <= N_DECADAS; j++) prob[j] = poker[6][j] / total;
+  chi2 = chi2_agrupado(h->poker+1, prob+1, N_DECADAS, h->n, &gl);
+  z = json_teste(z, "poker", chi2, gl, chi2_p(chi2, gl));
+
+  if (h->grupos) {
+    lambda = h->grupos * pow(ANIVERSARIOS, 3) / (4 * total);
+    nr = h->repeticoes;
+    pa = gama_q(nr + 1, lambda);                 /* P(X <= nr) */
+    pb = nr ? 1 - gama_q(nr, lambda) : 1.0;      /* P(X >= nr) */
+    e = 2 * (pa < pb ? pa : pb);
+    z += sprintf(z, ",\"aniversarios\":{\"estatistica\":%lld,\"gl\":null,"
+      "\"grupos\":%lld,\"esperado\":%.6f,\"p\":%.6g}",
+      (long long) nr, (long long) h->grupos, lambda, e < 1 ? e : 1.0);
+  } else {
+    z += sprintf(z, ",\"aniversarios\":null");
+  }
+  sprintf(z, "}");
+  sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+}
+
+#define MAX_CATEGORIAS  1000
+
+typedef struct Categorias {
+  char **rotulos;
+  int n, capacidade;
+}
+Categorias;
+
+typedef struct ContingenciaCtx {
+  Categorias linhas, colunas;
+  i64 *tabela;                        /* linhas.capacidade x colunas.capacidade */
+  i64 n;
+  int erro;
+}
+ContingenciaCtx;
+
+/*
+ * Índice da categoria com o rótulo dado, inserindo-a se inédita, ou -1 se
+ * exceder MAX_CATEGORIAS ou faltar memória.
+*/
+static int categoria(Categorias *c, const char *rotulo, int *nova)
+{
+  char **p;
+  int i;
+
+  *nova = 0;
+  for (i=0; i < c->n; i++) if (strcmp(c->rotulos[i], rotulo) == 0) return i;
+  if (c->n == MAX_CATEGORIAS) return -1;
+  if (c->n == c->capacidade) {
+    p = sqlite3_realloc(c->rotulos, (c->capacidade ? 2*c->capacidade : 8) * sizeof(char *));
+    if (!p) return -1;
+    c->rotulos = p;
+    c->capacidade = c->capacidade ? 2*c->capacidade : 8;
+  }
+  if (!(c->rotulos[c->n] = sqlite3_mprintf("%s", rotulo))) return -1;
+  *nova = 1;
+  return c->n++;
+}
+
+/* realoca a tabela se as capacidades mudaram, preservando as contagens */
+static int redimensiona(ContingenciaCtx *h, int linhas, int colunas)
+{
+  i64 *t;
+  int i;
+
+  if (linhas == h->linhas.capacidade && colunas == h->colunas.capacidade && h->tabela) return 1;
+  t = sqlite3_malloc64(sizeof(i64) * h->linhas.capacidade * h->colunas.capacidade);
+  if (!t) return 0;
+  memset(t, 0, sizeof(i64) * h->linhas.capacidade * h->colunas.capacidade);
+  if (h->tabela) {
+    for (i=0; i < linhas; i++) {
+      memcpy(t + i * h->colunas.capacidade, h->tabela + i * colunas, sizeof(i64) * colunas);
+    }
+    sqlite3_free(h->tabela);
+  }
+  h->tabela = t;
+  return 1;
+}
+
+static void libera_categorias(Categorias *c)
+{
+  int i;
+  for (i=0; i < c->n; i++) sqlite3_free(c->rotulos[i]);
+  sqlite3_free(c->rotulos);
+}
+
+/*
+ * Acumula a tabela de contingência r×c dos pares de valores categóricos,
+ * comparados pela representação textual e ignorando pares com nulos.
+*/
+static void chisq_contingenciaStep(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  ContingenciaCtx *h;
+  const char *a, *b;
+  int i, j, novaLinha, novaColuna, capLinhas, capColunas;
+
+  assert( 2 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0])
+      || SQLITE_NULL == sqlite3_value_type(argv[1]) ) return;
+  h = sqlite3_aggregate_context(context, sizeof(ContingenciaCtx));
+  if (!h) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  if (h->erro) return;
+  a = (const char *) sqlite3_value_text(argv[0]);
+  b = (const char *) sqlite3_value_text(argv[1]);
+  capLinhas = h->linhas.capacidade;
+  capColunas = h->colunas.capacidade;
+  i = a ? categoria(&h->linhas, a, &novaLinha) : -1;
+  j = b && i >= 0 ? categoria(&h->colunas, b, &novaColuna) : -1;
+  if (i < 0 || j < 0 || !redimensiona(h, capLinhas, capColunas)) {
+    h->erro = 1;
+    if (h->linhas.n == MAX_CATEGORIAS || h->colunas.n == MAX_CATEGORIAS) {
+      sqlite3_result_error(context, "quantidade de categorias excede o máximo", -1);
+    } else {
+      sqlite3_result_error_nomem(context);
+    }
+    return;
+  }
+  ++h->tabela[i * h->colunas.capacidade + j];
+  ++h->n;
+}
+
+/*
+ *   chisq_contingencia(linha, coluna) -> '{"n":N,"linhas":R,"colunas":C,
+ *     "estatistica":X,"gl":G,"p":P,"v":V}'
+ *
+ * Teste qui-quadrado de independência de Pearson da tabela de contingência
+ * acumulada, com graus de liberdade (R-1)(C-1) e o V de Cramér.
+*/
+static void chisq_contingenciaFinalize(sqlite3_context *context)
+{
+  ContingenciaCtx *h = sqlite3_aggregate_context(context, 0);
+  char buffer[256];
+  i64 *somaLinhas = 0, *somaColunas = 0, o;
+  double chi2 = 0, e, v;
+  int i, j, r, c, gl, k;
+
+  if (!h) {
+    sqlite3_result_null(context);
+    return;
+  }
+  r = h->linhas.n;
+  c = h->colunas.n;
+  if (!h->erro && h->n > 0) {
+    somaLinhas = sqlite3_malloc64(sizeof(i64) * (r + c));
+    if (!somaLinhas) {
+      sqlite3_result_error_nomem(context);
+    } else {
+      somaColunas = somaLinhas + r;
+      memset(somaLinhas, 0, sizeof(i64) * (r + c));
+      for (i=0; i < r; i++) {
+        for (j=0; j < c; j++) {
+          o = h->tabela[i * h->colunas.capacidade + j];
+          somaLinhas[i] += o;
+          somaColunas[j] += o;
+        }
+      }
+      for (i=0; i < r; i++) {
+        for (j=0; j < c; j++) {
+          o = h->tabela[i * h->colunas.capacidade + j];
+          e = (double) somaLinhas[i] * somaColunas[j] / h->n;
+          chi2 += (o - e) * (o - e) / e;
+        }
+      }
+      gl = (r - 1) * (c - 1);
+      k = (r < c ? r : c) - 1;
+      v = k > 0 ? sqrt(chi2 / (h->n * k)) : 0;
+      sprintf(buffer, "{\"n\":%lld,\"linhas\":%d,\"colunas\":%d,\"estatistica\":%.6f,"
+        "\"gl\":%d,\"p\":%.6g,\"v\":%.6f}",
+        (long long) h->n, r, c, chi2, gl, chi2_p(chi2, gl), v);
+      sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+      sqlite3_free(somaLinhas);
+    }
+  } else if (!h->erro) {
+    sqlite3_result_null(context);
+  }
+  libera_categorias(&h->linhas);
+  libera_categorias(&h->colunas);
+  sqlite3_free(h->tabela);
+}
+
+/*
+ * Estatísticas descritivas numa única passagem: média e variância pelo
+ * algoritmo de Welford e quantis exatos enquanto a quantidade de valores não
+ * excede LIMITE_EXATO, a partir de quando são aproximados por um t-digest.
+ * Como função de janela os valores são mantidos ordenados, sem limite, para
+ * a remoção exata dos que deixam a janela.
+*/
+#define LIMITE_EXATO    65536
+#define COMPRESSAO      100       /* parâmetro de compressão δ do t-digest */
+#define MAX_PENDENTES   (5 * COMPRESSAO)
+#define MAX_CENTROIDES  (10 * COMPRESSAO + MAX_PENDENTES)
+
+typedef struct Centroide {
+  double media, peso;
+}
+Centroide;
+
+typedef struct EstatisticasCtx {
+  i64 n;
+  double media, m2, min, max;
+  double *valores;                /* enquanto não há digest */
+  int nValores, capacidade;
+  int ordenados;                  /* valores em ordem crescente */
+  int janela;                     /* uso como função de janela */
+  Centroide *centroides;          /* t-digest, com os pendentes ao final */
+  int nCentroides, nPendentes;
+}
+EstatisticasCtx;
+
+static const double QUANTIS[] = { 0.01, 0.05, 0.25, 0.50, 0.75, 0.95, 0.99 };
+static const char *NOMES_QUANTIS[] = { "p01", "p05", "p25", "p50", "p75", "p95", "p99" };
+
+static int compara_centroides(const void *a, const void *b)
+{
+  double x = ((const Centroide *) a)->media, y = ((const Centroide *) b)->media;
+  return (x > y) - (x < y);
+}
+
+/* função de escala k1 do t-digest: k(q) = δ/2π × asin(2q - 1) */
+static double escala_k1(double q)
+{
+  if (q > 1) q = 1;
+  return COMPRESSAO / (2 * M_PI) * asin(2 * q - 1);
+}
+
+/*
+ * Incorpora os valores pendentes aos centroides, ordenando-os pela média e
+ * fundindo centroides adjacentes enquanto a variação de k(q) não exceder 1.
+*/
+static void digest_comprime(EstatisticasCtx *h)
+{
+  Centroide *c = h->centroides;
+  int i, j, n = h->nCentroides + h->nPendentes;
+  double total = 0, acumulado = 0, limite;
+
+  if (h->nPendentes == 0) return;
+  qsort(c, n, sizeof(Centroide), compara_centroides);
+  for (i=0; i < n; i++) total += c[i].peso;
+  limite = escala_k1(0) + 1;
+  for (i=1, j=0; i < n; i++) {
+    if (escala_k1((acumulado + c[j].peso + c[i].peso) / total) <= limite) {
+      c[j].media += (c[i].media - c[j].media) * c[i].peso / (c[j].peso + c[i].peso);
+      c[j].peso += c[i].peso;
+    } else {
+      acumulado += c[j].peso;
+      limite = escala_k1(acumulado / total) + 1;
+      c[++j] = c[i];
+    }
+  }
+  h->nCentroides = j + 1;
+  h->nPendentes = 0;
+}
+
+static int digest_adiciona(EstatisticasCtx *h, double x)
+{
+  if (!h->centroides) {
+    h->centroides = sqlite3_malloc64(sizeof(Centroide) * MAX_CENTROIDES);
+    if (!h->centroides) return 0;
+  }
+  h->centroides[h->nCentroides + h->nPendentes].media = x;
+  h->centroides[h->nCentroides + h->nPendentes].peso = 1;
+  if (++h->nPendentes == MAX_PENDENTES) digest_comprime(h);
+  return 1;
+}
+
+/* posição do primeiro valor ordenado não menor que x */
+static int busca_valor(const double *v, int n, double x)
+{
+  int a = 0, b = n;
+  while (a < b) {
+    int m = (a + b) / 2;
+    if (v[m] < x) a = m + 1; else b = m;
+  }
+  return a;
+}
+
+/* valor numérico do argumento, ignorando nulos e textos não numéricos */
+static int estatisticas_valor(sqlite3_value *arg, double *x)
+{
+  switch (sqlite3_value_numeric_type(arg)) {
+    case SQLITE_INTEGER:
+    case SQLITE_FLOAT:
+      *x = sqlite3_value_double(arg);
+      return 1;
+  }
+  return 0;
+}
+
+static void estatisticasStep(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  EstatisticasCtx *h;
+  double x, delta;
+  int i;
+
+  assert( 1 == argc );
+
+  if (!estatisticas_valor(argv[0], &x)) return;
+  h = sqlite3_aggregate_context(context, sizeof(EstatisticasCtx));
+  if (!h) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  if (h->n == 0 || x < h->min) h->min = x;
+  if (h->n == 0 || x > h->max) h->max = x;
+  ++h->n;
+  delta = x - h->media;
+  h->media += delta / h->n;
+  h->m2 += delta * (x - h->media);
+
+  if (h->centroides) {
+    if (!digest_adiciona(h, x)) sqlite3_result_error_nomem(context);
+    return;
+  }
+  if (h->nValores == LIMITE_EXATO && !h->janela) {
+    /* converte os valores em centroides unitários */
+    for (i=0; i < h->nValores; i++) {
+      if (!digest_adiciona(h, h->valores[i])) {
+        sqlite3_result_error_nomem(context);
+        return;
+      }
+    }
+    digest_comprime(h);
+    sqlite3_free(h->valores);
+    h->valores = 0;
+    h->nValores = h->capacidade = 0;
+    if (!digest_adiciona(h, x)) sqlite3_result_error_nomem(context);
+    return;
+  }
+  if (h->nValores == h->capacidade) {
+    int capacidade = h->capacidade ? 2 * h->capacidade : 64;
+    double *v = sqlite3_realloc64(h->valores, sizeof(double) * capacidade);
+    if (!v) {
+      sqlite3_result_error_nomem(context);
+      return;
+    }
+    h->valores = v;
+    h->capacidade = capacidade;
+  }
+  if (h->ordenados) {
+    i = busca_valor(h->valores, h->nValores, x);
+    memmove(h->valores + i + 1, h->valores + i, sizeof(double) * (h->nValores - i));
+    h->valores[i] = x;
+  } else {
+    h->valores[h->nValores] = x;
+  }
+  ++h->nValores;
+}
+
+static int compara_double(const void *a, const void *b)
 {
-  ProductCtx *p;
-  double value = 0;
-  p = sqlite3_aggregate_context(context, 0);
-  value = exp(p->rB);
-  sqlite3_result_double(context, value);
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
 }
 
-#include <limits.h>
-
-#define I64_NBITS (sizeof(i64) * CHAR_BIT)
-
-static char *int2bin(i64 n, char *buf)
+/* ordena os valores uma única vez, inserindo os seguintes já em ordem */
+static void ordena_valores(EstatisticasCtx *h)
 {
-  char *t;
-  for (t = buf+I64_NBITS, *t = '\0'; t != buf; n >>= 1) *(--t) = (n & 1) | '0';
-  return buf;
+  if (h->ordenados) return;
+  qsort(h->valores, h->nValores, sizeof(double), compara_double);
+  h->ordenados = 1;
 }
 
 /*
- * Returns the binary representation string of an integer up to 64 bits.
+ * Remoção do valor que deixa a janela: exata nos valores ordenados e
+ * aproximada no digest, descontando-o do centroide de média mais próxima.
 */
-static void int2binFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+static void estatisticasInverse(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
-  char *buffer;
-  i64 iVal;
-
-  assert( 1 == argc );
+  EstatisticasCtx *h;
+  double x, delta;
+  int i, j;
+
+  if (!estatisticas_valor(argv[0], &x)) return;
+  h = sqlite3_aggregate_context(context, sizeof(EstatisticasCtx));
+  if (!h || h->n == 0) return;
+  if (--h->n == 0) {
+    h->media = h->m2 = 0;
+  } else {
+    delta = x - h->media;
+    h->media -= delta / h->n;
+    h->m2 -= delta * (x - h->media);
+    if (h->m2 < 0) h->m2 = 0;
+  }
 
-  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) ) {
-    iVal = sqlite3_value_int64(argv[0]);
-    buffer = sqlite3_malloc( I64_NBITS+1 );
-    if (!buffer) {
-      sqlite3_result_error_nomem(context);
-    } else {
-      int2bin(iVal, buffer);
-      sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
-      sqlite3_free(buffer);
+  h->janela = 1;
+  if (!h->centroides) {
+    ordena_valores(h);
+    i = busca_valor(h->valores, h->nValores, x);
+    if (i < h->nValores && h->valores[i] == x) {
+      memmove(h->valores + i, h->valores + i + 1, sizeof(double) * (h->nValores - i - 1));
+      --h->nValores;
     }
-  } else {
-    sqlite3_result_error(context, "invalid type", -1);
+    if (h->nValores) {
+      h->min = h->valores[0];
+      h->max = h->valores[h->nValores - 1];
+    }
+    return;
+  }
+  digest_comprime(h);
+  for (i=0, j=1; j < h->nCentroides; j++) {
+    if (fabs(h->centroides[j].media - x) < fabs(h->centroides[i].media - x)) i = j;
+  }
+  if (h->nCentroides && (h->centroides[i].peso -= 1) <= 0) {
+    memmove(h->centroides + i, h->centroides + i + 1,
+      sizeof(Centroide) * (h->nCentroides - i - 1));
+    /* extremos aproximados pelo centroide que passa a ser o extremo */
+    if (i == 0) x = h->min;
+    if (i == --h->nCentroides) x = h->max;
+  }
+  if (h->nCentroides) {
+    if (x <= h->min) h->min = h->centroides[0].media;
+    if (x >= h->max) h->max = h->centroides[h->nCentroides - 1].media;
   }
 }
 
-#define N_DEZENAS 60 /* quantidade de números da Mega-Sena */
-
-/*
- * Monta máscara de incidência dos números da Mega-Sena agrupados via
- * bitwise OR no único argumento de tipo inteiro.
-*/
-static void mask60Func(sqlite3_context *context, int argc, sqlite3_value **argv)
+/* quantil q interpolado entre os centros dos centroides e os extremos */
+static double digest_quantil(const EstatisticasCtx *h, double q)
 {
-  char *buffer;
-  i64 iVal;
+  const Centroide *c = h->centroides;
+  double total = 0, alvo, acumulado = 0, centro, anterior;
   int i;
 
-  assert( 1 == argc );
-
-  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) ) {
-    iVal = sqlite3_value_int64(argv[0]);
-    if (iVal < 0) {
-      sqlite3_result_error(context, "argumento é negativo", -1);
-    } else {
-      buffer = (char *) sqlite3_malloc( N_DEZENAS+1 );
-      if (!buffer) {
-        sqlite3_result_error_nomem(context);
-      } else {
-        for (i=0; i < N_DEZENAS; i++, iVal >>= 1) buffer[i] = (iVal & 1) | '0';
-        buffer[N_DEZENAS] = '\0';
-        sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
-        sqlite3_free(buffer);
+  for (i=0; i < h->nCentroides; i++) total += c[i].peso;
+  alvo = q * total;
+  anterior = 0;
+  for (i=0; i < h->nCentroides; i++) {
+    centro = acumulado + c[i].peso / 2;
+    if (alvo < centro) {
+      if (i == 0) {
+        return h->min + (c[0].media - h->min) * (centro > 0 ? alvo / centro : 0);
       }
+      return c[i-1].media + (c[i].media - c[i-1].media)
+        * (alvo - anterior) / (centro - anterior);
     }
-  } else {
-    sqlite3_result_error(context, "tipo do argumento é invalido", -1);
+    anterior = centro;
+    acumulado += c[i].peso;
   }
+  if (h->nCentroides == 0) return h->max;
+  return c[i-1].media + (h->max - c[i-1].media)
+    * (total > anterior ? (alvo - anterior) / (total - anterior) : 1);
 }
 
-/*
- * Retorna o quadrante do número da Mega-Sena conforme apresentado no boleto.
-*/
-static void quadranteFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+/* quantil q exato com interpolação linear, tal como o tipo 7 do R */
+static double exato_quantil(const EstatisticasCtx *h, double q)
 {
-  int d, q;
+  double p = q * (h->nValores - 1);
+  int i = (int) floor(p);
+  if (i + 1 >= h->nValores) return h->valores[h->nValores - 1];
+  return h->valores[i] + (p - i) * (h->valores[i+1] - h->valores[i]);
+}
 
-  assert( 1 == argc );
+static void estatisticas_resultado(sqlite3_context *context, EstatisticasCtx *h)
+{
+  char buffer[1024], *z = buffer;
+  double variancia;
+  int i;
 
-  if ( SQLITE_INTEGER == sqlite3_value_type(argv[0]) ) {
-    d = sqlite3_value_int(argv[0]);
-    if (d < 1 || d > N_DEZENAS) {
-      sqlite3_result_error(context, "argumento é menor que 1 ou maior que 60", -1);
-      return;
-    }
-    q = ((d-1) / 20 + 1) * 10 + (((d-1) % 10) / 2 + 1);
-    sqlite3_result_int(context, q);
-  } else {
-    sqlite3_result_error(context, "argumento não é do tipo inteiro", -1);
+  if (!h || h->n == 0) {
+    sqlite3_result_null(context);
     return;
   }
+  z += sprintf(z, "{\"n\":%lld,\"media\":%.15g", (long long) h->n, h->media);
+  if (h->n > 1) {
+    variancia = h->m2 / (h->n - 1);
+    z += sprintf(z, ",\"variancia\":%.15g,\"desvio\":%.15g", variancia, sqrt(variancia));
+  } else {
+    z += sprintf(z, ",\"variancia\":null,\"desvio\":null");
+  }
+  z += sprintf(z, ",\"min\":%.15g,\"max\":%.15g,\"exato\":%d,\"quantis\":{",
+    h->min, h->max, h->centroides == 0);
+  if (h->centroides) digest_comprime(h); else ordena_valores(h);
+  for (i=0; i < sizeof(QUANTIS)/sizeof(QUANTIS[0]); i++) {
+    z += sprintf(z, i ? ",\"%s\":%.15g" : "\"%s\":%.15g", NOMES_QUANTIS[i],
+      h->centroides ? digest_quantil(h, QUANTIS[i]) : exato_quantil(h, QUANTIS[i]));
+  }
+  sprintf(z, "}}");
+  sqlite3_result_text(context, buffer, -1, SQLITE_TRANSIENT);
+}
+
+static void estatisticasValue(sqlite3_context *context)
+{
+  EstatisticasCtx *h = sqlite3_aggregate_context(context, 0);
+  if (h) h->janela = 1;
+  estatisticas_resultado(context, h);
+}
+
+/*
+ *   estatisticas(x) -> '{"n":N,"media":M,"variancia":V,"desvio":D,"min":A,
+ *     "max":B,"exato":E,"quantis":{"p01":...,"p50":...,"p99":...}}'
+ *
+ * onde variância e desvio são amostrais e "exato" indica se os quantis são
+ * exatos ou aproximados pelo t-digest. Valores não numéricos são ignorados.
+ * Também é função de janela, com quantis exatos salvo se a moldura inicial
+ * já exceder LIMITE_EXATO valores:
+ *
+ *   SELECT concurso, json_extract(estatisticas(arrecadacao_total) OVER (
+ *     ORDER BY concurso ROWS 103 PRECEDING), '$.quantis.p50') FROM concursos;
+*/
+static void estatisticasFinalize(sqlite3_context *context)
+{
+  EstatisticasCtx *h = sqlite3_aggregate_context(context, 0);
+  estatisticas_resultado(context, h);
+  if (h) {
+    sqlite3_free(h->valores);
+    sqlite3_free(h->centroides);
+  }
 }
 
 /*
@@ -212,7 +1478,8 @@ static void bitstatusFunc(sqlite3_context *context, int argc, sqlite3_value **ar
 }
 
 typedef struct BitCtx {
-  i64 rB;
+  Bitset b;
+  int blob;                 /* resultado como bitset BLOB */
 }
 BitCtx;
 
@@ -224,53 +1491,197 @@ static void group_bitorFinalize(sqlite3_context *context)
   BitCtx *p;
 
   p = sqlite3_aggregate_context(context, sizeof(BitCtx));
-  sqlite3_result_int64(context, p->rB);
+  if (!p) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  resultado_bitset(context, &p->b, p->blob);
 }
 
 /*
  * Acumula o resultado do BITWISE OR entre o valor da estrutura de contexto
  * e o argumento inteiro a cada iteração da função de agregação de valores
- * agrupados.
+ * agrupados, ou bitset BLOB, quando o resultado é também um bitset.
 */
 static void group_bitorStep(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
   BitCtx *p;
-  i64 iVal;
+  Bitset b;
+  int i;
 
   assert( 1 == argc );
 
-  if ( SQLITE_INTEGER == sqlite3_value_numeric_type(argv[0]) ) {
-    iVal = sqlite3_value_int64(argv[0]);
+  if ( SQLITE_BLOB == sqlite3_value_type(argv[0]) ) {
+    if (!le_bitset(context, sqlite3_user_data(context), argv[0], &b)) return;
     p = sqlite3_aggregate_context(context, sizeof(BitCtx));
-    p->rB |= iVal;
+    if (!p) return;
+    for (i=0; i < BITSET_PALAVRAS; i++) p->b.w[i] |= b.w[i];
+    p->blob = 1;
+  } else if ( SQLITE_INTEGER == sqlite3_value_numeric_type(argv[0]) ) {
+    p = sqlite3_aggregate_context(context, sizeof(BitCtx));
+    if (!p) return;
+    p->b.w[0] |= (uint64_t) sqlite3_value_int64(argv[0]);
   } else {
     sqlite3_result_error(context, "error: BITOR argument isn't an integer", -1);
   }
 }
 
 /*
- * BITWISE OR dos índices dos números da Mega-Sena.
+ * BITWISE OR dos índices dos números do jogo, resultando em bitmask inteiro
+ * se o jogo tem até 64 números, senão em bitset.
 */
 static void group_ndxbitorStep(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
   BitCtx *p;
+  char erro[64];
   int iVal;
 
   assert( 1 == argc );
 
   if ( SQLITE_INTEGER == sqlite3_value_numeric_type(argv[0]) ) {
     iVal = sqlite3_value_int(argv[0]);
-    if (iVal > 0 && iVal <= N_DEZENAS) {
+    if (iVal > 0 && iVal <= g->jogo->numeros) {
       p = sqlite3_aggregate_context(context, sizeof(BitCtx));
-      p->rB |= ((i64) 1) << (iVal-1);
+      if (!p) return;
+      p->b.w[(iVal-1) / 64] |= ((uint64_t) 1) << ((iVal-1) % 64);
+      p->blob = g->palavras > 1;
     } else {
-      sqlite3_result_error(context, "argumento é menor que 1 ou maior que 60", -1);
+      snprintf(erro, sizeof(erro), "argumento é menor que 1 ou maior que %d", g->jogo->numeros);
+      sqlite3_result_error(context, erro, -1);
     }
   } else {
     sqlite3_result_error(context, "argumento nao é do tipo inteiro", -1);
   }
 }
 
+/*
+ * bitset(n1, n2, ...) -> bitmask ou bitset dos números do jogo informados,
+ * inteiro se o jogo tem até 64 números tal como GROUP_NDXBITOR.
+*/
+static void bitsetFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  Bitset b;
+  char erro[64];
+  int i, d;
+
+  memset(&b, 0, sizeof(Bitset));
+  for (i=0; i < argc; i++) {
+    if ( SQLITE_NULL == sqlite3_value_type(argv[i]) ) continue;
+    d = sqlite3_value_int(argv[i]);
+    if ( SQLITE_INTEGER != sqlite3_value_numeric_type(argv[i]) || d < 1 || d > g->jogo->numeros ) {
+      snprintf(erro, sizeof(erro), "argumento não é inteiro de 1 a %d", g->jogo->numeros);
+      sqlite3_result_error(context, erro, -1);
+      return;
+    }
+    b.w[(d-1) / 64] |= ((uint64_t) 1) << ((d-1) % 64);
+  }
+  resultado_bitset(context, &b, g->palavras > 1);
+}
+
+/*
+ * bitset_and(a, b) e bitset_or(a, b) -> bitset resultante da operação, do
+ * tipo BLOB se algum dos argumentos é BLOB, senão INTEGER.
+*/
+static void bitset_andorFunc(sqlite3_context *context, int argc, sqlite3_value **argv, int ou)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  Bitset a, b;
+  int i;
+
+  assert( 2 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) || SQLITE_NULL == sqlite3_value_type(argv[1]) ) return;
+  if (!le_bitset(context, g, argv[0], &a) || !le_bitset(context, g, argv[1], &b)) return;
+  for (i=0; i < BITSET_PALAVRAS; i++) a.w[i] = ou ? a.w[i] | b.w[i] : a.w[i] & b.w[i];
+  resultado_bitset(context, &a, SQLITE_BLOB == sqlite3_value_type(argv[0])
+    || SQLITE_BLOB == sqlite3_value_type(argv[1]));
+}
+
+static void bitset_andFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  bitset_andorFunc(context, argc, argv, 0);
+}
+
+static void bitset_orFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  bitset_andorFunc(context, argc, argv, 1);
+}
+
+/*
+ * bitset_count(a) -> quantidade de números no bitset
+ * bitset_common(a, b) -> quantidade de números comuns aos dois bitsets
+ *
+ * via kernels de "popcount" especializados na largura do jogo.
+*/
+static void bitset_countFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  Bitset a;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) ) return;
+  if (le_bitset(context, g, argv[0], &a)) sqlite3_result_int(context, g->conta(&a));
+}
+
+static void bitset_commonFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  Bitset a, b;
+
+  assert( 2 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) || SQLITE_NULL == sqlite3_value_type(argv[1]) ) return;
+  if (le_bitset(context, g, argv[0], &a) && le_bitset(context, g, argv[1], &b)) {
+    sqlite3_result_int(context, g->comuns(&a, &b));
+  }
+}
+
+/*
+ * bitset_has(a, n) -> 1 se o número n está no bitset, senão 0
+*/
+static void bitset_hasFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  Bitset a;
+  int d;
+
+  assert( 2 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) || SQLITE_NULL == sqlite3_value_type(argv[1]) ) return;
+  if (!le_bitset(context, g, argv[0], &a)) return;
+  d = sqlite3_value_int(argv[1]);
+  sqlite3_result_int(context, d >= 1 && d <= g->jogo->numeros
+    && ((a.w[(d-1) / 64] >> ((d-1) % 64)) & 1));
+}
+
+/*
+ * bitset_list(a) -> '[n1,n2,...]' números do bitset em ordem crescente
+*/
+static void bitset_listFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  const Geometria *g = (const Geometria *) sqlite3_user_data(context);
+  char buffer[4 * BITSET_MAX + 3], *z = buffer;
+  uint64_t m;
+  Bitset a;
+  int i;
+
+  assert( 1 == argc );
+
+  if ( SQLITE_NULL == sqlite3_value_type(argv[0]) ) return;
+  if (!le_bitset(context, g, argv[0], &a)) return;
+  *z++ = '[';
+  for (i=0; i < BITSET_PALAVRAS; i++) {
+    for (m=a.w[i]; m; m &= m-1) {
+      z += sprintf(z, z == buffer + 1 ? "%d" : ",%d", 64 * i + __builtin_ctzll(m) + 1);
+    }
+  }
+  *z++ = ']';
+  sqlite3_result_text(context, buffer, z - buffer, SQLITE_TRANSIENT);
+}
+
 /* LMH from sqlite3 3.3.13
  *
  * This table maps from the first byte of a UTF-8 character to the number
@@ -366,7 +1777,7 @@ static int sqlite3ReadUtf8(const unsigned char *z)
 static void reverseFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
   unsigned char *z, *t;
-  char *rz, *r;
+  char buffer[256], *rz, *r;
   int n;
 
   assert( 1 == argc );
@@ -378,7 +1789,7 @@ static void reverseFunc(sqlite3_context *context, int argc, sqlite3_value **argv
   }
   t = z = (unsigned char *) sqlite3_value_text(argv[0]);
   n = strlen((char *) z);
-  r = rz = (char *) sqlite3_malloc(n + 1);
+  r = rz = (n < sizeof(buffer)) ? buffer : (char *) sqlite3_malloc(n + 1);
   if (!rz)
   {
     sqlite3_result_error_nomem(context);
@@ -395,8 +1806,100 @@ static void reverseFunc(sqlite3_context *context, int argc, sqlite3_value **argv
 
   assert(r == rz);
 
-  sqlite3_result_text(context, rz, -1, SQLITE_TRANSIENT);
-  sqlite3_free(rz);
+  /* strings curtas são copiadas do buffer, as demais transferidas */
+  sqlite3_result_text(context, rz, -1, (rz == buffer) ? SQLITE_TRANSIENT : sqlite3_free);
+}
+
+/*
+ * Núcleo de formatação numérica conforme o "locale", com os separadores de
+ * localeconv() copiados na carga da extensão, evitando consultá-lo e analisar
+ * formatos a cada linha, e os dígitos escritos diretamente no buffer.
+*/
+static struct {
+  char decimal[8];          /* separador decimal */
+  char milhar[8];           /* separador de milhares, vazio se inexistente */
+  char agrupamento[8];      /* tamanhos dos grupos tal como "grouping" */
+} separadores = { ".", "", "" };
+
+static void carrega_separadores(void)
+{
+  const struct lconv *lc = localeconv();
+  sqlite3_snprintf(sizeof(separadores.decimal), separadores.decimal, "%s",
+    lc->decimal_point && *lc->decimal_point ? lc->decimal_point : ".");
+  sqlite3_snprintf(sizeof(separadores.milhar), separadores.milhar, "%s",
+    lc->thousands_sep ? lc->thousands_sep : "");
+  sqlite3_snprintf(sizeof(separadores.agrupamento), separadores.agrupamento, "%s",
+    lc->grouping ? lc->grouping : "");
+}
+
+/* comprimento máximo dos números formatados pelas funções a seguir */
+#define FORMATADO_MAX 128
+
+/*
+ * Escreve os dígitos decimais de v, agrupados conforme o "locale" se
+ * "agrupa", retornando o comprimento sem o NUL final.
+*/
+static int formata_inteiro(char *z, unsigned long long v, int agrupa)
+{
+  const char *g = separadores.agrupamento;
+  const int m = strlen(separadores.milhar);
+  char t[FORMATADO_MAX];
+  int n = 0, k = 0, grupo = 0, j;
+
+  if (agrupa && m > 0 && g[0] > 0 && g[0] != CHAR_MAX) grupo = g[0];
+  do {
+    if (grupo > 0 && k == grupo) {
+      // separador invertido, pois os dígitos são escritos da direita
+      for (j = m - 1; j >= 0; --j) t[n++] = separadores.milhar[j];
+      k = 0;
+      if (g[1] != '\0') {
+        ++g;
+        grupo = (*g > 0 && *g != CHAR_MAX) ? *g : 0;
+      }
+    }
+    t[n++] = '0' + v % 10;
+    v /= 10;
+    ++k;
+  } while (v);
+  for (j = 0; j < n; ++j) z[j] = t[n-1-j];
+  z[n] = '\0';
+  return n;
+}
+
+/*
+ * Equivalente a sprintf(z, "%'.*f", casas, valor) para até 4 casas decimais,
+ * inclusive no arredondamento do valor binário exato com empate para o par,
+ * via fma(). Retorna o comprimento ou -1 se o valor, não finito ou de
+ * magnitude maior que 2^52 unidades da última casa, requer sprintf().
+*/
+static int formata_fixo(char *z, double valor, int casas)
+{
+  static const double ESCALAS[] = { 1, 10, 100, 1000, 10000 };
+  static const unsigned POTENCIAS[] = { 1, 10, 100, 1000, 10000 };
+  const double escala = ESCALAS[casas], a = fabs(valor);
+  unsigned long long u;
+  double c, d;
+  char *p = z;
+  int j;
+
+  if (casas < 0 || casas > 4 || !(a * escala < 4503599627370496.0)) return -1;
+  // c é o piso do produto exato, que o produto arredondado pode exceder
+  c = floor(a * escala);
+  if (fma(a, escala, -c) < 0) c -= 1;
+  d = fma(a, escala, -(c + 0.5));
+  u = (unsigned long long) c;
+  if (d > 0 || (d == 0 && (u & 1))) ++u;
+
+  if (signbit(valor)) *p++ = '-';
+  p += formata_inteiro(p, u / POTENCIAS[casas], 1);
+  if (casas > 0) {
+    unsigned f = u % POTENCIAS[casas];
+    for (j = 0; separadores.decimal[j]; ++j) *p++ = separadores.decimal[j];
+    for (j = casas - 1; j >= 0; --j, f /= 10) p[j] = '0' + f % 10;
+    p += casas;
+  }
+  *p = '\0';
+  return p - z;
 }
 
 /*
@@ -405,9 +1908,9 @@ static void reverseFunc(sqlite3_context *context, int argc, sqlite3_value **argv
 */
 static void zeropadFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
-  i64 iVal;
-  int iSize, j;
-  char *z, *format;
+  i64 iVal = 0;
+  int iSize = 0, j, n;
+  char buffer[64], digitos[24], *z;
 
   assert( argc == 2 );
 
@@ -422,11 +1925,11 @@ static void zeropadFunc(sqlite3_context *context, int argc, sqlite3_value **argv
       }
       case SQLITE_NULL: {
         sqlite3_result_null(context);
-        break;
+        return;
       }
       default: {
         sqlite3_result_error(context, "invalid type", -1);
-        break;
+        return;
       }
     }
   }
@@ -434,40 +1937,244 @@ static void zeropadFunc(sqlite3_context *context, int argc, sqlite3_value **argv
     sqlite3_result_error(context, "domain error", -1);
     return;
   }
-  format = sqlite3_mprintf("%%0%dd", iSize);
-  z = sqlite3_mprintf(format, iVal);
-  sqlite3_free(format);
-  sqlite3_result_text(context, z, -1, SQLITE_TRANSIENT);
-  sqlite3_free(z);
+  // dígitos escritos diretamente após os zeros à esquerda
+  n = formata_inteiro(digitos, iVal, 0);
+  if (iSize < n) iSize = n;
+  if (iSize < sizeof(buffer)) {
+    z = buffer;
+  } else if ((z = sqlite3_malloc(iSize + 1)) == NULL) {
+    sqlite3_result_error_nomem(context);
+    return;
+  }
+  memset(z, '0', iSize - n);
+  memcpy(z + iSize - n, digitos, n + 1);
+  sqlite3_result_text(context, z, iSize, (z == buffer) ? SQLITE_TRANSIENT : sqlite3_free);
 }
 
 #if SQLITE_VERSION_NUMBER < 3008003
 
-static char *substr(sqlite3_context *ctx, const char *t, int n) {
-  char *s = sqlite3_malloc(n+1);
-  if (s == NULL) sqlite3_result_error_nomem(ctx);
-  memcpy(s, t, n);
-  s[n] = '\0';
-  return s;
+#define ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/* tipos dos segmentos do formato compilado */
+enum segmentos {
+  SEG_TEXTO = 0,            /* texto literal */
+  SEG_SQLITE,               /* conversão via sqlite3_snprintf */
+  SEG_LIBC,                 /* conversão com separadores via snprintf */
+  SEG_FIXO,                 /* "%'.Nf" via formata_fixo */
+  SEG_AGRUPADO              /* "%'d" via formata_inteiro */
+};
+
+typedef struct segmento_s
+{
+  char tipo;
+  char conversao;           /* caractere da conversão */
+  char casas;               /* casas decimais de SEG_FIXO */
+  int n;                    /* comprimento do texto literal */
+  const char *z;            /* texto literal ou especificação da conversão */
+}
+segmento_t;
+
+/*
+ * Formato compilado uma única vez por statement, mantido como "auxdata" do
+ * primeiro argumento, alocado num único bloco com os segmentos seguidos das
+ * especificações reescritas, onde conversões inteiras usam "ll".
+*/
+typedef struct formato_s
+{
+  int n;
+  segmento_t *segmentos;
+}
+formato_t;
+
+static formato_t *compila_formato(const char *f, char **erro)
+{
+  formato_t *r;
+  segmento_t *s;
+  const char *p;
+  char *pool;
+  int conversoes = 0, apostrofo;
+
+  for (p = f; *p; ++p) if (*p == '%') ++conversoes;
+  // cada conversão gera até dois segmentos e a especificação mais "ll\0"
+  r = sqlite3_malloc(sizeof(formato_t) + (2 * conversoes + 1) * sizeof(segmento_t)
+    + strlen(f) + 3 * conversoes + 1);
+  if (!r) return NULL;
+  r->n = 0;
+  r->segmentos = (segmento_t *) (r + 1);
+  pool = (char *) (r->segmentos + 2 * conversoes + 1);
+
+  for (p = f; *p; ) {
+    s = &r->segmentos[r->n++];
+    memset(s, 0, sizeof(segmento_t));
+    if (*p != '%') {
+      s->tipo = SEG_TEXTO;
+      s->z = p;
+      while (*p && *p != '%') ++p;
+      s->n = p - s->z;
+      continue;
+    }
+    if (p[1] == '%') {
+      s->tipo = SEG_TEXTO;
+      s->z = p;
+      s->n = 1;
+      p += 2;
+      continue;
+    }
+    // flags, largura, precisão e modificadores de tamanho descartados
+    s->z = pool;
+    *pool++ = *p++;
+    for (apostrofo = 0; *p && strchr("-+ 0#'", *p); ++p) {
+      if (*p == '\'') apostrofo = 1;
+      *pool++ = *p;
+    }
+    while (ISDIGIT(*p)) *pool++ = *p++;
+    if (*p == '.') {
+      *pool++ = *p++;
+      while (ISDIGIT(*p)) *pool++ = *p++;
+    }
+    while (*p == 'l' || *p == 'h') ++p;
+    if (*p == '\0' || !strchr("xXdefgsc", *p)) {
+      *pool = '\0';
+      *erro = sqlite3_mprintf("formato inválido: %s%c", s->z, *p);
+      sqlite3_free(r);
+      return NULL;
+    }
+    s->conversao = *p;
+    if (strchr("xXd", *p)) {
+      *pool++ = 'l';
+      *pool++ = 'l';
+    }
+    *pool++ = *p++;
+    *pool++ = '\0';
+    s->tipo = apostrofo ? SEG_LIBC : SEG_SQLITE;
+    // formatos mais usados dispensam a análise da especificação por snprintf
+    if (strcmp(s->z, "%'lld") == 0) {
+      s->tipo = SEG_AGRUPADO;
+    } else if (s->z[1] == '\'' && s->z[2] == '.' && ISDIGIT(s->z[3])
+      && s->z[3] <= '4' && s->z[4] == 'f' && s->z[5] == '\0') {
+      s->tipo = SEG_FIXO;
+      s->casas = s->z[3] - '0';
+    }
+  }
+  return r;
+}
+
+/* buffer da string resultante, na pilha enquanto couber */
+typedef struct saida_s
+{
+  char *z;
+  int n, tamanho;
+  char buffer[256];
 }
+saida_t;
+
+/* garante espaço para mais "n" caracteres além do NUL final */
+static int reserva(saida_t *s, int n)
+{
+  char *z;
+  int tamanho;
 
-static char *append(sqlite3_context *ctx, char *s, char  *t) {
-  if (s == NULL) {
-    s = t;
-  } else if (t != NULL) {
-    s = sqlite3_realloc(s, strlen(s) + strlen(t) + 1);
-    if (s == NULL) sqlite3_result_error_nomem(ctx);
-    strcat(s, t);
-    sqlite3_free(t);
+  if (s->n + n < s->tamanho) return 1;
+  for (tamanho = 2 * s->tamanho; s->n + n >= tamanho; tamanho *= 2) ;
+  if (s->z == s->buffer) {
+    if ((z = sqlite3_malloc(tamanho)) != NULL) memcpy(z, s->buffer, s->n);
+  } else {
+    z = sqlite3_realloc(s->z, tamanho);
   }
-  return s;
+  if (!z) return 0;
+  s->z = z;
+  s->tamanho = tamanho;
+  return 1;
 }
 
-#define ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+/* aplica a conversão ao argumento, escrevendo-o no final da saída */
+static int converte(saida_t *s, const segmento_t *g, sqlite3_value *v)
+{
+  i64 inteiro = 0;
+  double real = 0;
+  const char *texto = NULL;
+  int n, c;
+
+  switch (g->conversao) {
+    case 'x': case 'X': case 'd':
+      inteiro = sqlite3_value_int64(v);
+      break;
+    case 's':
+      texto = (const char *) sqlite3_value_text(v);
+      break;
+    case 'c':
+      if (sqlite3_value_type(v) == SQLITE_INTEGER) {
+        inteiro = sqlite3_value_int(v);
+      } else {
+        inteiro = sqlite3_value_text(v)[0];
+      }
+      break;
+    default:
+      real = sqlite3_value_double(v);
+  }
+
+  if (g->tipo == SEG_AGRUPADO || g->tipo == SEG_FIXO) {
+    if (!reserva(s, FORMATADO_MAX)) return 0;
+    if (g->tipo == SEG_AGRUPADO) {
+      if (inteiro < 0) s->z[s->n++] = '-';
+      n = formata_inteiro(s->z + s->n, inteiro < 0 ? -(unsigned long long) inteiro : inteiro, 1);
+    } else {
+      n = formata_fixo(s->z + s->n, real, g->casas);
+    }
+    if (n >= 0) {
+      s->n += n;
+      return 1;
+    }
+  }
+
+  if (g->tipo == SEG_SQLITE) {
+    // sqlite3_snprintf trunca silenciosamente, então o buffer é ampliado
+    // enquanto o resultado o preencher
+    for (n = 64; ; n *= 2) {
+      if (!reserva(s, n)) return 0;
+      switch (g->conversao) {
+        case 'x': case 'X': case 'd': case 'c':
+          sqlite3_snprintf(n + 1, s->z + s->n, g->z, g->conversao == 'c' ? (int) inteiro : inteiro);
+          break;
+        case 's':
+          sqlite3_snprintf(n + 1, s->z + s->n, g->z, texto);
+          break;
+        default:
+          sqlite3_snprintf(n + 1, s->z + s->n, g->z, real);
+      }
+      c = strlen(s->z + s->n);
+      if (c < n) break;
+    }
+  } else {
+    // formatos com separadores conforme o "locale" via glibc
+    for (n = 64; ; n = c) {
+      if (!reserva(s, n)) return 0;
+      switch (g->conversao) {
+        case 'x': case 'X': case 'd': case 'c':
+          c = snprintf(s->z + s->n, n + 1, g->z, g->conversao == 'c' ? (int) inteiro : inteiro);
+          break;
+        case 's':
+          c = snprintf(s->z + s->n, n + 1, g->z, texto);
+          break;
+        default:
+          c = snprintf(s->z + s->n, n + 1, g->z, real);
+      }
+      if (c < 0) c = 0;
+      if (c <= n) break;
+    }
+  }
+  s->n += c;
+  return 1;
+}
 
 /**
  * "PRINTF" like function via métodos contextuais e glibc.
  *
+ * O formato é compilado uma única vez por statement quando constante, e as
+ * conversões "%'d" e "%'.Nf", N até 4, usam os separadores do "locale" da
+ * carga da extensão sem consultar a glibc. Argumentos NULL ou ausentes
+ * resultam em conversões vazias.
+ *
  * @param String dos formatos combinados.
  * @param Zero ou mais valores do tipo inteiro, real ou string/char.
  *
@@ -475,103 +2182,56 @@ static char *append(sqlite3_context *ctx, char *s, char  *t) {
 */
 static void printfFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
-  const char *q, *p;
-  char *fmt, *z, *r;
-  int j, i;
+  formato_t *f;
+  saida_t s;
+  char *erro = NULL;
+  int j, i, novo = 0;
 
   if (argc == 0) {
     sqlite3_result_error(context, "nenhum argumento a processar.", -1);
     return;
   }
-
-  q = p = (const char *) sqlite3_value_text(argv[0]);   // formatos combinados
-
-  // percorre a string dos formatos combinados que são extraídos
-  // e aplicados a respectivos argumentos
-  for (r=NULL, i=1; i < argc && *p != '\0'; q=p) {
-    // delimita formato a extrair
-    do {
-      ++p;
-    } while (*p != '\0' && *p != '%');
-    // testa se é formato ou prefixo
-    if (*q == '%') {
-      if (p == q+1 && *p == '%') { // caso especial: %%
-        z = substr(context, q, 1);
-        r = append(context, r, z);
-        ++p;
-      } else if (sqlite3_value_type(argv[i]) != SQLITE_NULL) {
-        // extração do formato
-        fmt = substr(context, q, p-q);
-        // tenta identificar formato
-        for (j=1; fmt[j] != '\0' && strchr("xXdefgsc", fmt[j]) == NULL; ++j);
-        // testa se o formato foi identificado
-        if (fmt[j] != '\0') {
-          // aplica formatação de argumento conforme tipo
-          switch (fmt[j]) {
-            case 'x':
-            case 'X':
-            case 'd':
-              z = sqlite3_mprintf(fmt, sqlite3_value_int64(argv[i]));
-              break;
-            case 's':
-              z = sqlite3_mprintf(fmt, sqlite3_value_text(argv[i]));
-              break;
-            case 'c':
-              if (sqlite3_value_type(argv[i]) == SQLITE_INTEGER) {
-                j = sqlite3_value_int(argv[i]);
-              } else {
-                j = sqlite3_value_text(argv[i])[0];
-              }
-              z = sqlite3_mprintf(fmt, j);
-              break;
-            case 'f':
-              if (fmt[1] == 0x27) { // adiciona pontuação conforme "locale"...
-                double valor = sqlite3_value_double(argv[i]);
-                // tenta obter a quantidade mínima de caracteres da string
-                // resultante da formatação, com valor default 29
-                int k = 2;
-                while (fmt[k] != '\0' && fmt[k] != '.' && !ISDIGIT(fmt[k])) ++k;
-                for (j=0; ISDIGIT(fmt[k]); ++k) j = 10 * j + fmt[k] - '0';
-                if (j == 0) j = 29;
-                z = sqlite3_malloc(++j);  // storage a priori
-                if (z == NULL) sqlite3_result_error_nomem(context);
-                k = snprintf(z, j, fmt, valor);
-                if (k >= j) {
-                  z = sqlite3_realloc(z, k+1);  // ajusta o storage
-                  if (z == NULL) sqlite3_result_error_nomem(context);
-                  sprintf(z, fmt, valor);
-                }
-                break;
-              }
-            default:
-              z = sqlite3_mprintf(fmt, sqlite3_value_double(argv[i]));
-          }
-          r = append(context, r, z);  // r <- r + z
-          sqlite3_free(fmt);
-          ++i;
-        } else {
-          z = sqlite3_mprintf("formato inválido: %s\n", fmt);
-          sqlite3_result_error(context, z, -1);
-          sqlite3_free(z);
-          sqlite3_free(fmt);
-          if (r != NULL) sqlite3_free(r);
-          return;
-        }
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+
+  f = (formato_t *) sqlite3_get_auxdata(context, 0);
+  if (f == NULL) {
+    f = compila_formato((const char *) sqlite3_value_text(argv[0]), &erro);
+    if (f == NULL) {
+      if (erro) {
+        sqlite3_result_error(context, erro, -1);
+        sqlite3_free(erro);
+      } else {
+        sqlite3_result_error_nomem(context);
       }
-    } else {
-      z = substr(context, q, p-q);
-      r = append(context, r, z);
+      return;
     }
+    novo = 1;
   }
-  if (*q != '\0') { // aplica formatos restantes sem argumentos
-    fmt = substr(context, q, strlen(q));
-    z = sqlite3_mprintf(fmt);
-    r = append(context, r, z);
-    sqlite3_free(fmt);
+
+  s.z = s.buffer;
+  s.n = 0;
+  s.tamanho = sizeof(s.buffer);
+  for (i = 1, j = 0; j < f->n; ++j) {
+    const segmento_t *g = &f->segmentos[j];
+    if (g->tipo == SEG_TEXTO) {
+      if (!reserva(&s, g->n)) break;
+      memcpy(s.z + s.n, g->z, g->n);
+      s.n += g->n;
+    } else if (i < argc && sqlite3_value_type(argv[i++]) != SQLITE_NULL) {
+      if (!converte(&s, g, argv[i-1])) break;
+    }
+  }
+
+  if (j < f->n) {
+    sqlite3_result_error_nomem(context);
+  } else {
+    s.z[s.n] = '\0';
+    sqlite3_result_text(context, s.z, s.n, (s.z == s.buffer) ? SQLITE_TRANSIENT : sqlite3_free);
   }
+  if (s.z != s.buffer && j < f->n) sqlite3_free(s.z);
 
-  sqlite3_result_text(context, r, -1, SQLITE_TRANSIENT);
-  sqlite3_free(r);
+  // o SQLite pode descartar o formato de imediato, se o argumento variar
+  if (novo) sqlite3_set_auxdata(context, 0, f, sqlite3_free);
 }
 
 #endif
@@ -585,14 +2245,22 @@ static void printfFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
 */
 static void currencyFunc(sqlite3_context *context, int argc, sqlite3_value **argv)
 {
-  char *z;
+  char buffer[FORMATADO_MAX], *z;
+  double value;
+  int n;
   if (sqlite3_value_type(argv[0]) <= SQLITE_FLOAT) { // int or double
-    z = sqlite3_malloc(30);
-    if (z == NULL) sqlite3_result_error_nomem(context);
-    // adiciona pontuação conforme "locale" do sistema
-    sprintf(z, "%'.2f", sqlite3_value_double(argv[0]));
-    sqlite3_result_text(context, z, -1, SQLITE_TRANSIENT);
-    sqlite3_free(z);
+    // adiciona pontuação conforme "locale" da carga da extensão
+    value = sqlite3_value_double(argv[0]);
+    n = formata_fixo(buffer, value, 2);
+    if (n < 0) n = snprintf(buffer, sizeof(buffer), "%'.2f", value);
+    if (n < sizeof(buffer)) {
+      sqlite3_result_text(context, buffer, n, SQLITE_TRANSIENT);
+    } else if ((z = sqlite3_malloc(n + 1)) == NULL) {
+      sqlite3_result_error_nomem(context);
+    } else {
+      snprintf(z, n + 1, "%'.2f", value);
+      sqlite3_result_text(context, z, n, sqlite3_free);
+    }
   } else if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
     sqlite3_result_null(context);
   } else {
@@ -649,8 +2317,8 @@ int RegisterExtensionFunctions(sqlite3 *db)
   static const struct FuncDef {
      char *zName;
      signed char nArg;
-     u8 argType;           /* 0: none.  1: db  2: (-1) */
-     u8 eTextRep;          /* 1: UTF-16.  0: UTF-8 */
+     u8 argType;           /* 0: none.  1: db  2: (-1)  3: geometria do jogo */
+     int eTextRep;         /* 1: UTF-16.  0: UTF-8, mais flags */
      u8 needCollSeq;
      void (*xFunc)(sqlite3_context*,int,sqlite3_value **);
   } aFuncs[] = {
@@ -664,8 +2332,21 @@ int RegisterExtensionFunctions(sqlite3 *db)
     { "int2bin",            1, 0, SQLITE_UTF8,    0, int2binFunc },
     { "bitstatus",          2, 0, SQLITE_UTF8,    0, bitstatusFunc },
 
-    { "mask60",             1, 0, SQLITE_UTF8,    0, mask60Func },
-    { "quadrante",          1, 0, SQLITE_UTF8,    0, quadranteFunc },
+    /* bitsets dos números do jogo */
+    { "mask60",             1, 3, SQLITE_UTF8,    0, mask60Func },
+    { "quadrante",          1, 3, SQLITE_UTF8,    0, quadranteFunc },
+    { "jogo",               0, 3, SQLITE_UTF8,    0, jogoFunc },
+    { "jogo",               1, 3, SQLITE_UTF8|SQLITE_DIRECTONLY, 0, jogoFunc },
+    { "bitset",            -1, 3, SQLITE_UTF8,    0, bitsetFunc },
+    { "bitset_and",         2, 3, SQLITE_UTF8,    0, bitset_andFunc },
+    { "bitset_or",          2, 3, SQLITE_UTF8,    0, bitset_orFunc },
+    { "bitset_count",       1, 3, SQLITE_UTF8,    0, bitset_countFunc },
+    { "bitset_common",      2, 3, SQLITE_UTF8,    0, bitset_commonFunc },
+    { "bitset_has",         2, 3, SQLITE_UTF8,    0, bitset_hasFunc },
+    { "bitset_list",        1, 3, SQLITE_UTF8,    0, bitset_listFunc },
+
+    { "perfil",             1, 0, SQLITE_UTF8|SQLITE_DETERMINISTIC|SQLITE_INNOCUOUS, 0, perfilFunc },
+    { "perfil",             2, 0, SQLITE_UTF8|SQLITE_DETERMINISTIC|SQLITE_INNOCUOUS, 0, perfilFunc },
 
     { "rownum",             1, 0, SQLITE_UTF8,    0, rownumFunc },
 #if SQLITE_VERSION_NUMBER < 3008003
@@ -685,23 +2366,40 @@ int RegisterExtensionFunctions(sqlite3 *db)
     void (*xFinalize)(sqlite3_context*);
   } aAggs[] = {
 
-    { "group_bitor",      1, 0, 0, group_bitorStep, group_bitorFinalize },
-    { "group_ndxbitor",   1, 0, 0, group_ndxbitorStep, group_bitorFinalize },
+    { "group_bitor",      1, 3, 0, group_bitorStep, group_bitorFinalize },
+    { "group_ndxbitor",   1, 3, 0, group_ndxbitorStep, group_bitorFinalize },
     { "product",          1, 0, 0, group_productStep, group_productFinalize },
+    { "histograma_perfil", 1, 0, 0, histograma_perfilStep, histograma_perfilFinalize },
+    { "bateria_aleatoriedade", 1, 0, 0, bateria_aleatoriedadeStep, bateria_aleatoriedadeFinalize },
+    { "chisq_contingencia", 2, 0, 0, chisq_contingenciaStep, chisq_contingenciaFinalize },
 
   };
 
+  Geometria *g;
   int i;
+
+  /* separadores do "locale" vigente, já configurado pelo ponto de entrada
+     ou pela aplicação hospedeira */
+  carrega_separadores();
+
+  /* geometria do jogo exclusiva da conexão */
+  g = (Geometria *) sqlite3_malloc(sizeof(Geometria));
+  if (!g) return SQLITE_NOMEM;
+  memset(g, 0, sizeof(Geometria));
+  carrega_geometria(db, g);
+
   for (i=0; i<sizeof(aFuncs)/sizeof(aFuncs[0]); i++) {
     void *pArg = 0;
     switch ( aFuncs[i].argType ) {
       case 1: pArg = db; break;
       case 2: pArg = (void *)(-1); break;
+      case 3: pArg = g; ++g->refs; break;
     }
     //sqlite3CreateFunc
     /* LMH no error checking */
-    sqlite3_create_function(db, aFuncs[i].zName, aFuncs[i].nArg,
-        aFuncs[i].eTextRep, pArg, aFuncs[i].xFunc, 0, 0);
+    sqlite3_create_function_v2(db, aFuncs[i].zName, aFuncs[i].nArg,
+        aFuncs[i].eTextRep, pArg, aFuncs[i].xFunc, 0, 0,
+        aFuncs[i].argType == 3 ? libera_geometria : 0);
 #if 0
     if ( aFuncs[i].needCollSeq ) {
       struct FuncDef *pFunc = sqlite3FindFunction(db, aFuncs[i].zName,
@@ -718,11 +2416,13 @@ int RegisterExtensionFunctions(sqlite3 *db)
     switch ( aAggs[i].argType ) {
       case 1: pArg = db; break;
       case 2: pArg = (void *)(-1); break;
+      case 3: pArg = g; ++g->refs; break;
     }
     //sqlite3CreateFunc
     /* LMH no error checking */
-    sqlite3_create_function(db, aAggs[i].zName, aAggs[i].nArg, SQLITE_UTF8,
-        pArg, 0, aAggs[i].xStep, aAggs[i].xFinalize);
+    sqlite3_create_function_v2(db, aAggs[i].zName, aAggs[i].nArg, SQLITE_UTF8,
+        pArg, 0, aAggs[i].xStep, aAggs[i].xFinalize,
+        aAggs[i].argType == 3 ? libera_geometria : 0);
 #if 0
     if ( aAggs[i].needCollSeq ) {
       struct FuncDefAgg *pFunc = sqlite3FindFunction( db, aAggs[i].zName,
@@ -733,15 +2433,27 @@ int RegisterExtensionFunctions(sqlite3 *db)
     }
 #endif
   }
-  return 0;
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+  sqlite3_create_window_function(db, "estatisticas", 1, SQLITE_UTF8|SQLITE_INNOCUOUS, 0,
+      estatisticasStep, estatisticasFinalize, estatisticasValue, estatisticasInverse, 0);
+#else
+  sqlite3_create_function(db, "estatisticas", 1, SQLITE_UTF8, 0, 0,
+      estatisticasStep, estatisticasFinalize);
+#endif
+  return ext_stats_inicia(db);
 }
 
-#ifdef COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE
-int sqlite3_extension_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi)
+/*
+ * Entry point named after the library file as expected by sqlite3_load_extension
+ * when no entry point is given, and also usable with sqlite3_auto_extension.
+ * The locale setup is left to the host application when statically linked.
+*/
+int sqlite3_morefunctions_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi)
 {
+#ifdef COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE
   SQLITE_EXTENSION_INIT2(pApi);
-  RegisterExtensionFunctions(db);
   (void) setlocale(LC_ALL, "");
-  return 0;
+#endif
+  return RegisterExtensionFunctions(db);
 }
-#endif /* COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE */
@@ -50,10 +50,14 @@
 #include <sqlite3ext.h>
 SQLITE_EXTENSION_INIT1
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <glib.h>
 
+#define EXT_STATS_EXTENSAO "regexp"
+#include "ext-stats.h"
+
 #ifdef PCRE
 
 #include <pcre.h>
@@ -196,8 +200,7 @@ static void regexp_match(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 
   r = pcre_exec(c->p, c->e, str, strlen(str), 0, 0, ovector, 6);
   if (r >= 0) {
-    *(str + ovector[1]) = '\0';
-    sqlite3_result_text(ctx, str+ovector[0], -1, SQLITE_TRANSIENT);
+    sqlite3_result_text(ctx, str+ovector[0], ovector[1]-ovector[0], SQLITE_TRANSIENT);
   } else {
     switch (r) {
       case PCRE_ERROR_NOMATCH:
@@ -487,7 +490,7 @@ static void regexp_match(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
   regex_t *exp;
   const char *p, *z;
-  char *err, *rz;
+  char *err;
   int v, r;
   regmatch_t matches[MAX_MATCHES];
 
@@ -520,11 +523,7 @@ static void regexp_match(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   r = regexec(exp, z, MAX_MATCHES, matches, 0);
   if (r == 0) {
     v = matches[0].rm_eo - matches[0].rm_so;
-    rz = (char *) sqlite3_malloc(v+1);
-    memcpy(rz, z+matches[0].rm_so, v);
-    *(rz + matches[0].rm_eo) = '\0';
-    sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
-    sqlite3_free(rz);
+    sqlite3_result_text(ctx, z+matches[0].rm_so, v, SQLITE_TRANSIENT);
   }
 }
 
@@ -645,7 +644,8 @@ static void regexp_match_position(sqlite3_context *ctx, int argc, sqlite3_value
 */
 static void regexp_version(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *z = sqlite3_mprintf(
+  char z[64];
+  snprintf(z, sizeof(z),
 #ifdef _PCRE_H
   "PCRE %d.%d", PCRE_MAJOR, PCRE_MINOR
 #else
@@ -653,7 +653,6 @@ static void regexp_version(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 #endif
   );
   sqlite3_result_text(ctx, z, -1, SQLITE_TRANSIENT);
-  sqlite3_free(z);
 }
 
 /**
@@ -672,7 +671,7 @@ static void utf8_upper(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     sqlite3_result_null(ctx);
   } else {
     rz = (char *) g_utf8_strup(str, -1);
-    sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
+    sqlite3_result_text(ctx, rz, -1, g_free);
   }
 }
 
@@ -692,11 +691,11 @@ static void utf8_lower(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     sqlite3_result_null(ctx);
   } else {
     rz = (char *) g_utf8_strdown(str, -1);
-    sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
+    sqlite3_result_text(ctx, rz, -1, g_free);
   }
 }
 
-int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+int sqlite3_regexp_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
 {
   SQLITE_EXTENSION_INIT2(api)
 
@@ -711,5 +710,5 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
   sqlite3_create_function(db, "UTF8_UPPER", 1, SQLITE_UTF8, NULL, utf8_upper, NULL, NULL);
   sqlite3_create_function(db, "UTF8_LOWER", 1, SQLITE_UTF8, NULL, utf8_lower, NULL, NULL);
 
-  return 0;
+  return ext_stats_inicia(db);
 }
@@ -0,0 +1,687 @@
+/*
+ * Leitura direta do documento html da série histórica dos concursos da
+ * Mega-Sena, baixado do website da Caixa Econômica Federal, via "table-valued
+ * functions" no SQLite:
+ *
+ *    RESULTADOS_HTML, GANHADORES_HTML
+ *
+ * O documento é percorrido uma única vez por consulta, em blocos de tamanho
+ * fixo, por um analisador sequencial que extrai as linhas da tabela de nível
+ * mais externo e as células da tabela aninhada das localidades dos ganhadores,
+ * dispensando "xidel", "xsltproc", "sed" e arquivos intermediários:
+ *
+ *    INSERT INTO concursos SELECT * FROM resultados_html('resultados.html');
+ *
+ *    INSERT INTO ganhadores SELECT * FROM ganhadores_html('resultados.html');
+ *
+ * As colunas de RESULTADOS_HTML são as mesmas da tabela "concursos", na mesma
+ * ordem, com datas no formato YYYY-MM-DD, valores monetários como números reais
+ * e o indicador "acumulado" como 0 ou 1. As colunas de GANHADORES_HTML são as
+ * mesmas da tabela "ganhadores", com cidade e UF em maiúsculas ou NULL, uma
+ * linha por localidade dos concursos com ganhadores da sena. Ambas são vedadas
+ * em views e triggers.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc resultados.c -Wall -fPIC -shared -o resultados.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/resultados.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/resultados.so");
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* tamanho dos blocos de bytes lidos do documento */
+#define CHUNK_SIZE 65536
+
+/* quantidade de células das linhas da tabela da série histórica */
+#define N_CELULAS 20
+
+/* tamanho máximo do conteúdo textual preservado de cada célula */
+#define MAX_TEXTO 128
+
+/* célula da tabela aninhada das localidades dos ganhadores */
+#define CELULA_GANHADORES 16
+
+/* tamanho máximo do nome de "tag" considerado */
+#define MAX_TAG 16
+
+typedef struct localidade_s
+{
+  char cidade[MAX_TEXTO];
+  char uf[MAX_TEXTO];
+}
+localidade_t;
+
+/* analisador sequencial do documento */
+typedef struct parser_s
+{
+  FILE *f;
+  unsigned char *buffer;
+  int n, pos;
+  int tabelas;          /* quantidade de tabelas abertas */
+  int celula;           /* número de ordem da célula externa corrente */
+  int em_celula;        /* flag de captura do texto da célula externa */
+  int celula_interna;   /* número de ordem da célula da tabela aninhada */
+  int em_celula_interna;
+  int len_interno;      /* comprimento do texto da célula aninhada corrente */
+  sqlite3_int64 minimo; /* linhas com concurso até este valor são ignoradas */
+  int descarta;         /* flag de linha corrente ignorada */
+  /* conteúdo da linha corrente */
+  char texto[N_CELULAS][MAX_TEXTO];
+  int len[N_CELULAS];
+  localidade_t *localidades;
+  int num_localidades, max_localidades;
+}
+parser_t;
+
+static int le_byte(parser_t *p)
+{
+  if (p->pos == p->n) {
+    p->n = fread(p->buffer, 1, CHUNK_SIZE, p->f);
+    p->pos = 0;
+    if (p->n <= 0) {
+      p->n = 0;
+      return EOF;
+    }
+  }
+  return p->buffer[p->pos++];
+}
+
+static void agrega(char *texto, int *len, int c)
+{
+  if (*len < MAX_TEXTO - 1) {
+    texto[(*len)++] = (char) c;
+    texto[*len] = 0;
+  }
+}
+
+/* destino do texto corrente conforme o contexto do analisador */
+static char *destino(parser_t *p, int **len)
+{
+  if (p->descarta) return NULL;
+  if (p->tabelas == 1 && p->em_celula && p->celula <= N_CELULAS) {
+    *len = &p->len[p->celula-1];
+    return p->texto[p->celula-1];
+  }
+  if (p->tabelas == 2 && p->em_celula_interna && p->num_localidades > 0
+      && p->celula_interna <= 2) {
+    localidade_t *l = &p->localidades[p->num_localidades-1];
+    *len = &p->len_interno;
+    return p->celula_interna == 1 ? l->cidade : l->uf;
+  }
+  return NULL;
+}
+
+/*
+ * Consome a "tag" após o caractere '<', identificando seu nome em minúsculas
+ * e se é de fechamento, descartando atributos e comentários.
+*/
+static int le_tag(parser_t *p, char *nome, int *fechamento)
+{
+  int c, n = 0;
+
+  *fechamento = 0;
+  c = le_byte(p);
+  if (c == '/') {
+    *fechamento = 1;
+    c = le_byte(p);
+  } else if (c == '!') {
+    // comentário ou declaração
+    int h1 = le_byte(p), h2 = (h1 == '-') ? le_byte(p) : 0;
+    if (h1 == '-' && h2 == '-') {
+      int a = 0, b = 0;
+      while ((c = le_byte(p)) != EOF && !(a == '-' && b == '-' && c == '>')) {
+        a = b;
+        b = c;
+      }
+    } else {
+      while (h1 != '>' && (c = le_byte(p)) != EOF && c != '>') ;
+    }
+    nome[0] = 0;
+    return c == EOF ? EOF : 0;
+  }
+  while (c != EOF && isalnum(c)) {
+    if (n < MAX_TAG - 1) nome[n++] = tolower(c);
+    c = le_byte(p);
+  }
+  nome[n] = 0;
+  // descarta atributos, respeitando valores entre aspas
+  while (c != EOF && c != '>') {
+    if (c == '"' || c == '\'') {
+      int q = c;
+      while ((c = le_byte(p)) != EOF && c != q) ;
+    }
+    if (c != EOF) c = le_byte(p);
+  }
+  return c == EOF ? EOF : 0;
+}
+
+/* nomes das referências a caracteres do Latin-1, de U+00A0 a U+00FF */
+static const char *const LATIN1[96] = {
+  "nbsp", "iexcl", "cent", "pound", "curren", "yen", "brvbar", "sect", "uml",
+  "copy", "ordf", "laquo", "not", "shy", "reg", "macr", "deg", "plusmn",
+  "sup2", "sup3", "acute", "micro", "para", "middot", "cedil", "sup1",
+  "ordm", "raquo", "frac14", "frac12", "frac34", "iquest", "Agrave",
+  "Aacute", "Acirc", "Atilde", "Auml", "Aring", "AElig", "Ccedil", "Egrave",
+  "Eacute", "Ecirc", "Euml", "Igrave", "Iacute", "Icirc", "Iuml", "ETH",
+  "Ntilde", "Ograve", "Oacute", "Ocirc", "Otilde", "Ouml", "times", "Oslash",
+  "Ugrave", "Uacute", "Ucirc", "Uuml", "Yacute", "THORN", "szlig", "agrave",
+  "aacute", "acirc", "atilde", "auml", "aring", "aelig", "ccedil", "egrave",
+  "eacute", "ecirc", "euml", "igrave", "iacute", "icirc", "iuml", "eth",
+  "ntilde", "ograve", "oacute", "ocirc", "otilde", "ouml", "divide",
+  "oslash", "ugrave", "uacute", "ucirc", "uuml", "yacute", "thorn", "yuml"
+};
+
+/*
+ * Consome a referência a caractere após '&', retornando seu "code point":
+ * numérica decimal ou hexadecimal, ou nomeada do Latin-1 tal como usadas nos
+ * nomes das cidades, e.g. "S&Atilde;O PAULO". O espaço não separável e as
+ * referências desconhecidas resultam em espaço.
+*/
+static int le_entidade(parser_t *p)
+{
+  char nome[12];
+  int c, n = 0;
+
+  while ((c = le_byte(p)) != EOF && c != ';' && n < 10) nome[n++] = c;
+  nome[n] = 0;
+  if (nome[0] == '#') {
+    char *fim;
+    long v = (nome[1] == 'x' || nome[1] == 'X') ? strtol(nome+2, &fim, 16)
+      : strtol(nome+1, &fim, 10);
+    if (fim == nome+1 || *fim || v < 0x20 || v > 0x10FFFF || v == 0xA0
+        || (v >= 0xD800 && v <= 0xDFFF)) return ' ';
+    return (int) v;
+  }
+  if (strcmp(nome, "amp") == 0) return '&';
+  if (strcmp(nome, "lt") == 0) return '<';
+  if (strcmp(nome, "gt") == 0) return '>';
+  if (strcmp(nome, "quot") == 0) return '"';
+  if (strcmp(nome, "apos") == 0) return '\'';
+  for (n = 1; n < 96; ++n) {
+    if (strcmp(nome, LATIN1[n]) == 0) return 0xA0 + n;
+  }
+  return ' ';
+}
+
+/* agrega o "code point" ao texto codificado em UTF-8, se couber inteiro */
+static void agrega_utf8(char *texto, int *len, int c)
+{
+  unsigned char u[4];
+  int n, j;
+
+  if (c < 0x80) {
+    agrega(texto, len, c);
+    return;
+  }
+  if (c < 0x800) {
+    u[0] = 0xC0 | (c >> 6);
+    n = 2;
+  } else if (c < 0x10000) {
+    u[0] = 0xE0 | (c >> 12);
+    n = 3;
+  } else {
+    u[0] = 0xF0 | (c >> 18);
+    n = 4;
+  }
+  for (j = n - 1; j > 0; --j, c >>= 6) u[j] = 0x80 | (c & 0x3F);
+  if (*len + n > MAX_TEXTO - 1) return;
+  for (j = 0; j < n; ++j) agrega(texto, len, u[j]);
+}
+
+static void nova_localidade(parser_t *p)
+{
+  if (p->num_localidades == p->max_localidades) {
+    int m = p->max_localidades ? p->max_localidades * 2 : 16;
+    localidade_t *l = sqlite3_realloc(p->localidades, m * sizeof(localidade_t));
+    if (!l) return;
+    p->localidades = l;
+    p->max_localidades = m;
+  }
+  memset(&p->localidades[p->num_localidades++], 0, sizeof(localidade_t));
+}
+
+/*
+ * Avança até o final da próxima linha da tabela externa com a quantidade
+ * esperada de células, retornando 1 se há linha disponível ou 0 no final
+ * do documento.
+*/
+static int proxima_linha(parser_t *p)
+{
+  char nome[MAX_TAG];
+  int c, fechamento, *len;
+  char *t;
+
+  for (;;) {
+    c = le_byte(p);
+    if (c == EOF) return 0;
+    if (c == '<') {
+      if (le_tag(p, nome, &fechamento) == EOF) return 0;
+      if (strcmp(nome, "table") == 0) {
+        p->tabelas += fechamento ? -1 : 1;
+        if (p->tabelas < 0) p->tabelas = 0;
+      } else if (strcmp(nome, "tr") == 0) {
+        if (p->tabelas == 1) {
+          if (!fechamento) {
+            memset(p->len, 0, sizeof(p->len));
+            memset(p->texto, 0, sizeof(p->texto));
+            p->celula = 0;
+            p->num_localidades = 0;
+            p->descarta = 0;
+          } else if (p->celula >= N_CELULAS && !p->descarta) {
+            return 1;
+          }
+        } else if (p->tabelas == 2 && p->celula == CELULA_GANHADORES) {
+          if (!fechamento && !p->descarta) {
+            nova_localidade(p);
+            p->celula_interna = 0;
+          }
+        }
+      } else if (strcmp(nome, "td") == 0) {
+        if (p->tabelas == 1) {
+          if (!fechamento) ++p->celula;
+          p->em_celula = !fechamento;
+          // ignora o restante da linha de concurso anterior ao mínimo
+          if (fechamento && p->celula == 1 && p->minimo > 0) {
+            p->descarta = atoll(p->texto[0]) <= p->minimo;
+          }
+        } else if (p->tabelas == 2 && p->celula == CELULA_GANHADORES) {
+          if (!fechamento) ++p->celula_interna;
+          p->em_celula_interna = !fechamento;
+          p->len_interno = 0;
+        }
+      } else if (strcmp(nome, "br") == 0) {
+        if ((t = destino(p, &len))) agrega(t, len, ' ');
+      }
+    } else if ((t = destino(p, &len))) {
+      if (c == '&') {
+        agrega_utf8(t, len, le_entidade(p));
+      } else {
+        agrega(t, len, c);
+      }
+    }
+  }
+}
+
+/* elimina espaços nas extremidades do texto, retornando NULL se vazio */
+static const char *apara(char *t)
+{
+  char *e;
+  while (isspace((unsigned char) *t)) ++t;
+  for (e = t + strlen(t); e > t && isspace((unsigned char) e[-1]); --e) ;
+  *e = 0;
+  return *t ? t : NULL;
+}
+
+/* converte valor monetário no formato "1.234,56" para número real */
+static int valor_monetario(const char *t, double *v)
+{
+  char buf[MAX_TEXTO];
+  int n = 0, digitos = 0;
+  for (; *t; ++t) {
+    if (isdigit((unsigned char) *t)) {
+      buf[n++] = *t;
+      ++digitos;
+    } else if (*t == ',') {
+      buf[n++] = '.';
+    }
+  }
+  buf[n] = 0;
+  if (!digitos) return 0;
+  *v = atof(buf);
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+
+enum colunas_resultados {
+  COL_CONCURSO = 0, COL_DATA_SORTEIO, COL_DEZENA1, COL_GANHADORES_SENA = 8,
+  COL_GANHADORES_QUINA, COL_GANHADORES_QUADRA, COL_RATEIO_SENA, COL_RATEIO_QUINA,
+  COL_RATEIO_QUADRA, COL_ARRECADACAO_TOTAL, COL_ESTIMATIVA_PREMIO,
+  COL_VALOR_ACUMULADO, COL_ACUMULADO, N_COLUNAS_RESULTADOS
+};
+
+enum colunas_ganhadores {
+  COL_G_CONCURSO = 0, COL_G_CIDADE, COL_G_UF, N_COLUNAS_GANHADORES
+};
+
+/* célula de origem de cada coluna de RESULTADOS_HTML, numerada a partir de 1 */
+static const int CELULA[N_COLUNAS_RESULTADOS] = {
+  1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 17, 18, 19, 20
+};
+
+typedef struct tabela_s
+{
+  sqlite3_vtab base;
+  int ganhadores;       /* flag da tabela GANHADORES_HTML */
+  int n_colunas;
+}
+tabela_t;
+
+typedef struct cursor_s
+{
+  sqlite3_vtab_cursor base;
+  parser_t p;
+  sqlite3_int64 rowid;
+  int localidade;       /* índice da localidade corrente em GANHADORES_HTML */
+  int eof;
+}
+cursor_t;
+
+static int xConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int ganhadores = (aux != NULL), rc;
+
+  rc = sqlite3_declare_vtab(db, ganhadores
+    ? "CREATE TABLE x(concurso INTEGER, cidade TEXT, uf TEXT, arquivo HIDDEN)"
+    : "CREATE TABLE x(concurso INTEGER, data_sorteio DATETIME," \
+      " dezena1 INTEGER, dezena2 INTEGER, dezena3 INTEGER, dezena4 INTEGER," \
+      " dezena5 INTEGER, dezena6 INTEGER, ganhadores_sena INTEGER," \
+      " ganhadores_quina INTEGER, ganhadores_quadra INTEGER," \
+      " rateio_sena DOUBLE, rateio_quina DOUBLE, rateio_quadra DOUBLE," \
+      " arrecadacao_total DOUBLE, estimativa_premio DOUBLE," \
+      " valor_acumulado DOUBLE, acumulado BOOL, arquivo HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+  // lê arquivos arbitrários, portanto somente em requisições diretas
+#ifdef SQLITE_VTAB_DIRECTONLY
+  sqlite3_vtab_config(db, SQLITE_VTAB_DIRECTONLY);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->ganhadores = ganhadores;
+  t->n_colunas = ganhadores ? N_COLUNAS_GANHADORES : N_COLUNAS_RESULTADOS;
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int xDisconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+/* códigos de "idxNum" conforme restrição de limite inferior do concurso */
+#define LIMITE_GT 1
+#define LIMITE_GE 2
+
+/*
+ * O nome do arquivo é obrigatório e é o único parâmetro da função, i.e.; a
+ * coluna oculta "arquivo" restrita por igualdade.
+ *
+ * Restrições "concurso > N", "concurso >= N" ou "concurso = N" são repassadas
+ * ao analisador, que deixa de converter e copiar o conteúdo das linhas dos
+ * concursos anteriores, viabilizando a atualização incremental do db apenas
+ * com os concursos mais recentes. A restrição continua a ser avaliada pelo
+ * SQLite, portanto a ordem das linhas no documento é irrelevante.
+*/
+static int xBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  tabela_t *t = (tabela_t *) vtab;
+  int j, arquivo = -1, limite = -1;
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if (c->iColumn == t->n_colunas && c->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      if (!c->usable) return SQLITE_CONSTRAINT;
+      arquivo = j;
+    } else if (c->iColumn == 0 && c->usable && limite < 0) {
+      if (c->op == SQLITE_INDEX_CONSTRAINT_GT) {
+        limite = j;
+        info->idxNum = LIMITE_GT;
+      } else if (c->op == SQLITE_INDEX_CONSTRAINT_GE
+                 || c->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+        limite = j;
+        info->idxNum = LIMITE_GE;
+      }
+    }
+  }
+  if (arquivo < 0) {
+    vtab->zErrMsg = sqlite3_mprintf("nome do arquivo html não informado");
+    return SQLITE_ERROR;
+  }
+  info->aConstraintUsage[arquivo].argvIndex = 1;
+  info->aConstraintUsage[arquivo].omit = 1;
+  info->estimatedCost = 100000;
+  if (limite >= 0) {
+    info->aConstraintUsage[limite].argvIndex = 2;
+    info->estimatedCost = 10000;
+  }
+  return SQLITE_OK;
+}
+
+static int xOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cursor_t *c = sqlite3_malloc(sizeof(cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static void fecha_parser(parser_t *p)
+{
+  if (p->f) fclose(p->f);
+  sqlite3_free(p->buffer);
+  sqlite3_free(p->localidades);
+  memset(p, 0, sizeof(parser_t));
+}
+
+static int xClose(sqlite3_vtab_cursor *cur)
+{
+  fecha_parser(&((cursor_t *) cur)->p);
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+/* avança até a próxima linha de concurso ou localidade de ganhador */
+static int xNext(sqlite3_vtab_cursor *cur)
+{
+  cursor_t *c = (cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+
+  ++c->rowid;
+  if (t->ganhadores) {
+    if (++c->localidade < c->p.num_localidades) return SQLITE_OK;
+    // apenas concursos com ganhadores da sena, cuja tabela de localidades
+    // nos demais contém uma única linha vazia
+    do {
+      if (!proxima_linha(&c->p)) {
+        c->eof = 1;
+        return SQLITE_OK;
+      }
+    } while (c->p.num_localidades == 0
+             || atoll(c->p.texto[CELULA[COL_GANHADORES_SENA]-1]) <= 0);
+    c->localidade = 0;
+  } else {
+    c->eof = !proxima_linha(&c->p);
+  }
+  return SQLITE_OK;
+}
+
+static int xFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  cursor_t *c = (cursor_t *) cur;
+  const char *arquivo = (const char *) sqlite3_value_text(argv[0]);
+
+  fecha_parser(&c->p);
+  if (!arquivo || !(c->p.f = fopen(arquivo, "rb"))) {
+    sqlite3_free(cur->pVtab->zErrMsg);
+    cur->pVtab->zErrMsg = sqlite3_mprintf("arquivo inacessível: %s",
+      arquivo ? arquivo : "NULL");
+    return SQLITE_ERROR;
+  }
+  c->p.buffer = sqlite3_malloc(CHUNK_SIZE);
+  if (!c->p.buffer) return SQLITE_NOMEM;
+  if (argc > 1 && sqlite3_value_type(argv[1]) != SQLITE_NULL) {
+    c->p.minimo = sqlite3_value_int64(argv[1]) - (idxNum == LIMITE_GE);
+  }
+  c->rowid = 0;
+  c->localidade = -1;
+  c->eof = 0;
+  return xNext(cur);
+}
+
+static int xEof(sqlite3_vtab_cursor *cur)
+{
+  return ((cursor_t *) cur)->eof;
+}
+
+static void resultado_inteiro(sqlite3_context *ctx, char *texto)
+{
+  const char *t = apara(texto);
+  if (t) {
+    sqlite3_result_int64(ctx, atoll(t));
+  } else {
+    sqlite3_result_null(ctx);
+  }
+}
+
+static void resultado_maiusculas(sqlite3_context *ctx, char *texto)
+{
+  const char *t = apara(texto);
+  char *z;
+  int j;
+
+  if (!t) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  z = sqlite3_mprintf("%s", t);
+  if (!z) {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  // tal como upper-case() do XPath nos caracteres ASCII e nas minúsculas
+  // acentuadas do Latin-1, de U+00E0 a U+00FE exceto U+00F7, que em UTF-8
+  // têm o mesmo primeiro byte das maiúsculas e segundo byte 0x20 menor
+  for (j = 0; z[j]; ++j) {
+    const unsigned char u = z[j];
+    if (u < 0x80) {
+      z[j] = toupper(u);
+    } else if (u == 0xC3 && (unsigned char) z[j+1] >= 0xA0
+               && (unsigned char) z[j+1] <= 0xBE && (unsigned char) z[j+1] != 0xB7) {
+      z[++j] -= 0x20;
+    }
+  }
+  sqlite3_result_text(ctx, z, j, sqlite3_free);
+}
+
+static int xColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cursor_t *c = (cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  char *texto;
+  double v;
+
+  if (t->ganhadores) {
+    localidade_t *l = &c->p.localidades[c->localidade];
+    switch (col) {
+      case COL_G_CONCURSO:
+        resultado_inteiro(ctx, c->p.texto[0]);
+        break;
+      case COL_G_CIDADE:
+        resultado_maiusculas(ctx, l->cidade);
+        break;
+      case COL_G_UF:
+        resultado_maiusculas(ctx, l->uf);
+        break;
+    }
+    return SQLITE_OK;
+  }
+
+  if (col >= N_COLUNAS_RESULTADOS) return SQLITE_OK;
+  texto = c->p.texto[CELULA[col]-1];
+  switch (col) {
+    case COL_DATA_SORTEIO: {
+      // DD/MM/YYYY -> YYYY-MM-DD
+      const char *d = apara(texto);
+      if (d && strlen(d) == 10) {
+        char z[11];
+        memcpy(z, d+6, 4);
+        z[4] = '-';
+        memcpy(z+5, d+3, 2);
+        z[7] = '-';
+        memcpy(z+8, d, 2);
+        sqlite3_result_text(ctx, z, 10, SQLITE_TRANSIENT);
+      } else {
+        sqlite3_result_null(ctx);
+      }
+      break;
+    }
+    case COL_RATEIO_SENA:
+    case COL_RATEIO_QUINA:
+    case COL_RATEIO_QUADRA:
+    case COL_ARRECADACAO_TOTAL:
+    case COL_ESTIMATIVA_PREMIO:
+    case COL_VALOR_ACUMULADO:
+      if (valor_monetario(texto, &v)) {
+        sqlite3_result_double(ctx, v);
+      } else {
+        sqlite3_result_null(ctx);
+      }
+      break;
+    case COL_ACUMULADO: {
+      const char *a = apara(texto);
+      sqlite3_result_int(ctx, a && sqlite3_stricmp(a, "SIM") == 0);
+      break;
+    }
+    default:
+      resultado_inteiro(ctx, texto);
+  }
+  return SQLITE_OK;
+}
+
+static int xRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((cursor_t *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  xConnect,
+  xBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  xOpen,
+  xClose,
+  xFilter,
+  xNext,
+  xEof,
+  xColumn,
+  xRowid,
+};
+
+int sqlite3_resultados_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  int rc;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  rc = sqlite3_create_module(db, "resultados_html", &modulo, NULL);
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_module(db, "ganhadores_html", &modulo, (void *) &modulo);
+  }
+  return rc;
+}
@@ -0,0 +1,959 @@
+/*
+ * Análise das séries temporais de incidência de cada número, i.e.; a série
+ * 0/1 indicando se o número foi sorteado em cada concurso na ordem dos
+ * concursos, tal como produzida em "sql/series_dezenas.sql":
+ *
+ *    AUTOCORRELACAO (lag, coincidencias, autocorrelacao, limite,
+ *                    dezena HIDDEN, max_lag HIDDEN)
+ *
+ *    PERIODOGRAMA (k, frequencia, periodo, intensidade, dezena HIDDEN)
+ *
+ *    SEQUENCIAS (inicio, fim, comprimento, aberta,
+ *                fonte HIDDEN, ordem HIDDEN, flag HIDDEN)
+ *
+ *    HISTOGRAMA_SEQUENCIAS (flag)
+ *
+ * AUTOCORRELACAO é a função de autocorrelação amostral da série do número
+ * "dezena" nos lags de 1 a "max_lag", por padrão 10×log10(N) tal como a
+ * função "acf" do R, onde N é a quantidade de concursos, "coincidencias" é a
+ * quantidade de concursos em que o número foi sorteado também "lag" concursos
+ * depois e "limite" é a meia largura do intervalo de 95% de confiança da
+ * autocorrelação de um ruído branco, 1.96/sqrt(N):
+ *
+ *    SELECT lag, autocorrelacao FROM autocorrelacao(10, 50)
+ *      WHERE abs(autocorrelacao) > limite;
+ *
+ * PERIODOGRAMA é o periodograma da série centrada do número "dezena" nas
+ * frequências de Fourier k/N, com k de 1 a N/2, i.e.; |X_k|²/N onde X é a
+ * transformada discreta de Fourier, e "periodo" é N/k em concursos:
+ *
+ *    SELECT periodo, intensidade FROM periodograma(10)
+ *      ORDER BY intensidade DESC LIMIT 5;
+ *
+ * Sem restrição de igualdade sobre "dezena" são analisadas as séries dos 60
+ * números numa única leitura de "dezenas_juntadas", na ordem dos números:
+ *
+ *    SELECT dezena, lag, autocorrelacao FROM autocorrelacao WHERE max_lag = 5;
+ *
+ * As séries são compactadas em bitsets de 64 concursos por palavra, de modo
+ * que cada produto defasado da autocorrelação é a contagem via "popcount" do
+ * AND da série com sua cópia deslocada, e o periodograma usa FFT radix-2 com
+ * o algoritmo de Bluestein para as frequências exatas de qualquer N.
+ *
+ * SEQUENCIAS percorre uma única vez a tabela, visão ou consulta "fonte" na
+ * ordem da expressão "ordem", emitindo cada sequência maximal de linhas com a
+ * expressão "flag" verdadeira com os valores de "ordem" na primeira e última
+ * linhas, seu comprimento e se está "aberta", i.e.; em curso na última linha:
+ *
+ *    SELECT inicio, comprimento FROM sequencias('concursos', 'concurso',
+ *      'acumulado');
+ *
+ * HISTOGRAMA_SEQUENCIAS é a agregação equivalente sobre as linhas na ordem
+ * em que são agregadas, resultando no histograma dos comprimentos das
+ * sequências encerradas e no comprimento da sequência aberta. A ordem deve
+ * ser explícita na agregação, disponível a partir da versão 3.44 do SQLite,
+ * pois a ordem de subconsultas não é garantida à agregação externa:
+ *
+ *    SELECT histograma_sequencias(acumulado ORDER BY concurso) FROM concursos;
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc series.c -Wall -fPIC -shared -lm -o series.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/series.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/series.so");
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+/* quantidade de números da Mega-Sena */
+#define N_DEZENAS 60
+
+/* "popcount" nativo nos produtos defasados sem exigir flags de compilação */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POPCNT __attribute__((target("popcnt")))
+#else
+#define POPCNT
+#endif
+
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+
+enum colunas_autocorrelacao {
+  COL_A_LAG = 0, COL_A_COINCIDENCIAS, COL_A_AUTOCORRELACAO, COL_A_LIMITE,
+  COL_A_DEZENA, COL_A_MAX_LAG
+};
+
+enum colunas_periodograma {
+  COL_P_K = 0, COL_P_FREQUENCIA, COL_P_PERIODO, COL_P_INTENSIDADE, COL_P_DEZENA
+};
+
+/* coluna "dezena" comum às duas tabelas */
+#define COL_DEZENA COL_A_DEZENA
+
+/* bits de "idxNum" indicando os argumentos repassados a xFilter */
+#define ARG_DEZENA  1
+#define ARG_MAX_LAG 2
+
+typedef struct tabela_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+  char *schema;
+  int periodograma;         /* flag da tabela do periodograma */
+}
+tabela_t;
+
+/* linha do resultado de qualquer das tabelas */
+typedef struct linha_s
+{
+  int dezena, k;
+  sqlite3_int64 contagem;
+  double valor;
+}
+linha_t;
+
+typedef struct cursor_s
+{
+  sqlite3_vtab_cursor base;
+  linha_t *linhas;
+  int n;                    /* quantidade de linhas */
+  int j;                    /* linha corrente */
+  int concursos;            /* tamanho das séries */
+  int max_lag;
+}
+cursor_t;
+
+/* séries dos 60 números compactadas em bitsets de "palavras" palavras */
+typedef struct series_s
+{
+  uint64_t *bits;
+  int n, palavras;
+  int frequencias[N_DEZENAS];
+}
+series_t;
+
+static int xConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  const int periodograma = aux != NULL;
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, periodograma
+    ? "CREATE TABLE x(k INTEGER, frequencia REAL, periodo REAL," \
+      " intensidade REAL, dezena HIDDEN)"
+    : "CREATE TABLE x(lag INTEGER, coincidencias INTEGER, autocorrelacao REAL," \
+      " limite REAL, dezena HIDDEN, max_lag HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+#ifdef SQLITE_VTAB_INNOCUOUS
+  sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->db = db;
+  t->periodograma = periodograma;
+  t->schema = sqlite3_mprintf("%s", argv[1]);
+  if (!t->schema) {
+    sqlite3_free(t);
+    return SQLITE_NOMEM;
+  }
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+static int xDisconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(((tabela_t *) vtab)->schema);
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+static int xBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  tabela_t *t = (tabela_t *) vtab;
+  int j, dezena = -1, max_lag = -1, argv = 0;
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if (c->op != SQLITE_INDEX_CONSTRAINT_EQ) continue;
+    if (c->iColumn == COL_DEZENA && c->usable) {
+      dezena = j;
+    } else if (!t->periodograma && c->iColumn == COL_A_MAX_LAG) {
+      if (!c->usable) return SQLITE_CONSTRAINT;
+      max_lag = j;
+    }
+  }
+  info->idxNum = 0;
+  if (dezena >= 0) {
+    info->aConstraintUsage[dezena].argvIndex = ++argv;
+    info->aConstraintUsage[dezena].omit = 1;
+    info->idxNum |= ARG_DEZENA;
+  }
+  if (max_lag >= 0) {
+    info->aConstraintUsage[max_lag].argvIndex = ++argv;
+    info->aConstraintUsage[max_lag].omit = 1;
+    info->idxNum |= ARG_MAX_LAG;
+  }
+  // linhas na ordem da dezena e do lag ou frequência
+  {
+    static const int ORDEM[] = { COL_DEZENA, 0 };
+    const int *ordem = (dezena >= 0) ? ORDEM + 1 : ORDEM;
+    const int n = (dezena >= 0) ? 1 : 2;
+    for (j = 0; j < info->nOrderBy && j < n; ++j) {
+      if (info->aOrderBy[j].iColumn != ordem[j] || info->aOrderBy[j].desc) break;
+    }
+    if (info->nOrderBy > 0 && j == info->nOrderBy) info->orderByConsumed = 1;
+  }
+  info->estimatedRows = (dezena >= 0) ? 1000 : 60000;
+  info->estimatedCost = info->estimatedRows;
+  return SQLITE_OK;
+}
+
+static int xOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cursor_t *c = sqlite3_malloc(sizeof(cursor_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cursor_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int xClose(sqlite3_vtab_cursor *cur)
+{
+  cursor_t *c = (cursor_t *) cur;
+  sqlite3_free(c->linhas);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/* leitura de "dezenas_juntadas" transpondo os bitmasks em séries */
+static int carrega_series(tabela_t *t, series_t *s)
+{
+  sqlite3_stmt *stmt;
+  uint64_t *mascaras = NULL;
+  char *sql;
+  int rc, capacidade = 0, i;
+
+  memset(s, 0, sizeof(series_t));
+  sql = sqlite3_mprintf("SELECT dezenas FROM \"%w\".dezenas_juntadas ORDER BY concurso",
+    t->schema);
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) return rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    if (s->n == capacidade) {
+      uint64_t *p;
+      capacidade = capacidade ? 2 * capacidade : 4096;
+      p = sqlite3_realloc64(mascaras, capacidade * sizeof(uint64_t));
+      if (!p) {
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      mascaras = p;
+    }
+    mascaras[s->n++] = (uint64_t) sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    sqlite3_free(mascaras);
+    return rc;
+  }
+
+  s->palavras = (s->n + 63) / 64;
+  s->bits = sqlite3_malloc64((sqlite3_int64) N_DEZENAS * (s->palavras + 1) * sizeof(uint64_t));
+  if (!s->bits) {
+    sqlite3_free(mascaras);
+    return SQLITE_NOMEM;
+  }
+  memset(s->bits, 0, (sqlite3_int64) N_DEZENAS * (s->palavras + 1) * sizeof(uint64_t));
+  for (i = 0; i < s->n; ++i) {
+    uint64_t m;
+    for (m = mascaras[i] & ((1ULL << N_DEZENAS) - 1); m; m &= m - 1) {
+      const int d = __builtin_ctzll(m);
+      s->bits[d * (s->palavras + 1) + i / 64] |= 1ULL << (i % 64);
+      ++s->frequencias[d];
+    }
+  }
+  sqlite3_free(mascaras);
+  return SQLITE_OK;
+}
+
+/* série do número d, com uma palavra nula de sentinela ao final */
+#define SERIE(s, d) ((s)->bits + (d) * ((s)->palavras + 1))
+
+/* quantidade de posições i tais que x_i = x_{i+lag} = 1 */
+static POPCNT int coincidencias(const uint64_t *x, int palavras, int lag)
+{
+  const int q = lag / 64, r = lag % 64;
+  int w, total = 0;
+  for (w = 0; w + q < palavras; ++w) {
+    const uint64_t deslocada = r
+      ? (x[w + q] >> r) | (x[w + q + 1] << (64 - r))
+      : x[w + q];
+    total += __builtin_popcountll(x[w] & deslocada);
+  }
+  return total;
+}
+
+/*
+ * Autocorrelação amostral r(L) = c(L)/c(0), com a autocovariância
+ *
+ *    c(L) = 1/N × Σ_{i<N-L} (x_i - m)(x_{i+L} - m)
+ *         = 1/N × [P(L) - m × (A + B) + (N-L) × m²]
+ *
+ * onde P(L) é a contagem de coincidências, A e B as somas de x_i nos
+ * trechos i < N-L e i >= L e m a média da série.
+*/
+static void autocorrelacoes(const series_t *s, int d, int max_lag, linha_t *linhas)
+{
+  const uint64_t *x = SERIE(s, d);
+  const int n = s->n, f = s->frequencias[d];
+  const double m = (double) f / n, c0 = m - m * m;
+  int lag, inicio = 0, fim = 0;
+
+  for (lag = 1; lag <= max_lag; ++lag) {
+    const int p = coincidencias(x, s->palavras, lag);
+    double c;
+    // sorteios nos primeiros e nos últimos "lag" concursos
+    inicio += (x[(lag - 1) / 64] >> ((lag - 1) % 64)) & 1;
+    fim += (x[(n - lag) / 64] >> ((n - lag) % 64)) & 1;
+    c = (p - m * ((f - fim) + (f - inicio)) + (n - lag) * m * m) / n;
+    linhas[lag - 1].dezena = d + 1;
+    linhas[lag - 1].k = lag;
+    linhas[lag - 1].contagem = p;
+    linhas[lag - 1].valor = c0 > 0 ? c / c0 : NAN;
+  }
+}
+
+/* FFT radix-2 iterativa "in place" de tamanho potência de 2 */
+static void fft(double *re, double *im, int n, int inversa)
+{
+  int i, j, k, tamanho;
+
+  for (i = 1, j = 0; i < n; ++i) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      double t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+  for (tamanho = 2; tamanho <= n; tamanho <<= 1) {
+    const double angulo = (inversa ? 2 : -2) * M_PI / tamanho;
+    const double wr = cos(angulo), wi = sin(angulo);
+    for (i = 0; i < n; i += tamanho) {
+      double cr = 1, ci = 0;
+      for (k = 0; k < tamanho / 2; ++k) {
+        const int a = i + k, b = a + tamanho / 2;
+        const double tr = re[b] * cr - im[b] * ci, ti = re[b] * ci + im[b] * cr;
+        const double t = cr * wr - ci * wi;
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+        ci = cr * wi + ci * wr;
+        cr = t;
+      }
+    }
+  }
+  if (inversa) {
+    for (i = 0; i < n; ++i) {
+      re[i] /= n;
+      im[i] /= n;
+    }
+  }
+}
+
+/*
+ * Estado do algoritmo de Bluestein para DFT de tamanho N qualquer via FFTs de
+ * tamanho M >= 2N-1: X_k = w_k × Σ_n (x_n w_n) conj(w_{k-n}), w_n = e^(-iπn²/N),
+ * com a transformada do "chirp" conj(w) calculada uma única vez.
+*/
+typedef struct bluestein_s
+{
+  int n, m;
+  double *wr, *wi;          /* w_n para n < N */
+  double *br, *bi;          /* FFT do "chirp" */
+  double *ar, *ai;          /* área de trabalho */
+}
+bluestein_t;
+
+static int prepara_bluestein(bluestein_t *b, int n)
+{
+  int j;
+
+  memset(b, 0, sizeof(bluestein_t));
+  b->n = n;
+  for (b->m = 1; b->m < 2 * n - 1; b->m <<= 1) ;
+  b->wr = sqlite3_malloc64((2 * (sqlite3_int64) n + 4 * (sqlite3_int64) b->m) * sizeof(double));
+  if (!b->wr) return SQLITE_NOMEM;
+  b->wi = b->wr + n;
+  b->br = b->wi + n;
+  b->bi = b->br + b->m;
+  b->ar = b->bi + b->m;
+  b->ai = b->ar + b->m;
+  memset(b->br, 0, 2 * b->m * sizeof(double));
+  for (j = 0; j < n; ++j) {
+    // n² mod 2N preserva a precisão do ângulo para N grande
+    const double angulo = M_PI * (double) (((sqlite3_int64) j * j) % (2 * n)) / n;
+    b->wr[j] = cos(angulo);
+    b->wi[j] = -sin(angulo);
+    b->br[j] = b->wr[j];
+    b->bi[j] = -b->wi[j];
+    if (j > 0) {
+      b->br[b->m - j] = b->wr[j];
+      b->bi[b->m - j] = -b->wi[j];
+    }
+  }
+  fft(b->br, b->bi, b->m, 0);
+  return SQLITE_OK;
+}
+
+/* periodograma |X_k|²/N da série centrada para k de 1 a N/2 */
+static void periodograma(bluestein_t *b, const series_t *s, int d, linha_t *linhas)
+{
+  const uint64_t *x = SERIE(s, d);
+  const int n = s->n;
+  const double m = (double) s->frequencias[d] / n;
+  int j;
+
+  memset(b->ar, 0, 2 * b->m * sizeof(double));
+  for (j = 0; j < n; ++j) {
+    const double v = ((x[j / 64] >> (j % 64)) & 1) - m;
+    b->ar[j] = v * b->wr[j];
+    b->ai[j] = v * b->wi[j];
+  }
+  fft(b->ar, b->ai, b->m, 0);
+  for (j = 0; j < b->m; ++j) {
+    const double r = b->ar[j] * b->br[j] - b->ai[j] * b->bi[j];
+    b->ai[j] = b->ar[j] * b->bi[j] + b->ai[j] * b->br[j];
+    b->ar[j] = r;
+  }
+  fft(b->ar, b->ai, b->m, 1);
+  for (j = 1; j <= n / 2; ++j) {
+    const double xr = b->ar[j] * b->wr[j] - b->ai[j] * b->wi[j];
+    const double xi = b->ar[j] * b->wi[j] + b->ai[j] * b->wr[j];
+    linhas[j - 1].dezena = d + 1;
+    linhas[j - 1].k = j;
+    linhas[j - 1].valor = (xr * xr + xi * xi) / n;
+  }
+}
+
+static int xFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  cursor_t *c = (cursor_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  int primeira = 0, ultima = N_DEZENAS - 1, arg = 0, por_dezena, d, rc;
+  sqlite3_int64 max_lag = -1;
+  bluestein_t b;
+  series_t s;
+
+  sqlite3_free(c->linhas);
+  c->linhas = NULL;
+  c->n = c->j = 0;
+
+  if (idxNum & ARG_DEZENA) {
+    const sqlite3_int64 v = sqlite3_value_int64(argv[arg]);
+    // dezena inexistente resulta em nenhuma linha
+    if (sqlite3_value_numeric_type(argv[arg++]) != SQLITE_INTEGER || v < 1 || v > N_DEZENAS) {
+      return SQLITE_OK;
+    }
+    primeira = ultima = (int) v - 1;
+  }
+  if (idxNum & ARG_MAX_LAG) {
+    if (sqlite3_value_numeric_type(argv[arg]) != SQLITE_INTEGER
+        || (max_lag = sqlite3_value_int64(argv[arg])) < 1) {
+      sqlite3_free(t->base.zErrMsg);
+      t->base.zErrMsg = sqlite3_mprintf("max_lag deve ser inteiro positivo");
+      return SQLITE_ERROR;
+    }
+  }
+
+  rc = carrega_series(t, &s);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+  c->concursos = s.n;
+  if (s.n < 2) {
+    sqlite3_free(s.bits);
+    return SQLITE_OK;
+  }
+
+  if (t->periodograma) {
+    por_dezena = s.n / 2;
+    rc = prepara_bluestein(&b, s.n);
+  } else {
+    if (max_lag < 0) max_lag = (sqlite3_int64) floor(10 * log10(s.n));
+    if (max_lag > s.n - 1) max_lag = s.n - 1;
+    por_dezena = c->max_lag = (int) max_lag;
+  }
+  c->linhas = sqlite3_malloc64((sqlite3_int64) (ultima - primeira + 1) * por_dezena * sizeof(linha_t));
+  if (rc != SQLITE_OK || !c->linhas) {
+    if (t->periodograma) sqlite3_free(b.wr);
+    sqlite3_free(s.bits);
+    return SQLITE_NOMEM;
+  }
+  for (d = primeira; d <= ultima; ++d, c->n += por_dezena) {
+    if (t->periodograma) {
+      periodograma(&b, &s, d, c->linhas + c->n);
+    } else {
+      autocorrelacoes(&s, d, c->max_lag, c->linhas + c->n);
+    }
+  }
+  if (t->periodograma) sqlite3_free(b.wr);
+  sqlite3_free(s.bits);
+  return SQLITE_OK;
+}
+
+static int xNext(sqlite3_vtab_cursor *cur)
+{
+  ++((cursor_t *) cur)->j;
+  return SQLITE_OK;
+}
+
+static int xEof(sqlite3_vtab_cursor *cur)
+{
+  cursor_t *c = (cursor_t *) cur;
+  return c->j >= c->n;
+}
+
+static int autocorrelacaoColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cursor_t *c = (cursor_t *) cur;
+  const linha_t *l = &c->linhas[c->j];
+
+  switch (col) {
+    case COL_A_DEZENA:
+      sqlite3_result_int(ctx, l->dezena);
+      break;
+    case COL_A_LAG:
+      sqlite3_result_int(ctx, l->k);
+      break;
+    case COL_A_COINCIDENCIAS:
+      sqlite3_result_int64(ctx, l->contagem);
+      break;
+    case COL_A_AUTOCORRELACAO:
+      if (!isnan(l->valor)) sqlite3_result_double(ctx, l->valor);
+      break;
+    case COL_A_LIMITE:
+      sqlite3_result_double(ctx, 1.96 / sqrt(c->concursos));
+      break;
+    case COL_A_MAX_LAG:
+      sqlite3_result_int(ctx, c->max_lag);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int periodogramaColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cursor_t *c = (cursor_t *) cur;
+  const linha_t *l = &c->linhas[c->j];
+
+  switch (col) {
+    case COL_P_DEZENA:
+      sqlite3_result_int(ctx, l->dezena);
+      break;
+    case COL_P_K:
+      sqlite3_result_int(ctx, l->k);
+      break;
+    case COL_P_FREQUENCIA:
+      sqlite3_result_double(ctx, (double) l->k / c->concursos);
+      break;
+    case COL_P_PERIODO:
+      sqlite3_result_double(ctx, (double) c->concursos / l->k);
+      break;
+    case COL_P_INTENSIDADE:
+      sqlite3_result_double(ctx, l->valor);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int xRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((cursor_t *) cur)->j + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_autocorrelacao = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  xConnect,
+  xBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  xOpen,
+  xClose,
+  xFilter,
+  xNext,
+  xEof,
+  autocorrelacaoColumn,
+  xRowid,
+};
+
+static sqlite3_module modulo_periodograma = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  xConnect,
+  xBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  xOpen,
+  xClose,
+  xFilter,
+  xNext,
+  xEof,
+  periodogramaColumn,
+  xRowid,
+};
+
+enum colunas_sequencias {
+  COL_S_INICIO = 0, COL_S_FIM, COL_S_COMPRIMENTO, COL_S_ABERTA,
+  COL_S_FONTE, COL_S_ORDEM, COL_S_FLAG
+};
+
+typedef struct cursor_sequencias_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt;
+  sqlite3_value *inicio, *fim;    /* valores de "ordem" nos extremos da sequência */
+  sqlite3_int64 comprimento;
+  sqlite3_int64 rowid;
+  int aberta;                     /* sequência ainda em curso no final da fonte */
+  int eof;
+}
+cursor_sequencias_t;
+
+static int sequenciasConnect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  tabela_t *t;
+  int rc;
+
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(inicio, fim, comprimento INTEGER," \
+    " aberta INTEGER, fonte HIDDEN, ordem HIDDEN, flag HIDDEN)");
+  if (rc != SQLITE_OK) return rc;
+  // executa consultas arbitrárias, portanto somente em requisições diretas
+#ifdef SQLITE_VTAB_DIRECTONLY
+  sqlite3_vtab_config(db, SQLITE_VTAB_DIRECTONLY);
+#endif
+
+  t = sqlite3_malloc(sizeof(tabela_t));
+  if (!t) return SQLITE_NOMEM;
+  memset(t, 0, sizeof(tabela_t));
+  t->db = db;
+  *ppVtab = &t->base;
+  return SQLITE_OK;
+}
+
+/* os três argumentos são obrigatórios e repassados na ordem das colunas */
+static int sequenciasBestIndex(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  int j, args[3] = { -1, -1, -1 };
+
+  for (j = 0; j < info->nConstraint; ++j) {
+    const struct sqlite3_index_constraint *c = &info->aConstraint[j];
+    if (c->op != SQLITE_INDEX_CONSTRAINT_EQ || c->iColumn < COL_S_FONTE) continue;
+    if (!c->usable) return SQLITE_CONSTRAINT;
+    args[c->iColumn - COL_S_FONTE] = j;
+  }
+  for (j = 0; j < 3; ++j) {
+    if (args[j] < 0) {
+      sqlite3_free(vtab->zErrMsg);
+      vtab->zErrMsg = sqlite3_mprintf("sequencias requer fonte, ordem e flag");
+      return SQLITE_ERROR;
+    }
+    info->aConstraintUsage[args[j]].argvIndex = j + 1;
+    info->aConstraintUsage[args[j]].omit = 1;
+  }
+  info->estimatedRows = 1000;
+  info->estimatedCost = 10000;
+  return SQLITE_OK;
+}
+
+static int sequenciasOpen(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  cursor_sequencias_t *c = sqlite3_malloc(sizeof(cursor_sequencias_t));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(cursor_sequencias_t));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static void sequenciasLimpa(cursor_sequencias_t *c)
+{
+  sqlite3_value_free(c->inicio);
+  sqlite3_value_free(c->fim);
+  c->inicio = c->fim = NULL;
+  c->comprimento = 0;
+}
+
+static int sequenciasClose(sqlite3_vtab_cursor *cur)
+{
+  cursor_sequencias_t *c = (cursor_sequencias_t *) cur;
+  sequenciasLimpa(c);
+  sqlite3_finalize(c->stmt);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/* valor lógico do flag, nulo equivalendo a falso */
+static int verdadeiro(sqlite3_value *v)
+{
+  switch (sqlite3_value_numeric_type(v)) {
+    case SQLITE_INTEGER: return sqlite3_value_int64(v) != 0;
+    case SQLITE_NULL: return 0;
+    default: return sqlite3_value_double(v) != 0;
+  }
+}
+
+/*
+ * Avança pelas linhas da fonte até completar a próxima sequência de flags
+ * verdadeiros, encerrada por um flag falso ou pelo final da fonte.
+*/
+static int sequenciasNext(sqlite3_vtab_cursor *cur)
+{
+  cursor_sequencias_t *c = (cursor_sequencias_t *) cur;
+  int rc;
+
+  sequenciasLimpa(c);
+  if (c->aberta || !c->stmt) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  while ((rc = sqlite3_step(c->stmt)) == SQLITE_ROW) {
+    if (verdadeiro(sqlite3_column_value(c->stmt, 1))) {
+      sqlite3_value *v = sqlite3_value_dup(sqlite3_column_value(c->stmt, 0));
+      if (!v) return SQLITE_NOMEM;
+      if (c->comprimento++ == 0) {
+        c->inicio = v;
+      } else {
+        sqlite3_value_free(c->fim);
+        c->fim = v;
+      }
+    } else if (c->comprimento > 0) {
+      break;
+    }
+  }
+  if (rc == SQLITE_DONE) {
+    c->aberta = c->comprimento > 0;
+    c->eof = !c->aberta;
+  } else if (rc != SQLITE_ROW) {
+    sqlite3_free(cur->pVtab->zErrMsg);
+    cur->pVtab->zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(sqlite3_db_handle(c->stmt)));
+    return rc;
+  }
+  ++c->rowid;
+  return SQLITE_OK;
+}
+
+/*
+ * A fonte é o nome de uma tabela ou visão, ou uma consulta se contiver
+ * espaços, enquanto "ordem" e "flag" são expressões SQL sobre suas colunas.
+*/
+static int sequenciasFilter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  cursor_sequencias_t *c = (cursor_sequencias_t *) cur;
+  tabela_t *t = (tabela_t *) cur->pVtab;
+  const char *fonte = (const char *) sqlite3_value_text(argv[0]);
+  const char *ordem = (const char *) sqlite3_value_text(argv[1]);
+  const char *flag = (const char *) sqlite3_value_text(argv[2]);
+  char *sql;
+  int rc;
+
+  sequenciasLimpa(c);
+  sqlite3_finalize(c->stmt);
+  c->stmt = NULL;
+  c->aberta = c->eof = 0;
+  c->rowid = 0;
+  if (!fonte || !ordem || !flag) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  sql = strpbrk(fonte, " \t\n")
+    ? sqlite3_mprintf("SELECT %s, %s FROM (%s) ORDER BY 1", ordem, flag, fonte)
+    : sqlite3_mprintf("SELECT %s, %s FROM \"%w\" ORDER BY 1", ordem, flag, fonte);
+  if (!sql) return SQLITE_NOMEM;
+  rc = sqlite3_prepare_v2(t->db, sql, -1, &c->stmt, NULL);
+  sqlite3_free(sql);
+  if (rc != SQLITE_OK) {
+    sqlite3_free(t->base.zErrMsg);
+    t->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(t->db));
+    return rc;
+  }
+  c->rowid = 0;
+  return sequenciasNext(cur);
+}
+
+static int sequenciasEof(sqlite3_vtab_cursor *cur)
+{
+  return ((cursor_sequencias_t *) cur)->eof;
+}
+
+static int sequenciasColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int col)
+{
+  cursor_sequencias_t *c = (cursor_sequencias_t *) cur;
+
+  switch (col) {
+    case COL_S_INICIO:
+      sqlite3_result_value(ctx, c->inicio);
+      break;
+    case COL_S_FIM:
+      sqlite3_result_value(ctx, c->fim ? c->fim : c->inicio);
+      break;
+    case COL_S_COMPRIMENTO:
+      sqlite3_result_int64(ctx, c->comprimento);
+      break;
+    case COL_S_ABERTA:
+      sqlite3_result_int(ctx, c->aberta);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int sequenciasRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid)
+{
+  *rowid = ((cursor_sequencias_t *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module modulo_sequencias = {
+  0,              /* iVersion */
+  0,              /* xCreate: eponymous-only */
+  sequenciasConnect,
+  sequenciasBestIndex,
+  xDisconnect,
+  0,              /* xDestroy */
+  sequenciasOpen,
+  sequenciasClose,
+  sequenciasFilter,
+  sequenciasNext,
+  sequenciasEof,
+  sequenciasColumn,
+  sequenciasRowid,
+};
+
+typedef struct histograma_s
+{
+  sqlite3_int64 *quantidades;     /* sequências encerradas por comprimento */
+  sqlite3_int64 atual;            /* comprimento da sequência em curso */
+  sqlite3_int64 sequencias;
+  int capacidade;
+}
+histograma_t;
+
+/* acumula os flags na ordem das linhas agregadas */
+static void histograma_sequenciasStep(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  histograma_t *h = sqlite3_aggregate_context(ctx, sizeof(histograma_t));
+
+  if (!h) {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  if (verdadeiro(argv[0])) {
+    ++h->atual;
+    return;
+  }
+  if (h->atual == 0) return;
+  if (h->atual >= h->capacidade) {
+    sqlite3_int64 n = h->capacidade ? h->capacidade : 64, *p;
+    while (n <= h->atual) n *= 2;
+    p = sqlite3_realloc64(h->quantidades, n * sizeof(sqlite3_int64));
+    if (!p) {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    memset(p + h->capacidade, 0, (n - h->capacidade) * sizeof(sqlite3_int64));
+    h->quantidades = p;
+    h->capacidade = (int) n;
+  }
+  ++h->quantidades[h->atual];
+  ++h->sequencias;
+  h->atual = 0;
+}
+
+/*
+ *   histograma_sequencias(flag) -> '{"sequencias":S,"maior":M,
+ *     "histograma":[[comprimento,quantidade],...],"aberta":A}'
+ *
+ * onde o histograma e o maior comprimento são das sequências encerradas e
+ * "aberta" é o comprimento da sequência em curso na última linha, na ordem
+ * de agregação das linhas, i.e.; via "ORDER BY" na própria agregação.
+*/
+static void histograma_sequenciasFinal(sqlite3_context *ctx)
+{
+  histograma_t *h = sqlite3_aggregate_context(ctx, 0);
+  sqlite3_str *s;
+  int i, maior = 0, primeira = 1;
+
+  if (!h) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  for (i = h->capacidade - 1; i > 0 && !maior; --i) if (h->quantidades[i]) maior = i;
+  s = sqlite3_str_new(sqlite3_context_db_handle(ctx));
+  sqlite3_str_appendf(s, "{\"sequencias\":%lld,\"maior\":%d,\"histograma\":[",
+    h->sequencias, maior);
+  for (i = 1; i <= maior; ++i) {
+    if (!h->quantidades[i]) continue;
+    sqlite3_str_appendf(s, primeira ? "[%d,%lld]" : ",[%d,%lld]", i, h->quantidades[i]);
+    primeira = 0;
+  }
+  sqlite3_str_appendf(s, "],\"aberta\":%lld}", h->atual);
+  sqlite3_free(h->quantidades);
+  if (sqlite3_str_errcode(s)) {
+    sqlite3_free(sqlite3_str_finish(s));
+    sqlite3_result_error_nomem(ctx);
+  } else {
+    sqlite3_result_text(ctx, sqlite3_str_finish(s), -1, sqlite3_free);
+  }
+}
+
+int sqlite3_series_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  int rc;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  rc = sqlite3_create_module(db, "autocorrelacao", &modulo_autocorrelacao, NULL);
+  if (rc == SQLITE_OK) {
+    // o ponteiro não nulo apenas distingue o periodograma em xConnect
+    rc = sqlite3_create_module(db, "periodograma", &modulo_periodograma,
+      (void *) &modulo_periodograma);
+  }
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_module(db, "sequencias", &modulo_sequencias, NULL);
+  }
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_create_function(db, "histograma_sequencias", 1,
+      SQLITE_UTF8 | SQLITE_INNOCUOUS, NULL, NULL,
+      histograma_sequenciasStep, histograma_sequenciasFinal);
+  }
+  return rc;
+}
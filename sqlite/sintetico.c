@@ -0,0 +1,373 @@
+/*
+ * Gerador de série histórica sintética de concursos da Mega-Sena:
+ *
+ * Cria um novo db com o esquema de "sql/monta.sql" e o preenche com a
+ * quantidade requisitada de concursos válidos, i.e.; seis números distintos
+ * e ordenados, datas no calendário de sorteios às quartas-feiras e sábados e
+ * indicador de acumulação simulado conforme a arrecadação, que cresce a cada
+ * concurso acumulado, de modo que toda a série é determinada pela semente.
+ *
+ * As tabelas derivadas "dezenas_juntadas", "dezenas_sorteadas", "sugestoes"
+ * e "ganhadores" são preenchidas diretamente com os mesmos valores que os
+ * triggers produziriam, que são suspensos durante a carga assim como o índice
+ * "ndx", pois o trigger de inserção consulta a view "info_dezenas" e tem
+ * custo proporcional ao tamanho da série, inviabilizando 10⁵ a 10⁷ concursos.
+ * Os registros são inseridos via "prepared statements" em transações de
+ * tamanho fixo.
+ *
+ * Se a quantidade de concursos excede a capacidade do calendário até o ano
+ * 9999, limite das funções de data do SQLite, então vários concursos são
+ * sorteados na mesma data.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc sintetico.c -Wall -O2 -lsqlite3 -lm -o sintetico
+ *
+ * Uso:
+ *
+ *    sintetico [-n concursos] [-s semente] [-b lote] [-m esquema] [-S] db
+ *
+ *    -n  quantidade de concursos (default 100000)
+ *    -s  semente do gerador de números pseudo-aleatórios (default 1)
+ *    -b  quantidade de concursos por transação (default 10000)
+ *    -m  script do esquema do db (default sql/monta.sql)
+ *    -S  não preenche a tabela "sugestoes"
+*/
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#define N_DEZENAS 60
+#define N_SORTEIO 6
+
+/* quantidade de combinações distintas de 6 números: C(60, 6) */
+#define N_COMBINACOES 50063860.0
+
+/* valor da aposta simples */
+#define PRECO 4.5
+
+/* dia juliano de 1996-03-11, data do primeiro concurso */
+#define DIA_INICIAL 2450154
+
+/* dia juliano de 9999-12-31 */
+#define DIA_FINAL 5373484
+
+static const char *UF[] = {
+  "AC", "AL", "AM", "AP", "BA", "CE", "DF", "ES", "GO", "MA", "MG", "MS", "MT",
+  "PA", "PB", "PE", "PI", "PR", "RJ", "RN", "RO", "RR", "RS", "SC", "SE", "SP",
+  "TO"
+};
+
+/* estado do gerador "xorshift64*" */
+static uint64_t estado;
+
+static uint64_t aleatorio(void)
+{
+  estado ^= estado >> 12;
+  estado ^= estado << 25;
+  estado ^= estado >> 27;
+  return estado * 2685821657736338717ULL;
+}
+
+/* número pseudo-aleatório uniforme em [0; 1) */
+static double uniforme(void)
+{
+  return (aleatorio() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* número pseudo-aleatório com distribuição de Poisson de média "lambda" */
+static int poisson(double lambda)
+{
+  if (lambda < 30) {
+    double l = exp(-lambda), p = 1;
+    int k = -1;
+    do {
+      ++k;
+      p *= uniforme();
+    } while (p > l);
+    return k;
+  } else {
+    // aproximação normal via Box-Muller
+    double z = sqrt(-2 * log(1 - uniforme())) * cos(2 * M_PI * uniforme());
+    int k = (int) floor(lambda + z * sqrt(lambda) + 0.5);
+    return k < 0 ? 0 : k;
+  }
+}
+
+/*
+ * Formata a data correspondente ao dia juliano como YYYY-MM-DD, conforme o
+ * algoritmo de conversão do calendário gregoriano de Fliegel & Van Flandern.
+*/
+static void formata_data(int jd, char *buf)
+{
+  int l = jd + 68569, n, i, j, d, m, y;
+  n = 4 * l / 146097;
+  l = l - (146097 * n + 3) / 4;
+  i = 4000 * (l + 1) / 1461001;
+  l = l - 1461 * i / 4 + 31;
+  j = 80 * l / 2447;
+  d = l - 2447 * j / 80;
+  l = j / 11;
+  m = j + 2 - 12 * l;
+  y = 100 * (n - 49) + i + l;
+  sprintf(buf, "%04d-%02d-%02d", y, m, d);
+}
+
+/* próximo dia de sorteio, i.e.; quarta-feira ou sábado, após o dia juliano */
+static int proximo_sorteio(int jd)
+{
+  do ++jd; while ((jd % 7) != 2 && (jd % 7) != 5);
+  return jd;
+}
+
+/* sorteio de seis números distintos em ordem crescente */
+static void sorteia(int *dezenas)
+{
+  int urna[N_DEZENAS], j, k, t;
+
+  for (j = 0; j < N_DEZENAS; ++j) urna[j] = j + 1;
+  for (j = 0; j < N_SORTEIO; ++j) {
+    k = j + (int) (aleatorio() % (N_DEZENAS - j));
+    t = urna[j]; urna[j] = urna[k]; urna[k] = t;
+  }
+  for (j = 1; j < N_SORTEIO; ++j) {
+    for (t = urna[j], k = j; k > 0 && urna[k-1] > t; --k) urna[k] = urna[k-1];
+    urna[k] = t;
+  }
+  memcpy(dezenas, urna, N_SORTEIO * sizeof(int));
+}
+
+static char *le_arquivo(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  char *z = NULL;
+  long n;
+
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  n = ftell(f);
+  rewind(f);
+  z = malloc(n + 1);
+  if (z && fread(z, 1, n, f) == (size_t) n) {
+    z[n] = 0;
+  } else {
+    free(z);
+    z = NULL;
+  }
+  fclose(f);
+  return z;
+}
+
+static int falha(sqlite3 *db, const char *contexto)
+{
+  fprintf(stderr, "%s: %s\n", contexto, sqlite3_errmsg(db));
+  sqlite3_close(db);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *esquema = "sql/monta.sql", *dbpath;
+  sqlite3 *db;
+  sqlite3_stmt *concurso, *juntadas, *sorteadas, *sugestao, *ganhador;
+  char *sql, data[32], **triggers = NULL;
+  long n = 100000, lote = 10000, c;
+  int sem_sugestoes = 0, num_triggers = 0, opt, j, k;
+  int frequencia[N_DEZENAS+1], ultimo[N_DEZENAS+1], dezenas[N_SORTEIO];
+  int dia, por_dia, no_dia;
+  double arrecadacao, acumulado_valor = 0, apostas;
+
+  estado = 1;
+  while ((opt = getopt(argc, argv, "n:s:b:m:S")) != -1) {
+    switch (opt) {
+      case 'n': n = atol(optarg); break;
+      case 's': estado = strtoull(optarg, NULL, 10); break;
+      case 'b': lote = atol(optarg); break;
+      case 'm': esquema = optarg; break;
+      case 'S': sem_sugestoes = 1; break;
+      default:
+        fprintf(stderr, "uso: %s [-n concursos] [-s semente] [-b lote]" \
+          " [-m esquema] [-S] db\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1 || n < 1 || lote < 1) {
+    fprintf(stderr, "uso: %s [-n concursos] [-s semente] [-b lote]" \
+      " [-m esquema] [-S] db\n", argv[0]);
+    return 1;
+  }
+  dbpath = argv[optind];
+  if (access(dbpath, F_OK) == 0) {
+    fprintf(stderr, "%s: arquivo preexistente\n", dbpath);
+    return 1;
+  }
+  // o gerador "xorshift" não admite estado nulo
+  estado = estado * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+  if (estado == 0) estado = 1;
+
+  if (!(sql = le_arquivo(esquema))) {
+    fprintf(stderr, "%s: ilegível\n", esquema);
+    return 1;
+  }
+  if (sqlite3_open(dbpath, &db) != SQLITE_OK) return falha(db, dbpath);
+  if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK) return falha(db, esquema);
+  free(sql);
+
+  // suspende os triggers e o índice durante a carga
+  {
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE type == 'trigger'",
+      -1, &stmt, NULL);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      triggers = realloc(triggers, (num_triggers + 1) * sizeof(char *));
+      triggers[num_triggers++] = sqlite3_mprintf("%s", sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+  }
+  sqlite3_exec(db, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;" \
+    "DROP TRIGGER IF EXISTS on_concursos_insert;" \
+    "DROP TRIGGER IF EXISTS on_concursos_delete;" \
+    "DROP INDEX IF EXISTS ndx;", NULL, NULL, NULL);
+
+  if (sqlite3_prepare_v2(db, "INSERT INTO concursos (concurso, data_sorteio," \
+        " dezena1, dezena2, dezena3, dezena4, dezena5, dezena6," \
+        " ganhadores_sena, ganhadores_quina, ganhadores_quadra, rateio_sena," \
+        " rateio_quina, rateio_quadra, arrecadacao_total, estimativa_premio," \
+        " valor_acumulado, acumulado) VALUES" \
+        " (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)", -1, &concurso, NULL)
+      || sqlite3_prepare_v2(db, "INSERT INTO dezenas_juntadas (concurso, dezenas)" \
+        " VALUES (?,?)", -1, &juntadas, NULL)
+      || sqlite3_prepare_v2(db, "INSERT INTO dezenas_sorteadas (concurso, dezena)" \
+        " VALUES (?,?)", -1, &sorteadas, NULL)
+      || sqlite3_prepare_v2(db, "INSERT INTO sugestoes (concurso, dezena)" \
+        " VALUES (?,?)", -1, &sugestao, NULL)
+      || sqlite3_prepare_v2(db, "INSERT INTO ganhadores (concurso, cidade, uf)" \
+        " VALUES (?,NULL,?)", -1, &ganhador, NULL)) {
+    return falha(db, "prepare");
+  }
+
+  // concursos por dia de sorteio para que a última data não exceda 9999-12-31
+  por_dia = (int) ceil(n / ((DIA_FINAL - DIA_INICIAL) * 2.0 / 7.0));
+  dia = DIA_INICIAL;
+  no_dia = 0;
+  formata_data(dia, data);
+
+  memset(frequencia, 0, sizeof(frequencia));
+  memset(ultimo, 0, sizeof(ultimo));
+  arrecadacao = 2.0e7 * PRECO;
+
+  sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+  for (c = 1; c <= n; ++c) {
+    sqlite3_int64 mask = 0;
+    int sena, quina, quadra, acumulado;
+    double premio;
+
+    if (++no_dia > por_dia) {
+      dia = proximo_sorteio(dia);
+      formata_data(dia, data);
+      no_dia = 1;
+    }
+
+    sorteia(dezenas);
+
+    // quantidade de ganhadores conforme a quantidade de apostas simples
+    apostas = arrecadacao / PRECO;
+    sena = poisson(apostas / N_COMBINACOES);
+    quina = poisson(apostas * 324 / N_COMBINACOES);     // C(6,5) * C(54,1)
+    quadra = poisson(apostas * 21465 / N_COMBINACOES);  // C(6,4) * C(54,2)
+    acumulado = (sena == 0);
+    premio = arrecadacao * 0.43;
+
+    sqlite3_bind_int64(concurso, 1, c);
+    sqlite3_bind_text(concurso, 2, data, 10, SQLITE_STATIC);
+    for (j = 0; j < N_SORTEIO; ++j) {
+      sqlite3_bind_int(concurso, 3 + j, dezenas[j]);
+      mask |= (sqlite3_int64) 1 << (dezenas[j] - 1);
+    }
+    sqlite3_bind_int(concurso, 9, sena);
+    sqlite3_bind_int(concurso, 10, quina);
+    sqlite3_bind_int(concurso, 11, quadra);
+    sqlite3_bind_double(concurso, 12, sena ? (premio * 0.35 + acumulado_valor) / sena : 0);
+    sqlite3_bind_double(concurso, 13, quina ? premio * 0.19 / quina : 0);
+    sqlite3_bind_double(concurso, 14, quadra ? premio * 0.19 / quadra : 0);
+    sqlite3_bind_double(concurso, 15, floor(arrecadacao * 100) / 100);
+    acumulado_valor = acumulado ? acumulado_valor + premio * 0.35 : 0;
+    // prêmios acumulados atraem mais apostas no concurso seguinte
+    arrecadacao = (acumulado ? arrecadacao * 1.3 : 2.0e7 * PRECO)
+                  * (0.9 + 0.2 * uniforme());
+    sqlite3_bind_double(concurso, 16, floor((acumulado_valor + arrecadacao * 0.43 * 0.35) / 1e5) * 1e5);
+    sqlite3_bind_double(concurso, 17, floor(acumulado_valor * 100) / 100);
+    sqlite3_bind_int(concurso, 18, acumulado);
+    if (sqlite3_step(concurso) != SQLITE_DONE) return falha(db, "concursos");
+    sqlite3_reset(concurso);
+
+    sqlite3_bind_int64(juntadas, 1, c);
+    sqlite3_bind_int64(juntadas, 2, mask);
+    sqlite3_step(juntadas);
+    sqlite3_reset(juntadas);
+
+    sqlite3_bind_int64(sorteadas, 1, c);
+    for (j = 0; j < N_SORTEIO; ++j) {
+      sqlite3_bind_int(sorteadas, 2, dezenas[j]);
+      sqlite3_step(sorteadas);
+      sqlite3_reset(sorteadas);
+      frequencia[dezenas[j]] += 1;
+      ultimo[dezenas[j]] = c;
+    }
+
+    // mesmo critério do trigger "on_concursos_insert" via "info_dezenas"
+    if (!sem_sugestoes) {
+      sqlite3_bind_int64(sugestao, 1, c);
+      for (k = 1; k <= N_DEZENAS; ++k) {
+        if (frequencia[k] > 0 && frequencia[k] < c / 10.0 && c - ultimo[k] >= 10) {
+          sqlite3_bind_int(sugestao, 2, k);
+          sqlite3_step(sugestao);
+          sqlite3_reset(sugestao);
+        }
+      }
+    }
+
+    sqlite3_bind_int64(ganhador, 1, c);
+    for (j = 0; j < sena; ++j) {
+      sqlite3_bind_text(ganhador, 2, UF[aleatorio() % (sizeof(UF)/sizeof(UF[0]))],
+        2, SQLITE_STATIC);
+      sqlite3_step(ganhador);
+      sqlite3_reset(ganhador);
+    }
+
+    if (c % lote == 0) {
+      sqlite3_exec(db, "COMMIT; BEGIN", NULL, NULL, NULL);
+      fprintf(stderr, "\r%ld concursos", c);
+    }
+  }
+  sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+  fprintf(stderr, "\r%ld concursos\n", n);
+
+  sqlite3_finalize(concurso);
+  sqlite3_finalize(juntadas);
+  sqlite3_finalize(sorteadas);
+  sqlite3_finalize(sugestao);
+  sqlite3_finalize(ganhador);
+
+  // restaura o índice e os triggers
+  if (sqlite3_exec(db, "CREATE INDEX ndx ON dezenas_sorteadas" \
+        " (concurso COLLATE binary, dezena COLLATE binary)", NULL, NULL, NULL)) {
+    return falha(db, "ndx");
+  }
+  for (j = 0; j < num_triggers; ++j) {
+    if (sqlite3_exec(db, triggers[j], NULL, NULL, NULL)) return falha(db, "triggers");
+    sqlite3_free(triggers[j]);
+  }
+  free(triggers);
+  sqlite3_exec(db, "PRAGMA journal_mode = DELETE", NULL, NULL, NULL);
+
+  return sqlite3_close(db) != SQLITE_OK;
+}
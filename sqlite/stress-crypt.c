@@ -0,0 +1,226 @@
+/*
+ * Teste de concorrência das funções ENC e DEC da extensão "crypt":
+ *
+ * Executa N threads simultâneas, cada uma com sua própria conexão, seu
+ * próprio método criptográfico, alternando entre os disponíveis, e sua
+ * própria chave, verificando a cada iteração que
+ *
+ *    DEC(chave, ENC(chave, x)) IS x
+ *
+ * para textos e BLOBs pseudo-aleatórios, curtos e longos, inclusive com NULs,
+ * que GET_CRYPT() permanece o método da conexão e que ENC de um texto fixo
+ * coincide com o valor calculado previamente numa conexão isolada com o mesmo
+ * método e a mesma chave, detectando engines compartilhados entre conexões.
+ *
+ * Dependências:
+ *
+ *    pacote libsqlite3-dev
+ *
+ * Compilação:
+ *
+ *    gcc stress-crypt.c -Wall -O2 -pthread -lsqlite3 -o stress-crypt
+ *
+ * Uso:
+ *
+ *    stress-crypt [-t threads] [-i iterações] [-l extensão]
+ *
+ *    -t  quantidade de threads (default 8)
+ *    -i  quantidade de iterações por thread (default 20000)
+ *    -l  extensão a carregar (default sqlite/crypt.so)
+ *
+ * Resultados em CSV: thread, método, verificações e falhas. O status de
+ * saída é não nulo se houve alguma falha.
+*/
+#include <sqlite3.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_THREADS 256
+
+/* comprimento máximo dos textos, acima do buffer de 256 bytes de ENC */
+#define MAX_TEXTO 1024
+
+static const char *METODOS[] = \
+  { "naive", "usual", "single", "alternate", "twin", "both" };
+
+#define NUM_METODOS (sizeof(METODOS) / sizeof(METODOS[0]))
+
+/* texto fixo cifrado por todas as threads e comparado à referência */
+static const char *FIXO = "Mega-Sena 04 05 30 33 41 52";
+
+static const char *extensao = "sqlite/crypt.so";
+static int iteracoes = 20000;
+
+typedef struct tarefa_s
+{
+  pthread_t id;
+  int numero;
+  const char *metodo;
+  char chave[32];
+  char *referencia;     /* ENC(chave, FIXO) calculado isoladamente */
+  sqlite3_int64 verificacoes;
+  sqlite3_int64 falhas;
+  char *erro;
+}
+tarefa_t;
+
+/* conexão com a extensão carregada e o método configurado */
+static sqlite3 *conecta(const char *metodo, char **erro)
+{
+  sqlite3 *db;
+  char *sql, *err;
+
+  if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+    *erro = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+    sqlite3_close(db);
+    return NULL;
+  }
+  sqlite3_enable_load_extension(db, 1);
+  if (sqlite3_load_extension(db, extensao, NULL, &err) != SQLITE_OK) {
+    *erro = sqlite3_mprintf("%s: %s", extensao, err);
+    sqlite3_free(err);
+    sqlite3_close(db);
+    return NULL;
+  }
+  sql = sqlite3_mprintf("SELECT set_crypt(%Q)", metodo);
+  if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+    *erro = sqlite3_mprintf("%s", err);
+    sqlite3_free(err);
+    sqlite3_close(db);
+    db = NULL;
+  }
+  sqlite3_free(sql);
+  return db;
+}
+
+/* ENC(chave, FIXO) como texto hexadecimal */
+static char *cifra_fixo(sqlite3 *db, const char *chave)
+{
+  sqlite3_stmt *stmt;
+  char *r = NULL;
+
+  if (sqlite3_prepare_v2(db, "SELECT hex(enc(?, ?))", -1, &stmt, NULL) != SQLITE_OK) return NULL;
+  sqlite3_bind_text(stmt, 1, chave, -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, FIXO, -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    r = sqlite3_mprintf("%s", sqlite3_column_text(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return r;
+}
+
+static void *executa(void *arg)
+{
+  tarefa_t *t = (tarefa_t *) arg;
+  sqlite3_stmt *ida, *conferencia;
+  unsigned char texto[MAX_TEXTO];
+  unsigned int semente = 0x9E3779B9u * (t->numero + 1);
+  sqlite3 *db;
+  int j, n, k;
+
+  if (!(db = conecta(t->metodo, &t->erro))) return NULL;
+  sqlite3_prepare_v2(db, "SELECT dec(?1, enc(?1, ?2)) IS ?2", -1, &ida, NULL);
+  sqlite3_prepare_v2(db, "SELECT get_crypt() == ?1 AND hex(enc(?2, ?3)) == ?4",
+    -1, &conferencia, NULL);
+  sqlite3_bind_text(ida, 1, t->chave, -1, SQLITE_STATIC);
+  sqlite3_bind_text(conferencia, 1, t->metodo, -1, SQLITE_STATIC);
+  sqlite3_bind_text(conferencia, 2, t->chave, -1, SQLITE_STATIC);
+  sqlite3_bind_text(conferencia, 3, FIXO, -1, SQLITE_STATIC);
+  sqlite3_bind_text(conferencia, 4, t->referencia, -1, SQLITE_STATIC);
+
+  for (j = 0; j < iteracoes; ++j) {
+    // comprimentos curtos na maioria, longos a cada 8 iterações
+    n = rand_r(&semente) % ((j & 7) ? 64 : MAX_TEXTO);
+    if (j & 1) {
+      for (k = 0; k < n; ++k) texto[k] = (unsigned char) rand_r(&semente);
+      sqlite3_bind_blob(ida, 2, texto, n, SQLITE_STATIC);
+    } else {
+      for (k = 0; k < n; ++k) texto[k] = ' ' + rand_r(&semente) % 95;
+      sqlite3_bind_text(ida, 2, (char *) texto, n, SQLITE_STATIC);
+    }
+    if (sqlite3_step(ida) != SQLITE_ROW || sqlite3_column_int(ida, 0) != 1) ++t->falhas;
+    sqlite3_reset(ida);
+    ++t->verificacoes;
+    if (j % 64 == 0) {
+      if (sqlite3_step(conferencia) != SQLITE_ROW
+          || sqlite3_column_int(conferencia, 0) != 1) ++t->falhas;
+      sqlite3_reset(conferencia);
+      ++t->verificacoes;
+    }
+  }
+  sqlite3_finalize(ida);
+  sqlite3_finalize(conferencia);
+  sqlite3_close(db);
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  tarefa_t *tarefas;
+  int threads = 8, opt, j, status = 0;
+
+  while ((opt = getopt(argc, argv, "t:i:l:")) != -1) {
+    switch (opt) {
+      case 't':
+        threads = atoi(optarg);
+        break;
+      case 'i':
+        iteracoes = atoi(optarg);
+        break;
+      case 'l':
+        extensao = optarg;
+        break;
+      default:
+        fprintf(stderr, "uso: %s [-t threads] [-i iterações] [-l extensão]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (threads < 1) threads = 1;
+  if (threads > MAX_THREADS) threads = MAX_THREADS;
+  if (iteracoes < 1) iteracoes = 1;
+  if (!sqlite3_threadsafe()) {
+    fprintf(stderr, "libsqlite3 compilada sem suporte a threads\n");
+    return 1;
+  }
+
+  tarefas = calloc(threads, sizeof(tarefa_t));
+  if (!tarefas) return 1;
+
+  // referências calculadas sequencialmente, uma conexão por thread
+  for (j = 0; j < threads; ++j) {
+    tarefa_t *t = &tarefas[j];
+    sqlite3 *db;
+    t->numero = j;
+    t->metodo = METODOS[j % NUM_METODOS];
+    snprintf(t->chave, sizeof(t->chave), "chave %d da thread", j * 7919);
+    if (!(db = conecta(t->metodo, &t->erro))) {
+      fprintf(stderr, "%s\n", t->erro);
+      return 1;
+    }
+    t->referencia = cifra_fixo(db, t->chave);
+    sqlite3_close(db);
+  }
+
+  for (j = 0; j < threads; ++j) {
+    pthread_create(&tarefas[j].id, NULL, executa, &tarefas[j]);
+  }
+  printf("thread,metodo,verificacoes,falhas\n");
+  for (j = 0; j < threads; ++j) {
+    tarefa_t *t = &tarefas[j];
+    pthread_join(t->id, NULL);
+    if (t->erro) {
+      printf("%d,%s,0,\"%s\"\n", j, t->metodo, t->erro);
+      status = 1;
+    } else {
+      printf("%d,%s,%lld,%lld\n", j, t->metodo, t->verificacoes, t->falhas);
+      if (t->falhas) status = 1;
+    }
+    sqlite3_free(t->erro);
+    sqlite3_free(t->referencia);
+  }
+  free(tarefas);
+  return status;
+}